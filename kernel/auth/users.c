@@ -18,11 +18,8 @@
 #define USER_FLAG_ADMIN 0x02
 #define USER_FLAG_LOCKED 0x04
 
-/* Permission bits (like Unix) */
-#define PERM_READ 0x04
-#define PERM_WRITE 0x02
-#define PERM_EXEC 0x01
-
+/* Permission bits (like Unix; access types PERM_READ/WRITE/EXEC are
+ * in kernel.h so the filesystem can pass them) */
 #define PERM_OWNER_R 0x100
 #define PERM_OWNER_W 0x080
 #define PERM_OWNER_X 0x040
@@ -187,6 +184,7 @@ int user_login(const char *username, const char *password) {
   strcpy(current_session.username, username);
   current_session.is_root = (user->uid == 0);
 
+  fs_perm_flush(); /* cached decisions belong to the old identity */
   secmon_log("User logged in", 0);
 
   return 0;
@@ -198,6 +196,7 @@ int user_login(const char *username, const char *password) {
 void user_logout(void) {
   secmon_log("User logged out", 0);
   memset(&current_session, 0, sizeof(current_session));
+  fs_perm_flush();
 }
 
 /*
@@ -344,6 +343,7 @@ int user_switch(const char *username, const char *password) {
     current_session.gid = user->gid;
     strcpy(current_session.username, username);
     current_session.is_root = (user->uid == 0);
+    fs_perm_flush();
 
     kprintf("Switched to user '%s'\n", username);
     return 0;
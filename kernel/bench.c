@@ -0,0 +1,168 @@
+/*
+ * NanoSec OS - Microbenchmark Suite
+ * ===================================
+ * A registry of small in-kernel benchmarks behind the `bench`
+ * command, so regressions in the allocator, string routines,
+ * checksum, filesystem and graphics paths show up as numbers
+ * instead of feel. Each benchmark runs several times; we report the
+ * min and median cycles per op plus ops/sec from the TSC clock.
+ */
+
+#include "kernel.h"
+#include "net/network.h"
+
+#define BENCH_RUNS 5
+#define BENCH_BUF_SIZE 32768
+
+static uint8_t bench_src[BENCH_BUF_SIZE];
+static uint8_t bench_dst[BENCH_BUF_SIZE];
+
+/* Each benchmark does a fixed batch of work and returns how many
+ * operations that was (bytes for bandwidth tests, calls otherwise) */
+typedef struct {
+  const char *name;
+  const char *unit;
+  uint32_t (*run)(void);
+} bench_t;
+
+static uint32_t bench_memset(void) {
+  for (int i = 0; i < 64; i++)
+    memset(bench_dst, i, BENCH_BUF_SIZE);
+  return 64 * BENCH_BUF_SIZE;
+}
+
+static uint32_t bench_memcpy(void) {
+  for (int i = 0; i < 64; i++)
+    memcpy(bench_dst, bench_src, BENCH_BUF_SIZE);
+  return 64 * BENCH_BUF_SIZE;
+}
+
+static uint32_t bench_kmalloc(void) {
+  static const size_t sizes[] = {16, 64, 256, 1024};
+  uint32_t ops = 0;
+  for (int round = 0; round < 64; round++) {
+    for (int s = 0; s < 4; s++) {
+      void *p = kmalloc(sizes[s]);
+      if (!p)
+        return ops;
+      kfree(p);
+      ops += 2; /* One alloc + one free */
+    }
+  }
+  return ops;
+}
+
+static uint32_t bench_checksum(void) {
+  volatile uint16_t sink = 0;
+  for (int i = 0; i < 64; i++)
+    sink ^= net_checksum(bench_src, BENCH_BUF_SIZE);
+  (void)sink;
+  return 64 * BENCH_BUF_SIZE;
+}
+
+static uint32_t bench_fs_write(void) {
+  for (int i = 0; i < 16; i++) {
+    if (fs_write("/tmp/bench.dat", (const char *)bench_src, 4096) < 0)
+      return 0;
+  }
+  return 16 * 4096;
+}
+
+static uint32_t bench_fs_read(void) {
+  if (fs_write("/tmp/bench.dat", (const char *)bench_src, 4096) < 0)
+    return 0;
+  for (int i = 0; i < 16; i++) {
+    if (fs_read("/tmp/bench.dat", (char *)bench_dst, 4096) < 0)
+      return 0;
+  }
+  return 16 * 4096;
+}
+
+static uint32_t bench_fill_rect(void) {
+  if (!gfx_mode_active())
+    return 0; /* Text-mode boot - skipped */
+  for (int i = 0; i < 32; i++)
+    gfx_fill_rect(0, 0, 320, 200, (uint8_t)(i & 0x0F));
+  return 32 * 320 * 200; /* Pixels */
+}
+
+static const bench_t benches[] = {
+    {"memset", "B/s", bench_memset},
+    {"memcpy", "B/s", bench_memcpy},
+    {"kmalloc", "op/s", bench_kmalloc},
+    {"checksum", "B/s", bench_checksum},
+    {"fs_write", "B/s", bench_fs_write},
+    {"fs_read", "B/s", bench_fs_read},
+    {"fillrect", "px/s", bench_fill_rect},
+    {NULL, NULL, NULL}};
+
+/* Insertion sort - BENCH_RUNS is tiny */
+static void sort_u32(uint32_t *v, int n) {
+  for (int i = 1; i < n; i++) {
+    uint32_t key = v[i];
+    int j = i - 1;
+    while (j >= 0 && v[j] > key) {
+      v[j + 1] = v[j];
+      j--;
+    }
+    v[j + 1] = key;
+  }
+}
+
+static void bench_one(const bench_t *b) {
+  uint32_t cycles[BENCH_RUNS];
+  uint32_t nanos[BENCH_RUNS];
+  uint32_t ops = 0;
+
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    uint64_t tns = ktime_ns();
+    uint64_t start = rdtsc();
+    ops = b->run();
+    uint64_t elapsed = rdtsc() - start;
+    tns = ktime_ns() - tns;
+    cycles[run] = (elapsed > 0xFFFFFFFFull) ? 0xFFFFFFFF : (uint32_t)elapsed;
+    nanos[run] = (tns > 0xFFFFFFFFull) ? 0xFFFFFFFF : (uint32_t)tns;
+  }
+
+  if (ops == 0) {
+    kprintf("  %s: skipped\n", b->name);
+    return;
+  }
+
+  sort_u32(cycles, BENCH_RUNS);
+  sort_u32(nanos, BENCH_RUNS);
+
+  /* Rate from the calibrated clock: ops * 1e9 / ns over the best run.
+   * With an uncalibrated TSC ktime_ns only has tick resolution and a
+   * fast batch can measure zero - report the rate as unknown then. */
+  uint32_t rate = 0;
+  if (nanos[0] > 0)
+    rate = (uint32_t)div_u64_u32((uint64_t)ops * 1000000000ull, nanos[0]);
+
+  kprintf("  %s: %d cyc/op min, %d median, ", b->name,
+          (int)(cycles[0] / ops), (int)(cycles[BENCH_RUNS / 2] / ops));
+  if (rate > 0)
+    kprintf("%d %s\n", (int)rate, b->unit);
+  else
+    kprintf("rate n/a (clock uncalibrated)\n");
+}
+
+void cmd_bench(const char *args) {
+  kprintf("\n=== Microbenchmarks (%d runs each) ===\n", BENCH_RUNS);
+
+  /* Seed the source buffer so checksum/copy read varied data */
+  for (int i = 0; i < BENCH_BUF_SIZE; i++)
+    bench_src[i] = (uint8_t)(i * 31);
+
+  int matched = 0;
+  for (int i = 0; benches[i].name; i++) {
+    if (args[0] && strcmp(args, benches[i].name) != 0)
+      continue;
+    bench_one(&benches[i]);
+    matched = 1;
+  }
+
+  if (!matched)
+    kprintf("Unknown benchmark: %s\n", args);
+  kprintf("\n");
+}
@@ -0,0 +1,143 @@
+/*
+ * NanoSec OS - Boot Stage Framework
+ * ===================================
+ * Subsystem initialization is split into critical stages (run
+ * serially before the prompt) and deferrable stages (run once the
+ * prompt is live). Every stage's duration is recorded in TSC cycles
+ * and shown by the `bootchart` command, so prompt-ready time can be
+ * tracked instead of guessed at.
+ *
+ * Durations are stored as cycles and converted at display time:
+ * early stages run before the TSC is calibrated, the bootchart
+ * command does not.
+ */
+
+#include "kernel.h"
+
+#define BOOT_MAX_STAGES 24
+
+#define STAGE_PENDING 0
+#define STAGE_DONE 1
+
+typedef struct {
+  const char *name;
+  void (*fn)(void);
+  uint64_t cycles;
+  uint8_t deferred;
+  uint8_t state;
+} boot_stage_t;
+
+static boot_stage_t stages[BOOT_MAX_STAGES];
+static int stage_count = 0;
+
+static uint64_t boot_start_tsc = 0;
+static uint64_t prompt_ready_tsc = 0;
+
+/*
+ * Run a critical stage now and record its duration
+ */
+void boot_stage_run(const char *name, void (*fn)(void)) {
+  if (!boot_start_tsc)
+    boot_start_tsc = rdtsc();
+  if (stage_count >= BOOT_MAX_STAGES) {
+    fn();
+    return;
+  }
+  boot_stage_t *s = &stages[stage_count++];
+  s->name = name;
+  s->fn = fn;
+  s->deferred = 0;
+
+  uint64_t start = rdtsc();
+  fn();
+  s->cycles = rdtsc() - start;
+  s->state = STAGE_DONE;
+}
+
+/*
+ * Register a deferrable stage; it runs from boot_run_deferred()
+ * after the prompt is up
+ */
+void boot_stage_defer(const char *name, void (*fn)(void)) {
+  if (stage_count >= BOOT_MAX_STAGES) {
+    fn(); /* No room to track it - just run it now */
+    return;
+  }
+  boot_stage_t *s = &stages[stage_count++];
+  s->name = name;
+  s->fn = fn;
+  s->deferred = 1;
+  s->cycles = 0;
+  s->state = STAGE_PENDING;
+}
+
+/*
+ * Run every pending deferred stage, in registration order. Returns
+ * how many ran, so the caller knows whether to repaint its prompt.
+ * Idempotent: later calls find nothing pending and cost a scan.
+ */
+int boot_run_deferred(void) {
+  if (!prompt_ready_tsc)
+    prompt_ready_tsc = rdtsc();
+
+  int ran = 0;
+  for (int i = 0; i < stage_count; i++) {
+    boot_stage_t *s = &stages[i];
+    if (s->state != STAGE_PENDING)
+      continue;
+    uint64_t start = rdtsc();
+    s->fn();
+    s->cycles = rdtsc() - start;
+    s->state = STAGE_DONE;
+    ran++;
+  }
+  return ran;
+}
+
+/* Cycles -> microseconds via the calibrated clock; 0 if the TSC was
+ * never calibrated (bootchart then shows raw cycles) */
+static uint32_t stage_us(uint64_t cycles) {
+  uint64_t ns = tsc_to_ns(cycles);
+  if (!ns)
+    return 0;
+  return (uint32_t)div_u64_u32(ns, 1000);
+}
+
+void cmd_bootchart(const char *args) {
+  (void)args;
+
+  if (stage_count == 0) {
+    kprintf("bootchart: no stages recorded\n");
+    return;
+  }
+
+  int calibrated = tsc_to_ns(1000) != 0;
+  kprintf("\nBoot stages (%s):\n", calibrated ? "microseconds" : "TSC cycles");
+
+  uint64_t critical_total = 0;
+  for (int i = 0; i < stage_count; i++) {
+    boot_stage_t *s = &stages[i];
+    const char *tag = s->deferred ? "deferred" : "critical";
+    if (s->state == STAGE_PENDING) {
+      kprintf("  %s  %s  pending\n", tag, s->name);
+      continue;
+    }
+    if (calibrated)
+      kprintf("  %s  %s  %d us\n", tag, s->name, (int)stage_us(s->cycles));
+    else
+      kprintf("  %s  %s  %d cyc\n", tag, s->name, (int)s->cycles);
+    if (!s->deferred)
+      critical_total += s->cycles;
+  }
+
+  if (calibrated) {
+    kprintf("\nCritical path: %d us\n", (int)stage_us(critical_total));
+    if (prompt_ready_tsc && boot_start_tsc)
+      kprintf("Prompt ready:  %d us after first stage\n",
+              (int)stage_us(prompt_ready_tsc - boot_start_tsc));
+  } else {
+    kprintf("\nCritical path: %d cyc (TSC uncalibrated)\n",
+            (int)critical_total);
+  }
+  kprintf("\n");
+}
@@ -0,0 +1,275 @@
+/*
+ * NanoSec OS - Tab Completion
+ * =============================
+ * Completion for the shell input loop.  Command names live in a
+ * trie built once from the command registry, so a prefix resolves
+ * in time proportional to its length; path components walk the
+ * ramfs per-directory child lists, so a large directory elsewhere
+ * in the tree costs nothing at the keypress.
+ *
+ * One tab inserts the longest unambiguous extension (plus a space
+ * after a unique command or file, a slash after a directory);
+ * a second tab with no progress lists the candidates.
+ */
+
+#include "kernel.h"
+
+#define CMD_BUF_MAX 256
+
+/* ============ Command-name trie ============ */
+
+/* Static pool, first-child/next-sibling links */
+#define TRIE_MAX 1024
+
+typedef struct {
+  char ch;
+  uint8_t terminal;
+  int16_t child;
+  int16_t next;
+} trie_node_t;
+
+static trie_node_t trie[TRIE_MAX];
+static int trie_used = 0;
+
+static int trie_new(char ch) {
+  if (trie_used >= TRIE_MAX)
+    return -1;
+  trie[trie_used].ch = ch;
+  trie[trie_used].terminal = 0;
+  trie[trie_used].child = -1;
+  trie[trie_used].next = -1;
+  return trie_used++;
+}
+
+static void trie_insert(const char *s) {
+  int n = 0;
+  for (; *s; s++) {
+    int c = trie[n].child;
+    while (c >= 0 && trie[c].ch != *s)
+      c = trie[c].next;
+    if (c < 0) {
+      c = trie_new(*s);
+      if (c < 0)
+        return; /* Pool exhausted - name just won't complete */
+      trie[c].next = trie[n].child;
+      trie[n].child = (int16_t)c;
+    }
+    n = c;
+  }
+  trie[n].terminal = 1;
+}
+
+static void trie_build(void) {
+  trie_used = 0;
+  trie_new(0); /* Root */
+  int cnt = shell_cmd_count();
+  for (int i = 0; i < cnt; i++)
+    trie_insert(shell_cmd_name(i));
+}
+
+/* Descend along prefix; node index or -1 */
+static int trie_descend(const char *prefix, int len) {
+  int n = 0;
+  for (int i = 0; i < len; i++) {
+    int c = trie[n].child;
+    while (c >= 0 && trie[c].ch != prefix[i])
+      c = trie[c].next;
+    if (c < 0)
+      return -1;
+    n = c;
+  }
+  return n;
+}
+
+/* Terminals in the subtree = number of matching commands */
+static int trie_count(int n) {
+  int total = trie[n].terminal ? 1 : 0;
+  for (int c = trie[n].child; c >= 0; c = trie[c].next)
+    total += trie_count(c);
+  return total;
+}
+
+/* Longest extension shared by every completion below n */
+static int trie_extension(int n, char *ext, int max) {
+  int len = 0;
+  while (len < max) {
+    if (trie[n].terminal)
+      break; /* One candidate ends here, others continue */
+    int c = trie[n].child;
+    if (c < 0 || trie[c].next >= 0)
+      break; /* None or more than one way forward */
+    ext[len++] = trie[c].ch;
+    n = c;
+  }
+  ext[len] = '\0';
+  return len;
+}
+
+static void trie_list(int n, const char *prefix, char *suffix, int depth) {
+  if (trie[n].terminal) {
+    suffix[depth] = '\0';
+    kprintf("%s%s  ", prefix, suffix);
+  }
+  for (int c = trie[n].child; c >= 0; c = trie[c].next) {
+    suffix[depth] = trie[c].ch;
+    trie_list(c, prefix, suffix, depth + 1);
+  }
+}
+
+/* ============ Completion core ============ */
+
+/* Append ext to the line, echoing as we go */
+static void insert_text(char *buf, int *pos, const char *ext) {
+  while (*ext && *pos < CMD_BUF_MAX - 1) {
+    buf[(*pos)++] = *ext;
+    vga_putchar(*ext++);
+  }
+}
+
+/* Complete the first word against the command trie */
+static int complete_command(char *buf, int *pos, const char *token, int list) {
+  static int trie_ready = 0;
+  if (!trie_ready) {
+    trie_build();
+    trie_ready = 1;
+  }
+
+  int tlen = (int)strlen(token);
+  int n = trie_descend(token, tlen);
+  if (n < 0)
+    return 0;
+
+  int count = trie_count(n);
+  char ext[64];
+  trie_extension(n, ext, sizeof(ext) - 1);
+  insert_text(buf, pos, ext);
+
+  if (count == 1) {
+    insert_text(buf, pos, " ");
+  } else if (count > 1 && list) {
+    char suffix[64];
+    kprintf("\n");
+    trie_list(n, token, suffix, (int)strlen(ext));
+    kprintf("\n");
+  }
+  return count;
+}
+
+/*
+ * Complete a path token against the parent directory's child list.
+ * The token splits at its last '/': everything before resolves to a
+ * directory once, the rest is the name prefix to match.
+ */
+static int complete_path(char *buf, int *pos, const char *token, int list) {
+  char dirpart[192];
+  const char *prefix = token;
+  int dlen = 0;
+
+  for (const char *p = token; *p; p++) {
+    if (*p == '/')
+      prefix = p + 1;
+  }
+  dlen = (int)(prefix - token);
+  if (dlen >= (int)sizeof(dirpart))
+    return 0;
+
+  if (dlen == 0) {
+    strcpy(dirpart, ".");
+  } else if (dlen == 1 && token[0] == '/') {
+    strcpy(dirpart, "/");
+  } else {
+    memcpy(dirpart, token, dlen);
+    dirpart[dlen] = '\0'; /* Trailing '/' is fine for resolve */
+  }
+
+  int dir = fs_resolve_dir(dirpart);
+  if (dir < 0)
+    return 0;
+
+  int plen = (int)strlen(prefix);
+  int count = 0;
+  int only = -1;
+  char ext[64];
+  int ext_len = -1;
+
+  /* One walk: count matches and fold their longest common tail */
+  for (int c = fs_first_child(dir); c >= 0; c = fs_next_sibling(c)) {
+    const char *name = fs_node_name(c);
+    int match = 1;
+    for (int i = 0; i < plen; i++) {
+      if (name[i] != prefix[i]) {
+        match = 0;
+        break;
+      }
+    }
+    if (!match)
+      continue;
+
+    count++;
+    only = c;
+    const char *tail = name + plen;
+    if (ext_len < 0) {
+      ext_len = 0;
+      while (tail[ext_len] && ext_len < (int)sizeof(ext) - 1) {
+        ext[ext_len] = tail[ext_len];
+        ext_len++;
+      }
+    } else {
+      int i = 0;
+      while (i < ext_len && tail[i] == ext[i])
+        i++;
+      ext_len = i;
+    }
+  }
+
+  if (count == 0)
+    return 0;
+
+  ext[ext_len] = '\0';
+  insert_text(buf, pos, ext);
+
+  if (count == 1) {
+    insert_text(buf, pos, fs_node_isdir(only) ? "/" : " ");
+  } else if (list) {
+    kprintf("\n");
+    for (int c = fs_first_child(dir); c >= 0; c = fs_next_sibling(c)) {
+      const char *name = fs_node_name(c);
+      int match = 1;
+      for (int i = 0; i < plen; i++) {
+        if (name[i] != prefix[i]) {
+          match = 0;
+          break;
+        }
+      }
+      if (match)
+        kprintf("%s%s  ", name, fs_node_isdir(c) ? "/" : "");
+    }
+    kprintf("\n");
+  }
+  return count;
+}
+
+/*
+ * Complete the token under the cursor.  Returns the candidate count
+ * (0 = nothing matched); when it listed candidates (list set, more
+ * than one match) the caller repaints the prompt and line.
+ */
+int shell_complete(char *buf, int *pos, int list) {
+  /* Token = text after the last space */
+  int start = *pos;
+  while (start > 0 && buf[start - 1] != ' ')
+    start--;
+  buf[*pos] = '\0';
+  const char *token = buf + start;
+
+  /* First word without a slash is a command, everything else a path */
+  int has_slash = 0;
+  for (const char *p = token; *p; p++) {
+    if (*p == '/')
+      has_slash = 1;
+  }
+
+  if (start == 0 && !has_slash)
+    return complete_command(buf, pos, token, list);
+  return complete_path(buf, pos, token, list);
+}
@@ -91,6 +91,7 @@ typedef void (*isr_handler_t)(interrupt_frame_t *frame);
 
 /* Functions */
 void idt_init(void);
+uint64_t irq_get_cycles(void);
 void idt_set_gate(uint8_t num, uint32_t base, uint16_t selector, uint8_t flags);
 void isr_register_handler(uint8_t num, isr_handler_t handler);
 
@@ -93,6 +93,26 @@ isr128:
     push dword 128
     jmp isr_common
 
+; Fast syscall entry (SYSENTER). Convention: eax=number, ebx/esi/edi
+; args, ecx=user esp, edx=user return eip. The CPU has already loaded
+; our CS/ESP from the SYSENTER MSRs; dispatch through C and return
+; with SYSEXIT (which restores esp from ecx and eip from edx).
+global sysenter_entry
+extern sysenter_dispatch
+sysenter_entry:
+    push edx            ; user return eip
+    push ecx            ; user esp
+    push edi            ; arg3
+    push esi            ; arg2
+    push ebx            ; arg1
+    push eax            ; syscall number
+    call sysenter_dispatch
+    add esp, 16         ; drop number + args
+    pop ecx             ; user esp for sysexit
+    pop edx             ; user eip for sysexit
+    sti                 ; sysexit does not restore IF
+    sysexit
+
 ; Common ISR stub - saves state and calls C handler
 isr_common:
     ; Save all registers
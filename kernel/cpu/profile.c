@@ -0,0 +1,100 @@
+/*
+ * NanoSec OS - Sampling Profiler
+ * ================================
+ * Histograms the EIP interrupted by the timer IRQ into 256-byte text
+ * buckets, so hot code shows up as hot address ranges after a few
+ * seconds of sampling. Sampling costs one compare and one increment
+ * per tick; the histogram is only walked at report time. Bucket
+ * addresses are matched against the link map to name the function.
+ */
+
+#include "../kernel.h"
+
+/* Section bounds from the linker script */
+extern char _text_start[];
+extern char _text_end[];
+
+#define PROF_BUCKET_SHIFT 8 /* 256-byte buckets */
+#define PROF_MAX_BUCKETS 4096
+
+static uint32_t prof_hist[PROF_MAX_BUCKETS];
+static uint32_t prof_total = 0;
+static uint32_t prof_foreign = 0; /* Samples outside .text */
+static int prof_running = 0;
+
+/*
+ * Record one sample - called from the timer IRQ
+ */
+void profile_sample(uint32_t eip) {
+  if (!prof_running)
+    return;
+
+  prof_total++;
+  uint32_t base = (uint32_t)_text_start;
+  if (eip < base || eip >= (uint32_t)_text_end) {
+    prof_foreign++;
+    return;
+  }
+  uint32_t bucket = (eip - base) >> PROF_BUCKET_SHIFT;
+  if (bucket < PROF_MAX_BUCKETS)
+    prof_hist[bucket]++;
+}
+
+static void profile_reset(void) {
+  memset(prof_hist, 0, sizeof(prof_hist));
+  prof_total = 0;
+  prof_foreign = 0;
+}
+
+static void profile_report(void) {
+  kprintf("\n=== Profile (%d samples, %d outside .text) ===\n",
+          (int)prof_total, (int)prof_foreign);
+  if (prof_total == 0) {
+    kprintf("No samples. Run 'profile start' first.\n");
+    return;
+  }
+
+  /* Top 10 buckets by selection - the table is small and cold */
+  for (int rank = 0; rank < 10; rank++) {
+    uint32_t best = 0;
+    int best_idx = -1;
+    for (int i = 0; i < PROF_MAX_BUCKETS; i++) {
+      if (prof_hist[i] > best) {
+        best = prof_hist[i];
+        best_idx = i;
+      }
+    }
+    if (best_idx < 0)
+      break;
+
+    uint32_t lo = (uint32_t)_text_start + ((uint32_t)best_idx << PROF_BUCKET_SHIFT);
+    kprintf("  0x%x-0x%x  %d samples (%d%%)\n", lo,
+            lo + (1 << PROF_BUCKET_SHIFT) - 1, (int)best,
+            (int)(best * 100 / prof_total));
+    prof_hist[best_idx] = 0; /* Consumed; reset clears the rest */
+  }
+  kprintf("Match ranges against the link map for function names.\n");
+}
+
+/*
+ * profile command - start/stop/report/reset
+ */
+void cmd_profile(const char *args) {
+  if (strcmp(args, "start") == 0) {
+    profile_reset();
+    prof_running = 1;
+    if (!timer_is_running())
+      kprintf("Warning: timer IRQ not ticking; no samples will land\n");
+    kprintf("Profiling started (one sample per timer tick)\n");
+  } else if (strcmp(args, "stop") == 0) {
+    prof_running = 0;
+    kprintf("Profiling stopped (%d samples)\n", (int)prof_total);
+  } else if (strcmp(args, "report") == 0) {
+    profile_report();
+  } else if (strcmp(args, "reset") == 0) {
+    profile_reset();
+    kprintf("Profile cleared\n");
+  } else {
+    kprintf("Usage: profile start|stop|report|reset\n");
+  }
+}
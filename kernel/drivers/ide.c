@@ -4,6 +4,7 @@
  * Primary IDE controller with PIO mode support
  */
 
+#include "../cpu/idt.h"
 #include "../kernel.h"
 
 /* IDE controller I/O ports (Primary) */
@@ -29,9 +30,22 @@
 /* IDE Commands */
 #define IDE_CMD_READ_PIO 0x20
 #define IDE_CMD_WRITE_PIO 0x30
+#define IDE_CMD_READ_DMA 0xC8
+#define IDE_CMD_WRITE_DMA 0xCA
 #define IDE_CMD_IDENTIFY 0xEC
 #define IDE_CMD_FLUSH 0xE7
 
+/* Bus Master IDE registers (offsets from BAR4, primary channel) */
+#define BM_CMD 0x00
+#define BM_STATUS 0x02
+#define BM_PRDT 0x04
+
+#define BM_CMD_START 0x01
+#define BM_CMD_READ 0x08 /* Direction: disk -> memory */
+
+#define BM_STATUS_ERR 0x02
+#define BM_STATUS_IRQ 0x04
+
 /* Sector size */
 #define SECTOR_SIZE 512
 
@@ -46,6 +60,21 @@ typedef struct {
 
 static ide_drive_t ide_drives[4]; /* Master/slave on primary/secondary */
 
+/* Bus Master IDE state (0 when no BMIDE controller was found: all
+ * transfers then fall back to PIO) */
+static uint32_t bmide_base;
+static uint32_t *prd_table;  /* Physical Region Descriptor table */
+static uint8_t *dma_buffer;  /* Contiguous bounce buffer */
+static uint32_t dma_buf_len; /* Size of the bounce buffer */
+static volatile int ide_irq_done;
+
+/* External PCI functions */
+extern int pci_find_class(uint8_t class_code, uint8_t subclass, uint8_t *bus,
+                          uint8_t *slot, uint8_t *func);
+extern void pci_enable_bus_master_at(uint8_t bus, uint8_t slot, uint8_t func);
+extern uint32_t pci_read32(uint8_t bus, uint8_t slot, uint8_t func,
+                           uint8_t offset);
+
 /*
  * Wait for IDE to be ready
  */
@@ -144,6 +173,133 @@ static int ide_identify(int drive, ide_drive_t *info) {
   return 0;
 }
 
+/*
+ * IDE IRQ handler: acknowledge the controller and wake the waiter
+ */
+static void ide_irq(interrupt_frame_t *frame) {
+  (void)frame;
+
+  if (bmide_base) {
+    uint8_t status = inb(bmide_base + BM_STATUS);
+    if (status & BM_STATUS_IRQ) {
+      outb(bmide_base + BM_CMD, 0); /* Stop the bus master */
+      outb(bmide_base + BM_STATUS, status | BM_STATUS_IRQ); /* Ack */
+    }
+  }
+
+  inb(IDE_STATUS); /* Clear the drive's INTRQ */
+  ide_irq_done = 1;
+}
+
+/*
+ * Build the PRD table for a transfer of len bytes from the bounce
+ * buffer. Entries must not cross 64KB physical boundaries.
+ */
+static void ide_build_prd(uint32_t len) {
+  uint32_t addr = (uint32_t)dma_buffer;
+  int entry = 0;
+
+  while (len > 0) {
+    uint32_t chunk = 0x10000 - (addr & 0xFFFF);
+    if (chunk > len)
+      chunk = len;
+
+    prd_table[entry * 2] = addr;
+    prd_table[entry * 2 + 1] = chunk & 0xFFFF; /* 0 means 64KB */
+    addr += chunk;
+    len -= chunk;
+    if (len == 0)
+      prd_table[entry * 2 + 1] |= 0x80000000; /* End of table */
+    entry++;
+  }
+}
+
+/*
+ * One bus-master DMA transfer. Returns 0 on success, -1 on error or
+ * timeout (caller falls back to PIO).
+ */
+static int ide_dma_transfer(int drive, uint32_t lba, uint8_t count, int write) {
+  uint32_t len = (count ? count : 256) * SECTOR_SIZE;
+
+  ide_build_prd(len);
+
+  /* Program the bus master: stop, load PRDT, clear status */
+  outb(bmide_base + BM_CMD, 0);
+  outb(bmide_base + BM_PRDT, (uint32_t)prd_table & 0xFF);
+  outb(bmide_base + BM_PRDT + 1, ((uint32_t)prd_table >> 8) & 0xFF);
+  outb(bmide_base + BM_PRDT + 2, ((uint32_t)prd_table >> 16) & 0xFF);
+  outb(bmide_base + BM_PRDT + 3, ((uint32_t)prd_table >> 24) & 0xFF);
+  outb(bmide_base + BM_STATUS,
+       inb(bmide_base + BM_STATUS) | BM_STATUS_IRQ | BM_STATUS_ERR);
+
+  /* Issue the ATA command */
+  ide_wait(0);
+  outb(IDE_DEVICE, 0xE0 | ((drive & 1) << 4) | ((lba >> 24) & 0x0F));
+  outb(IDE_SECTOR_CNT, count);
+  outb(IDE_LBA_LO, lba & 0xFF);
+  outb(IDE_LBA_MID, (lba >> 8) & 0xFF);
+  outb(IDE_LBA_HI, (lba >> 16) & 0xFF);
+
+  ide_irq_done = 0;
+  outb(IDE_COMMAND, write ? IDE_CMD_WRITE_DMA : IDE_CMD_READ_DMA);
+
+  /* Start the bus master (direction bit set when reading to memory) */
+  outb(bmide_base + BM_CMD, BM_CMD_START | (write ? 0 : BM_CMD_READ));
+
+  /* Sleep until the completion IRQ; the CPU is free during the
+   * transfer instead of spinning on DRQ */
+  uint32_t deadline = timer_get_ticks() + 500;
+  while (!ide_irq_done) {
+    if (timer_get_ticks() > deadline) {
+      outb(bmide_base + BM_CMD, 0);
+      return -1;
+    }
+    asm volatile("hlt");
+  }
+
+  uint8_t status = inb(bmide_base + BM_STATUS);
+  if (status & BM_STATUS_ERR) {
+    outb(bmide_base + BM_STATUS, status | BM_STATUS_ERR);
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * Detect the Bus Master IDE controller (PCI class 01.01) and set up
+ * the PRD table and bounce buffer
+ */
+static void ide_dma_init(void) {
+  uint8_t bus, slot, func;
+
+  if (pci_find_class(0x01, 0x01, &bus, &slot, &func) < 0) {
+    return; /* No PCI IDE controller: stay on PIO */
+  }
+
+  uint32_t bar4 = pci_read32(bus, slot, func, 0x20);
+  if (!(bar4 & 1)) {
+    return; /* BMIDE registers must be in I/O space */
+  }
+
+  /* PRD table: one page; bounce buffer: 128KB (covers 256 sectors) */
+  uint32_t prd_page = page_alloc();
+  uint32_t buf_area = page_alloc_order(5);
+  if (!prd_page || !buf_area) {
+    return;
+  }
+
+  prd_table = (uint32_t *)prd_page;
+  dma_buffer = (uint8_t *)buf_area;
+  dma_buf_len = 32 * 4096;
+
+  pci_enable_bus_master_at(bus, slot, func);
+  isr_register_handler(IRQ14, ide_irq);
+
+  bmide_base = bar4 & ~0x3;
+  kprintf("  [OK] IDE DMA (BMIDE at 0x%x)\n", bmide_base);
+}
+
 /*
  * Initialize IDE controller
  */
@@ -161,17 +317,17 @@ int ide_init(void) {
     }
   }
 
+  if (found > 0) {
+    ide_dma_init();
+  }
+
   return found;
 }
 
 /*
- * Read sectors from disk
+ * Read sectors from disk (PIO fallback path)
  */
-int ide_read(int drive, uint32_t lba, uint8_t count, void *buffer) {
-  if (drive < 0 || drive > 1 || !ide_drives[drive].present) {
-    return -1;
-  }
-
+static int ide_read_pio(int drive, uint32_t lba, uint8_t count, void *buffer) {
   ide_wait(0);
 
   /* Select drive with LBA mode */
@@ -208,13 +364,10 @@ int ide_read(int drive, uint32_t lba, uint8_t count, void *buffer) {
 }
 
 /*
- * Write sectors to disk
+ * Write sectors to disk (PIO fallback path)
  */
-int ide_write(int drive, uint32_t lba, uint8_t count, const void *buffer) {
-  if (drive < 0 || drive > 1 || !ide_drives[drive].present) {
-    return -1;
-  }
-
+static int ide_write_pio(int drive, uint32_t lba, uint8_t count,
+                         const void *buffer) {
   ide_wait(0);
 
   /* Select drive with LBA mode */
@@ -256,6 +409,58 @@ int ide_write(int drive, uint32_t lba, uint8_t count, const void *buffer) {
   return 0;
 }
 
+/*
+ * Read sectors from disk (DMA when available, PIO otherwise)
+ */
+int ide_read(int drive, uint32_t lba, uint8_t count, void *buffer) {
+  if (drive < 0 || drive > 1 || !ide_drives[drive].present) {
+    return -1;
+  }
+
+  uint32_t len = (count ? count : 256) * SECTOR_SIZE;
+  KTRACE(KTRACE_IDE, KT_EV_IDE_RD, lba);
+
+  if (bmide_base && len <= dma_buf_len) {
+    if (ide_dma_transfer(drive, lba, count, 0) == 0) {
+      memcpy(buffer, dma_buffer, len);
+      KTRACE(KTRACE_IDE, KT_EV_IDE_RD_DONE, lba);
+      return 0;
+    }
+    /* DMA failed: fall through to PIO */
+  }
+
+  int rc = ide_read_pio(drive, lba, count, buffer);
+  if (rc == 0)
+    KTRACE(KTRACE_IDE, KT_EV_IDE_RD_DONE, lba);
+  return rc;
+}
+
+/*
+ * Write sectors to disk (DMA when available, PIO otherwise)
+ */
+int ide_write(int drive, uint32_t lba, uint8_t count, const void *buffer) {
+  if (drive < 0 || drive > 1 || !ide_drives[drive].present) {
+    return -1;
+  }
+
+  uint32_t len = (count ? count : 256) * SECTOR_SIZE;
+  KTRACE(KTRACE_IDE, KT_EV_IDE_WR, lba);
+
+  if (bmide_base && len <= dma_buf_len) {
+    memcpy(dma_buffer, buffer, len);
+    if (ide_dma_transfer(drive, lba, count, 1) == 0) {
+      KTRACE(KTRACE_IDE, KT_EV_IDE_WR_DONE, lba);
+      return 0;
+    }
+    /* DMA failed: fall through to PIO */
+  }
+
+  int rc = ide_write_pio(drive, lba, count, buffer);
+  if (rc == 0)
+    KTRACE(KTRACE_IDE, KT_EV_IDE_WR_DONE, lba);
+  return rc;
+}
+
 /*
  * Get drive info
  */
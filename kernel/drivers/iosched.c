@@ -0,0 +1,144 @@
+/*
+ * NanoSec OS - IDE I/O Scheduler
+ * ================================
+ * Small elevator between the block cache and the IDE driver.
+ * Requests are queued with a completion callback, sorted by LBA, and
+ * adjacent requests are merged into single multi-sector commands
+ * before being issued. A flush of 32 scattered dirty sectors that
+ * happen to be sequential becomes a handful of large transfers.
+ */
+
+#include "../kernel.h"
+
+/* External IDE functions */
+extern int ide_read(int drive, uint32_t lba, uint8_t count, void *buffer);
+extern int ide_write(int drive, uint32_t lba, uint8_t count,
+                     const void *buffer);
+
+#define IO_QUEUE_MAX 32
+#define IO_SECTOR 512
+/* ide_read/ide_write take a uint8_t count, so merges cap at 255 */
+#define IO_MERGE_MAX 255
+
+typedef struct {
+  int drive;
+  uint32_t lba;
+  uint8_t *buf;
+  uint8_t count; /* Sectors */
+  int write;
+  io_done_fn done;
+  void *ctx;
+} io_request_t;
+
+static io_request_t queue[IO_QUEUE_MAX];
+static int queue_len;
+
+/* Staging area for merged transfers (lazily allocated) */
+static uint8_t *io_staging;
+#define IO_STAGING_ORDER 5 /* 32 pages = 128KB, covers 255 sectors */
+
+/*
+ * Queue a request. Returns 0, or -1 if the queue is full (callers
+ * should io_flush and retry, or fall back to direct I/O).
+ */
+int io_submit(int drive, uint32_t lba, uint8_t count, void *buf, int write,
+              io_done_fn done, void *ctx) {
+  if (queue_len >= IO_QUEUE_MAX || count == 0)
+    return -1;
+
+  io_request_t *r = &queue[queue_len++];
+  r->drive = drive;
+  r->lba = lba;
+  r->buf = (uint8_t *)buf;
+  r->count = count;
+  r->write = write;
+  r->done = done;
+  r->ctx = ctx;
+  return 0;
+}
+
+/* Order requests by drive, direction, then ascending LBA */
+static int io_before(const io_request_t *a, const io_request_t *b) {
+  if (a->drive != b->drive)
+    return a->drive < b->drive;
+  if (a->write != b->write)
+    return a->write < b->write;
+  return a->lba < b->lba;
+}
+
+/*
+ * Drain the queue: elevator sort, merge adjacent requests, issue the
+ * merged commands, and run each request's completion callback.
+ */
+void io_flush(void) {
+  if (queue_len == 0)
+    return;
+
+  if (!io_staging) {
+    uint32_t area = page_alloc_order(IO_STAGING_ORDER);
+    io_staging = (uint8_t *)area; /* NULL is fine: no merging then */
+  }
+
+  /* Insertion sort: the queue is small */
+  for (int i = 1; i < queue_len; i++) {
+    io_request_t key = queue[i];
+    int j = i - 1;
+    while (j >= 0 && io_before(&key, &queue[j])) {
+      queue[j + 1] = queue[j];
+      j--;
+    }
+    queue[j + 1] = key;
+  }
+
+  int i = 0;
+  while (i < queue_len) {
+    /* Grow a run of LBA-adjacent requests in the same direction */
+    int run = 1;
+    uint32_t total = queue[i].count;
+    if (io_staging) {
+      while (i + run < queue_len && queue[i + run].drive == queue[i].drive &&
+             queue[i + run].write == queue[i].write &&
+             queue[i + run].lba == queue[i].lba + total &&
+             total + queue[i + run].count <= IO_MERGE_MAX) {
+        total += queue[i + run].count;
+        run++;
+      }
+    }
+
+    int status;
+    if (run == 1) {
+      /* Single request: use its own buffer, no copy */
+      io_request_t *r = &queue[i];
+      status = r->write ? ide_write(r->drive, r->lba, r->count, r->buf)
+                        : ide_read(r->drive, r->lba, r->count, r->buf);
+    } else if (queue[i].write) {
+      /* Merged write: gather into staging, one command out */
+      uint32_t off = 0;
+      for (int k = 0; k < run; k++) {
+        memcpy(io_staging + off, queue[i + k].buf,
+               queue[i + k].count * IO_SECTOR);
+        off += queue[i + k].count * IO_SECTOR;
+      }
+      status = ide_write(queue[i].drive, queue[i].lba, total, io_staging);
+    } else {
+      /* Merged read: one command in, scatter from staging */
+      status = ide_read(queue[i].drive, queue[i].lba, total, io_staging);
+      if (status == 0) {
+        uint32_t off = 0;
+        for (int k = 0; k < run; k++) {
+          memcpy(queue[i + k].buf, io_staging + off,
+                 queue[i + k].count * IO_SECTOR);
+          off += queue[i + k].count * IO_SECTOR;
+        }
+      }
+    }
+
+    for (int k = 0; k < run; k++) {
+      if (queue[i + k].done)
+        queue[i + k].done(status, queue[i + k].ctx);
+    }
+    i += run;
+  }
+
+  queue_len = 0;
+}
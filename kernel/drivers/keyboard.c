@@ -7,8 +7,20 @@
 #define KB_DATA_PORT 0x60
 #define KB_STATUS_PORT 0x64
 
-/* Keyboard buffer */
-#define KB_BUFFER_SIZE 256
+/*
+ * Raw scancode ring (SPSC): the IRQ/poll producer only writes head,
+ * the consumer only writes tail, so no locking is needed. Translation
+ * to ASCII is deferred to the consumer side - the interrupt path is
+ * one port read and one ring store.
+ */
+#define SC_RING_SIZE 1024 /* Power of two */
+static volatile uint8_t sc_ring[SC_RING_SIZE];
+static volatile uint32_t sc_head = 0; /* Producer */
+static volatile uint32_t sc_tail = 0; /* Consumer */
+static uint32_t sc_dropped = 0;
+
+/* Translated character buffer */
+#define KB_BUFFER_SIZE 1024
 static char kb_buffer[KB_BUFFER_SIZE];
 static volatile int kb_buffer_start = 0;
 static volatile int kb_buffer_end = 0;
@@ -33,10 +45,76 @@ static const char scancode_ascii_shift[] = {
     'J', 'K', 'L',  ':',  '"',  '~', 0,   '|', 'Z', 'X', 'C', 'V',
     'B', 'N', 'M',  '<',  '>',  '?', 0,   '*', 0,   ' '};
 
-/* Keyboard interrupt handler - called from IRQ1 */
+/* Scrollback keys (set 1: PgUp/PgDn, with or without E0 prefix) */
+#define SC_EXTENDED 0xE0
+#define SC_PGUP 0x49
+#define SC_PGDN 0x51
+#define SC_UP 0x48
+#define SC_DOWN 0x50
+#define SC_LEFT 0x4B
+#define SC_RIGHT 0x4D
+#define SCROLLBACK_STEP 24
+
+/* Push one translated character (drops when the buffer is full) */
+static void kb_push_char(char c) {
+  int next = (kb_buffer_end + 1) % KB_BUFFER_SIZE;
+  if (next != kb_buffer_start) {
+    kb_buffer[kb_buffer_end] = c;
+    kb_buffer_end = next;
+  }
+}
+
+/* Keyboard interrupt handler - called from IRQ1. Queues the raw
+ * scancode and returns; translation happens on the consumer side. */
 void keyboard_handler(void) {
   uint8_t scancode = inb(KB_DATA_PORT);
 
+  if (sc_head - sc_tail >= SC_RING_SIZE) {
+    sc_dropped++;
+    return;
+  }
+  sc_ring[sc_head & (SC_RING_SIZE - 1)] = scancode;
+  sc_head++;
+}
+
+/* Translate one raw scancode, updating modifier state and pushing
+ * any resulting character into the buffer */
+static void translate_scancode(uint8_t scancode) {
+  /* The nav cluster sends an E0 prefix before its scancode; the code
+   * below treats the following byte the same either way, so the
+   * prefix itself is just swallowed */
+  if (scancode == SC_EXTENDED)
+    return;
+
+  /* Shift-PgUp/PgDn page through the console scrollback */
+  if (shift_pressed && scancode == SC_PGUP) {
+    vga_scrollback(SCROLLBACK_STEP);
+    return;
+  }
+  if (shift_pressed && scancode == SC_PGDN) {
+    vga_scrollback(-SCROLLBACK_STEP);
+    return;
+  }
+
+  /* Arrow keys surface as emacs-style control characters so line
+   * editors can navigate without a scancode side channel */
+  if (scancode == SC_UP) {
+    kb_push_char(0x10); /* Ctrl-P */
+    return;
+  }
+  if (scancode == SC_DOWN) {
+    kb_push_char(0x0E); /* Ctrl-N */
+    return;
+  }
+  if (scancode == SC_LEFT) {
+    kb_push_char(0x02); /* Ctrl-B */
+    return;
+  }
+  if (scancode == SC_RIGHT) {
+    kb_push_char(0x06); /* Ctrl-F */
+    return;
+  }
+
   /* Key release */
   if (scancode & 0x80) {
     scancode &= 0x7F;
@@ -82,12 +160,19 @@ void keyboard_handler(void) {
   }
 
   /* Add to buffer */
-  if (c != 0) {
-    int next = (kb_buffer_end + 1) % KB_BUFFER_SIZE;
-    if (next != kb_buffer_start) {
-      kb_buffer[kb_buffer_end] = c;
-      kb_buffer_end = next;
-    }
+  if (c != 0)
+    kb_push_char(c);
+}
+
+/* Pull pending bytes off the controller (poll mode) and translate
+ * everything queued so far - one pass per wakeup, however large the
+ * burst */
+static void keyboard_process(void) {
+  while (inb(KB_STATUS_PORT) & 0x01)
+    keyboard_handler();
+  while (sc_tail != sc_head) {
+    translate_scancode(sc_ring[sc_tail & (SC_RING_SIZE - 1)]);
+    sc_tail++;
   }
 }
 
@@ -99,17 +184,25 @@ int keyboard_init(void) {
 
 int keyboard_available(void) { return kb_buffer_start != kb_buffer_end; }
 
-/* Polling-based getchar for now */
+/* Optional wait hook, installed by the scheduler: called between
+ * polls so the waiting process blocks instead of spinning */
+static void (*kb_wait_hook)(void) = NULL;
+
+void keyboard_set_wait_hook(void (*hook)(void)) { kb_wait_hook = hook; }
+
+/* Polling-based getchar; yields the CPU between polls when a
+ * scheduler is running */
 char keyboard_getchar(void) {
   while (1) {
-    if (inb(KB_STATUS_PORT) & 0x01) {
-      keyboard_handler();
-    }
+    keyboard_process();
     if (keyboard_available()) {
       char c = kb_buffer[kb_buffer_start];
       kb_buffer_start = (kb_buffer_start + 1) % KB_BUFFER_SIZE;
       return c;
     }
+    if (kb_wait_hook) {
+      kb_wait_hook();
+    }
   }
 }
 
@@ -117,10 +210,7 @@ char keyboard_getchar(void) {
  * Non-blocking getchar - returns 0 if no key available
  */
 char keyboard_getchar_nonblocking(void) {
-  /* Check for new input */
-  if (inb(KB_STATUS_PORT) & 0x01) {
-    keyboard_handler();
-  }
+  keyboard_process();
 
   if (keyboard_available()) {
     char c = kb_buffer[kb_buffer_start];
@@ -132,28 +222,54 @@ char keyboard_getchar_nonblocking(void) {
 }
 
 /*
- * Read a line of input with echo
+ * Read a line of input with echo. All input available at a wakeup is
+ * consumed in one pass and echoed with a single vga_write, so pasted
+ * bursts do not pay a screen update per character.
  */
 void keyboard_getline(char *buf, int max) {
   int i = 0;
-  while (i < max - 1) {
+  char echo[128];
+  int e = 0;
+
+  while (1) {
+    /* Block for the first character, then drain the burst */
     char c = keyboard_getchar();
 
-    if (c == '\n') {
-      buf[i] = '\0';
-      vga_putchar('\n');
-      return;
-    } else if (c == '\b') {
-      if (i > 0) {
-        i--;
-        vga_putchar('\b');
-        vga_putchar(' ');
-        vga_putchar('\b');
+    e = 0;
+    while (1) {
+      if (c == '\n') {
+        echo[e++] = '\n';
+        vga_write(echo, e);
+        buf[i] = '\0';
+        return;
+      } else if (c == '\b') {
+        if (i > 0) {
+          i--;
+          echo[e++] = '\b';
+          echo[e++] = ' ';
+          echo[e++] = '\b';
+        }
+      } else if (c >= ' ' && c <= '~' && i < max - 1) {
+        buf[i++] = c;
+        echo[e++] = c;
       }
-    } else if (c >= ' ' && c <= '~') {
-      buf[i++] = c;
-      vga_putchar(c);
+
+      if (i >= max - 1) {
+        vga_write(echo, e);
+        buf[i] = '\0';
+        return;
+      }
+      if (e >= (int)sizeof(echo) - 3) {
+        vga_write(echo, e);
+        e = 0;
+      }
+
+      c = keyboard_getchar_nonblocking();
+      if (c == 0)
+        break;
     }
+
+    if (e > 0)
+      vga_write(echo, e);
   }
-  buf[i] = '\0';
 }
@@ -36,6 +36,12 @@ static struct {
   int initialized;
 } mouse;
 
+/* Bumped once per packet that carried motion. The handler only
+ * accumulates deltas into mouse.x/y, so a burst of packets between
+ * two polls shows up as one position change - consumers compare this
+ * counter to decide whether a repaint is due at all. */
+static volatile uint32_t motion_count = 0;
+
 /* Screen bounds */
 static int screen_width = 320;
 static int screen_height = 200;
@@ -113,6 +119,9 @@ static void mouse_handler(interrupt_frame_t *frame) {
     mouse.x += dx;
     mouse.y -= dy; /* Y is inverted in PS/2 */
 
+    if (dx || dy)
+      motion_count++;
+
     /* Clamp to screen */
     if (mouse.x < 0)
       mouse.x = 0;
@@ -184,6 +193,12 @@ void mouse_get_pos(int *x, int *y) {
  */
 uint8_t mouse_get_buttons(void) { return mouse.buttons; }
 
+/*
+ * Motion generation counter - unchanged value means no movement since
+ * the caller last looked, however many packets arrived
+ */
+uint32_t mouse_motion_count(void) { return motion_count; }
+
 /*
  * Set mouse bounds
  */
@@ -26,10 +26,19 @@
 #define PCI_BAR3 0x1C
 #define PCI_BAR4 0x20
 #define PCI_BAR5 0x24
+#define PCI_CAP_PTR 0x34
 #define PCI_INTERRUPT_LINE 0x3C
 #define PCI_INTERRUPT_PIN 0x3D
 
-/* PCI device structure */
+/* Status register bit: capability list present */
+#define PCI_STATUS_CAPS 0x10
+
+/* Capability IDs */
+#define PCI_CAP_MSI 0x05
+#define PCI_CAP_MSIX 0x11
+
+/* PCI device structure - everything a driver needs, captured once at
+ * enumeration so queries never go back to config space */
 typedef struct {
   uint8_t bus;
   uint8_t slot;
@@ -40,7 +49,12 @@ typedef struct {
   uint8_t subclass;
   uint8_t prog_if;
   uint8_t irq;
-  uint32_t bar[6];
+  uint32_t bar[6];      /* Raw BAR values */
+  uint32_t bar_addr[6]; /* Decoded base address */
+  uint32_t bar_size[6]; /* Probed region size */
+  uint8_t bar_io[6];    /* 1 = I/O space, 0 = memory space */
+  uint8_t msi_offset;   /* Config offset of the MSI capability, 0 = none */
+  uint8_t msix_offset;  /* Likewise for MSI-X */
 } pci_device_t;
 
 #define MAX_PCI_DEVICES 64
@@ -127,9 +141,42 @@ static int pci_check_device(uint8_t bus, uint8_t slot, uint8_t func) {
   dev->prog_if = pci_read8(bus, slot, func, PCI_PROG_IF);
   dev->irq = pci_read8(bus, slot, func, PCI_INTERRUPT_LINE);
 
-  /* Read BARs */
+  /* Read and decode BARs: size each region by writing all-ones and
+   * reading back the address mask, then restore the original value */
   for (int i = 0; i < 6; i++) {
-    dev->bar[i] = pci_read32(bus, slot, func, PCI_BAR0 + i * 4);
+    uint8_t off = PCI_BAR0 + i * 4;
+    uint32_t raw = pci_read32(bus, slot, func, off);
+    dev->bar[i] = raw;
+
+    pci_write32(bus, slot, func, off, 0xFFFFFFFF);
+    uint32_t mask = pci_read32(bus, slot, func, off);
+    pci_write32(bus, slot, func, off, raw);
+
+    if (raw & 1) {
+      dev->bar_io[i] = 1;
+      dev->bar_addr[i] = raw & ~0x3u;
+      mask &= ~0x3u;
+    } else {
+      dev->bar_io[i] = 0;
+      dev->bar_addr[i] = raw & ~0xFu;
+      mask &= ~0xFu;
+    }
+    dev->bar_size[i] = mask ? (~mask + 1) : 0;
+  }
+
+  /* Walk the capability list once, remembering MSI/MSI-X offsets */
+  dev->msi_offset = 0;
+  dev->msix_offset = 0;
+  if (pci_read16(bus, slot, func, PCI_STATUS) & PCI_STATUS_CAPS) {
+    uint8_t ptr = pci_read8(bus, slot, func, PCI_CAP_PTR) & 0xFC;
+    for (int guard = 0; ptr && guard < 48; guard++) {
+      uint8_t id = pci_read8(bus, slot, func, ptr);
+      if (id == PCI_CAP_MSI)
+        dev->msi_offset = ptr;
+      else if (id == PCI_CAP_MSIX)
+        dev->msix_offset = ptr;
+      ptr = pci_read8(bus, slot, func, ptr + 1) & 0xFC;
+    }
   }
 
   return 1;
@@ -179,6 +226,30 @@ pci_device_t *pci_find_device_class(uint8_t class_code, uint8_t subclass) {
   return NULL;
 }
 
+/*
+ * Find device by class, returning its location (for drivers that
+ * only need bus/slot/func plus the pci_read/pci_write accessors)
+ */
+int pci_find_class(uint8_t class_code, uint8_t subclass, uint8_t *bus,
+                   uint8_t *slot, uint8_t *func) {
+  pci_device_t *dev = pci_find_device_class(class_code, subclass);
+  if (!dev)
+    return -1;
+  *bus = dev->bus;
+  *slot = dev->slot;
+  *func = dev->func;
+  return 0;
+}
+
+/*
+ * Enable bus mastering by location
+ */
+void pci_enable_bus_master_at(uint8_t bus, uint8_t slot, uint8_t func) {
+  uint16_t cmd = pci_read16(bus, slot, func, PCI_COMMAND);
+  cmd |= 0x04; /* Bus master bit */
+  pci_write32(bus, slot, func, PCI_COMMAND, cmd);
+}
+
 /*
  * Find device by vendor/device ID
  */
@@ -192,6 +263,17 @@ pci_device_t *pci_find_device(uint16_t vendor, uint16_t device) {
   return NULL;
 }
 
+/*
+ * Structured iteration over the cached table
+ */
+int pci_get_count(void) { return pci_device_count; }
+
+pci_device_t *pci_get_device(int idx) {
+  if (idx < 0 || idx >= pci_device_count)
+    return NULL;
+  return &pci_devices[idx];
+}
+
 /*
  * List all PCI devices
  */
@@ -203,8 +285,9 @@ void pci_list_devices(void) {
     const char *class_name =
         (dev->class_code < 13) ? pci_class_names[dev->class_code] : "Unknown";
 
-    kprintf("%02x:%02x.%d %04x:%04x %s\n", dev->bus, dev->slot, dev->func,
-            dev->vendor_id, dev->device_id, class_name);
+    kprintf("%02x:%02x.%d %04x:%04x %s IRQ %d%s\n", dev->bus, dev->slot,
+            dev->func, dev->vendor_id, dev->device_id, class_name, dev->irq,
+            dev->msi_offset ? " MSI" : "");
   }
 
   kprintf("\n");
@@ -220,19 +303,19 @@ void pci_enable_bus_master(pci_device_t *dev) {
 }
 
 /*
- * Get BAR address (memory or I/O)
+ * Get BAR address (memory or I/O) - decoded at enumeration
  */
 uint32_t pci_get_bar_addr(pci_device_t *dev, int bar) {
   if (bar < 0 || bar > 5)
     return 0;
+  return dev->bar_addr[bar];
+}
 
-  uint32_t bar_val = dev->bar[bar];
-
-  if (bar_val & 1) {
-    /* I/O space */
-    return bar_val & ~0x3;
-  } else {
-    /* Memory space */
-    return bar_val & ~0xF;
-  }
+/*
+ * Get BAR region size, probed at enumeration
+ */
+uint32_t pci_get_bar_size(pci_device_t *dev, int bar) {
+  if (bar < 0 || bar > 5)
+    return 0;
+  return dev->bar_size[bar];
 }
@@ -4,6 +4,7 @@
  * COM1 serial port for debugging
  */
 
+#include "../cpu/idt.h"
 #include "../kernel.h"
 
 /* COM port addresses */
@@ -28,6 +29,56 @@
 static int serial_initialized = 0;
 static uint16_t serial_base = COM1_BASE;
 
+/*
+ * Transmit ring: writers enqueue and return immediately; bytes reach
+ * the UART from the THR-empty interrupt (or an opportunistic kick
+ * when the FIFO is already idle, which also keeps output moving on
+ * boots where the IDT is not up). On overflow the oldest bytes are
+ * dropped and counted rather than blocking the caller.
+ */
+#define TX_RING_SIZE 4096 /* Power of two */
+#define SERIAL_FIFO_DEPTH 16
+
+static char tx_ring[TX_RING_SIZE];
+static volatile uint32_t tx_head = 0; /* Next byte to enqueue */
+static volatile uint32_t tx_tail = 0; /* Next byte to transmit */
+static uint32_t tx_dropped = 0;
+
+/*
+ * Check if transmit buffer is empty
+ */
+static int serial_transmit_empty(void) {
+  return inb(serial_base + SERIAL_LINE_STATUS) & 0x20;
+}
+
+/* Refill the UART FIFO from the ring if the transmitter is idle.
+ * Never waits: one status read, then at most a FIFO's worth of data
+ * writes. */
+static void serial_tx_kick(void) {
+  if (tx_tail == tx_head || !serial_transmit_empty())
+    return;
+  for (int i = 0; i < SERIAL_FIFO_DEPTH && tx_tail != tx_head; i++) {
+    outb(serial_base + SERIAL_DATA, tx_ring[tx_tail & (TX_RING_SIZE - 1)]);
+    tx_tail++;
+  }
+}
+
+static void tx_enqueue(char c) {
+  if (tx_head - tx_tail >= TX_RING_SIZE) {
+    tx_tail++; /* Drop oldest */
+    tx_dropped++;
+  }
+  tx_ring[tx_head & (TX_RING_SIZE - 1)] = c;
+  tx_head++;
+}
+
+/* COM1 interrupt: acknowledge via IIR, then refill the FIFO */
+static void serial_irq(interrupt_frame_t *frame) {
+  (void)frame;
+  inb(serial_base + SERIAL_FIFO_CTRL); /* IIR read clears THRE */
+  serial_tx_kick();
+}
+
 /*
  * Initialize serial port
  */
@@ -65,37 +116,51 @@ int serial_init(uint16_t base, int baud_divisor) {
   /* Set normal operation mode */
   outb(serial_base + SERIAL_MODEM_CTRL, 0x0F);
 
+  /* Drain through the TX ring: THR-empty interrupt on COM1 */
+  isr_register_handler(IRQ4, serial_irq);
+  outb(serial_base + SERIAL_INT_ENABLE, 0x02);
+
   serial_initialized = 1;
   return 0;
 }
 
 /*
- * Check if transmit buffer is empty
- */
-static int serial_transmit_empty(void) {
-  return inb(serial_base + SERIAL_LINE_STATUS) & 0x20;
-}
-
-/*
- * Write character to serial
+ * Write character to serial - enqueues, never spins
  */
 void serial_putchar(char c) {
   if (!serial_initialized)
     return;
 
-  while (!serial_transmit_empty())
-    ;
-  outb(serial_base + SERIAL_DATA, c);
+  tx_enqueue(c);
+  serial_tx_kick();
 }
 
 /*
- * Write string to serial
+ * Write string to serial - one kick for the whole string
  */
 void serial_puts(const char *str) {
+  if (!serial_initialized)
+    return;
+
   while (*str) {
     if (*str == '\n')
-      serial_putchar('\r');
-    serial_putchar(*str++);
+      tx_enqueue('\r');
+    tx_enqueue(*str++);
+  }
+  serial_tx_kick();
+}
+
+/*
+ * Synchronously drain the ring (panic paths, end of captures)
+ */
+void serial_flush(void) {
+  if (!serial_initialized)
+    return;
+
+  while (tx_tail != tx_head) {
+    while (!serial_transmit_empty())
+      ;
+    serial_tx_kick();
   }
 }
 
@@ -132,6 +197,8 @@ void cmd_dmesg(const char *args) {
   (void)args;
   kprintf("(Kernel messages go to COM1 serial port)\n");
   kprintf("Connect with: screen /dev/ttyS0 115200\n");
+  if (tx_dropped)
+    kprintf("TX ring overflowed: %d bytes dropped\n", (int)tx_dropped);
 }
 
 /*
@@ -19,11 +19,215 @@
 static volatile uint32_t timer_ticks = 0;
 static uint32_t timer_freq = 100; /* 100 Hz default */
 
+/*
+ * High-resolution clock: the TSC is calibrated once at boot against
+ * a PIT channel 2 one-shot, giving ktime_ns() sub-microsecond
+ * timestamps for the cost of an rdtsc. The multiplier is ns-per-
+ * cycle in 22.10 fixed point, so the conversion is a multiply and a
+ * shift - no 64-bit division on the hot path (we have no libgcc).
+ */
+#define TSC_SHIFT 10
+#define CALIB_PIT_TICKS 11932 /* ~10 ms at 1.193182 MHz */
+#define CALIB_NS 10000000     /* The same interval in ns */
+
+static uint32_t tsc_mult = 0; /* 0 = not calibrated */
+static uint64_t tsc_base = 0;
+
+static void vsyscall_publish_calibration(void);
+
+/* 64/32 long division - shared helper since we build without libgcc
+ * (slow, for cold paths like calibration and log display only) */
+uint64_t div_u64_u32(uint64_t n, uint32_t d) {
+  uint64_t q = 0;
+  uint64_t r = 0;
+  for (int i = 63; i >= 0; i--) {
+    r = (r << 1) | ((n >> i) & 1);
+    if (r >= d) {
+      r -= d;
+      q |= (uint64_t)1 << i;
+    }
+  }
+  return q;
+}
+
+/*
+ * Calibrate the TSC against PIT channel 2. Runs a 10 ms one-shot
+ * countdown with the speaker output masked and counts cycles until
+ * the OUT pin flips. Guarded, so a dead PIT just leaves the clock
+ * uncalibrated and ktime_ns falls back to tick granularity.
+ */
+void timer_calibrate_tsc(void) {
+  uint8_t gate = inb(0x61);
+
+  /* Gate channel 2 on, speaker data off */
+  outb(0x61, (gate & ~0x02) | 0x01);
+  outb(PIT_COMMAND, 0xB0); /* Channel 2, lobyte/hibyte, mode 0 */
+  outb(PIT_CHANNEL2, CALIB_PIT_TICKS & 0xFF);
+  outb(PIT_CHANNEL2, (CALIB_PIT_TICKS >> 8) & 0xFF);
+
+  uint64_t start = rdtsc();
+  uint32_t guard = 100000000;
+  while (!(inb(0x61) & 0x20) && --guard)
+    ;
+  uint64_t cycles = rdtsc() - start;
+
+  outb(0x61, gate);
+
+  if (!guard || cycles == 0)
+    return;
+
+  tsc_mult = (uint32_t)div_u64_u32((uint64_t)CALIB_NS << TSC_SHIFT,
+                                   (uint32_t)cycles);
+  tsc_base = rdtsc();
+  vsyscall_publish_calibration();
+
+  kprintf("  [OK] TSC @ %d MHz\n", (int)div_u64_u32(cycles, 10000));
+}
+
+/*
+ * Nanoseconds since calibration. Falls back to PIT-tick resolution
+ * when the TSC could not be calibrated.
+ */
+uint64_t ktime_ns(void) {
+  if (tsc_mult)
+    return ((rdtsc() - tsc_base) * tsc_mult) >> TSC_SHIFT;
+  return (uint64_t)timer_ticks * (1000000000u / timer_freq);
+}
+
+/*
+ * Convert a TSC cycle count to nanoseconds; 0 when uncalibrated
+ */
+uint64_t tsc_to_ns(uint64_t cycles) {
+  if (!tsc_mult)
+    return 0;
+  return (cycles * tsc_mult) >> TSC_SHIFT;
+}
+
+/*
+ * Vsyscall timekeeping page: a page-aligned block exporting the
+ * tick count and TSC calibration so programs can compute time with
+ * plain loads and an rdtsc - no kernel entry. Readers retry while
+ * seq is odd or changes across their reads (seqlock protocol).
+ */
+static vsyscall_time_t vsyscall_time __attribute__((aligned(4096)));
+
+const vsyscall_time_t *vsyscall_page_addr(void) { return &vsyscall_time; }
+
+static void vsyscall_publish_calibration(void) {
+  vsyscall_time.seq++;
+  vsyscall_time.tsc_mult = tsc_mult;
+  vsyscall_time.tsc_shift = TSC_SHIFT;
+  vsyscall_time.tsc_base = tsc_base;
+  vsyscall_time.seq++;
+}
+
+/*
+ * Timer wheel: tick-granularity kernel timers hashed into slots by
+ * expiry tick. The IRQ walks exactly one slot per tick, so arming,
+ * cancelling and expiry are all O(1) amortized. Timers whose expiry
+ * is more than a lap away simply stay in their slot until their
+ * tick comes around.
+ */
+#define TIMER_WHEEL_SLOTS 256 /* Power of two */
+#define MAX_KTIMERS 32
+
+typedef struct ktimer {
+  void (*fn)(void *arg);
+  void *arg;
+  uint32_t expires; /* Absolute tick */
+  uint32_t period;  /* Re-arm interval in ticks, 0 = one-shot */
+  int active;
+  struct ktimer *next;
+} ktimer_t;
+
+static ktimer_t ktimers[MAX_KTIMERS];
+static ktimer_t *wheel[TIMER_WHEEL_SLOTS];
+
+static void wheel_insert(ktimer_t *t) {
+  uint32_t slot = t->expires & (TIMER_WHEEL_SLOTS - 1);
+  t->next = wheel[slot];
+  wheel[slot] = t;
+}
+
+static uint32_t ms_to_ticks(uint32_t ms) {
+  uint32_t ticks = ms * timer_freq / 1000;
+  return ticks ? ticks : 1;
+}
+
+/*
+ * Arm a kernel timer. Returns an id for ktimer_cancel, or -1 when
+ * the table is full. period_ms == 0 gives a one-shot.
+ */
+int ktimer_add(void (*fn)(void *arg), void *arg, uint32_t delay_ms,
+               uint32_t period_ms) {
+  for (int i = 0; i < MAX_KTIMERS; i++) {
+    if (!ktimers[i].active && !ktimers[i].fn) {
+      ktimer_t *t = &ktimers[i];
+      t->fn = fn;
+      t->arg = arg;
+      t->expires = timer_ticks + ms_to_ticks(delay_ms);
+      t->period = period_ms ? ms_to_ticks(period_ms) : 0;
+      t->active = 1;
+      wheel_insert(t);
+      return i;
+    }
+  }
+  return -1;
+}
+
+void ktimer_cancel(int id) {
+  if (id >= 0 && id < MAX_KTIMERS)
+    ktimers[id].active = 0; /* Reaped when its slot is walked */
+}
+
+/* Walk the slot for the current tick, firing due timers */
+static void wheel_advance(void) {
+  uint32_t slot = timer_ticks & (TIMER_WHEEL_SLOTS - 1);
+  ktimer_t **link = &wheel[slot];
+
+  while (*link) {
+    ktimer_t *t = *link;
+
+    if (!t->active) {
+      *link = t->next; /* Cancelled - reap and free the entry */
+      t->fn = NULL;
+      continue;
+    }
+    if (t->expires != timer_ticks) {
+      link = &t->next; /* More than a lap out */
+      continue;
+    }
+
+    *link = t->next;
+
+    /* Release the entry before firing so the callback can re-arm */
+    void (*fn)(void *arg) = t->fn;
+    void *arg = t->arg;
+    if (t->period) {
+      t->expires = timer_ticks + t->period;
+      wheel_insert(t);
+    } else {
+      t->active = 0;
+      t->fn = NULL;
+    }
+    fn(arg);
+  }
+}
+
 /*
  * Timer interrupt handler
  * Called by IRQ0
  */
-void timer_handler(void) { timer_ticks++; }
+void timer_handler(void) {
+  timer_ticks++;
+
+  /* Seqlock write: readers of the vsyscall page retry on odd seq */
+  vsyscall_time.seq++;
+  vsyscall_time.ticks = timer_ticks;
+  vsyscall_time.seq++;
+
+  wheel_advance();
+}
 
 /*
  * Initialize PIT timer
@@ -52,15 +256,50 @@ int timer_init(uint32_t freq) {
  */
 uint32_t timer_get_ticks(void) { return timer_ticks; }
 
+/*
+ * True once PIT ticks have been observed to advance. Not every boot
+ * configuration wires the timer IRQ, so callers that want to sleep
+ * between frames ask this first and keep their busy-wait fallback
+ * until it latches.
+ */
+int timer_is_running(void) {
+  static int latched = 0;
+  static int primed = 0;
+  static uint32_t baseline = 0;
+
+  if (!latched) {
+    if (!primed) {
+      baseline = timer_ticks;
+      primed = 1;
+    } else if (timer_ticks != baseline) {
+      latched = 1;
+    }
+  }
+  return latched;
+}
+
 /*
  * Get uptime in seconds
  */
 uint32_t timer_get_uptime(void) { return timer_ticks / timer_freq; }
 
+/* Optional blocking hook, installed by the scheduler so delays give
+ * the CPU away instead of spinning */
+static void (*block_delay_hook)(uint32_t ms) = NULL;
+
+void timer_set_block_hook(void (*hook)(uint32_t ms)) {
+  block_delay_hook = hook;
+}
+
 /*
- * Busy-wait delay in milliseconds
+ * Delay in milliseconds: blocks through the scheduler when one is
+ * running, otherwise hlt-spins on the tick counter
  */
 void timer_delay_ms(uint32_t ms) {
+  if (block_delay_hook) {
+    block_delay_hook(ms);
+    return;
+  }
   uint32_t target = timer_ticks + (ms * timer_freq / 1000);
   while (timer_ticks < target) {
     asm volatile("hlt");
@@ -15,8 +15,26 @@ static uint32_t fb_pitch = 0;
 static uint32_t fb_bpp = 32;
 static int vesa_mode_active = 0;
 
-/* Forward declaration */
+/* System-memory backbuffer. All primitives draw here (same pitch as
+ * the framebuffer) and only vesa_flush() writes through the slow,
+ * uncacheable aperture - and only the regions that actually changed.
+ * If the backbuffer cannot be allocated, primitives fall back to
+ * drawing straight into the framebuffer and flush is a no-op. */
+static uint32_t *backbuffer = NULL;
+
+/* Dirty-rectangle list, accumulated per frame. When it overflows we
+ * give up on tracking and flush the whole screen. */
+#define VESA_DIRTY_MAX 16
+typedef struct {
+  int x, y, w, h;
+} vesa_dirty_t;
+static vesa_dirty_t dirty_rects[VESA_DIRTY_MAX];
+static int dirty_count = 0;
+static int dirty_full = 0;
+
+/* Forward declarations */
 void vesa_clear(uint32_t color);
+static void vesa_atlas_init(void);
 
 /* Multiboot info structure (partial) */
 typedef struct {
@@ -77,6 +95,9 @@ int vesa_init(uint32_t magic, uint32_t *mb_info_ptr) {
 
   vesa_mode_active = 1;
 
+  /* Expand the font into the glyph atlas */
+  vesa_atlas_init();
+
   /* Clear screen to dark blue */
   vesa_clear(0x001428);
 
@@ -88,6 +109,100 @@ int vesa_init(uint32_t magic, uint32_t *mb_info_ptr) {
  */
 int vesa_is_active(void) { return vesa_mode_active; }
 
+/*
+ * Row pointer into the draw target (backbuffer when available,
+ * otherwise the framebuffer itself)
+ */
+static uint32_t *vesa_row(int y) {
+  uint8_t *base = backbuffer ? (uint8_t *)backbuffer : (uint8_t *)framebuffer;
+  return (uint32_t *)(base + y * fb_pitch);
+}
+
+/*
+ * Try to allocate the backbuffer. vesa_init runs before the page
+ * allocator is up, so this is retried at frame boundaries (from
+ * vesa_clear) until it succeeds.
+ */
+static void vesa_backbuf_init(void) {
+  if (backbuffer)
+    return;
+
+  uint32_t bytes = fb_height * fb_pitch;
+  uint32_t pages = (bytes + 4095) / 4096;
+  int order = 0;
+  while (order <= 10 && (1u << order) < pages)
+    order++;
+  if ((1u << order) < pages)
+    return; /* Larger than the allocator can serve */
+
+  backbuffer = (uint32_t *)page_alloc_order(order);
+  if (backbuffer) {
+    /* Seed with what is currently on screen so partial redraws
+     * composite against the visible content */
+    memcpy(backbuffer, framebuffer, bytes);
+  }
+}
+
+/*
+ * Record a changed region for the next flush
+ */
+static void vesa_mark_dirty(int x, int y, int w, int h) {
+  if (!backbuffer || dirty_full)
+    return;
+
+  /* Clip to screen */
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > (int)fb_width)
+    w = fb_width - x;
+  if (y + h > (int)fb_height)
+    h = fb_height - y;
+  if (w <= 0 || h <= 0)
+    return;
+
+  if (dirty_count >= VESA_DIRTY_MAX) {
+    dirty_full = 1;
+    return;
+  }
+  dirty_rects[dirty_count].x = x;
+  dirty_rects[dirty_count].y = y;
+  dirty_rects[dirty_count].w = w;
+  dirty_rects[dirty_count].h = h;
+  dirty_count++;
+}
+
+/*
+ * Copy the dirty regions to the framebuffer and reset the list.
+ * Without a backbuffer everything was drawn direct, so nothing to do.
+ */
+void vesa_flush(void) {
+  if (!vesa_mode_active || !backbuffer)
+    return;
+
+  if (dirty_full) {
+    memcpy(framebuffer, backbuffer, fb_height * fb_pitch);
+  } else {
+    for (int i = 0; i < dirty_count; i++) {
+      vesa_dirty_t *r = &dirty_rects[i];
+      uint32_t off = r->y * fb_pitch + r->x * 4;
+      for (int row = 0; row < r->h; row++) {
+        memcpy((uint8_t *)framebuffer + off, (uint8_t *)backbuffer + off,
+               r->w * 4);
+        off += fb_pitch;
+      }
+    }
+  }
+
+  dirty_count = 0;
+  dirty_full = 0;
+}
+
 /*
  * Get screen dimensions
  */
@@ -105,12 +220,24 @@ void vesa_clear(uint32_t color) {
   if (!vesa_mode_active)
     return;
 
+  vesa_backbuf_init();
+
   for (uint32_t y = 0; y < fb_height; y++) {
-    uint32_t *row = (uint32_t *)((uint8_t *)framebuffer + y * fb_pitch);
-    for (uint32_t x = 0; x < fb_width; x++) {
-      row[x] = color;
-    }
+    memset32(vesa_row(y), color, fb_width);
   }
+
+  if (backbuffer)
+    dirty_full = 1;
+}
+
+/*
+ * Plot into the draw target without dirty tracking - primitives that
+ * plot many pixels mark their bounding box once instead
+ */
+static void vesa_plot(int x, int y, uint32_t color) {
+  if (x < 0 || x >= (int)fb_width || y < 0 || y >= (int)fb_height)
+    return;
+  vesa_row(y)[x] = color;
 }
 
 /*
@@ -122,8 +249,8 @@ void vesa_put_pixel(int x, int y, uint32_t color) {
   if (x < 0 || x >= (int)fb_width || y < 0 || y >= (int)fb_height)
     return;
 
-  uint32_t *row = (uint32_t *)((uint8_t *)framebuffer + y * fb_pitch);
-  row[x] = color;
+  vesa_row(y)[x] = color;
+  vesa_mark_dirty(x, y, 1, 1);
 }
 
 /*
@@ -135,16 +262,13 @@ uint32_t vesa_get_pixel(int x, int y) {
   if (x < 0 || x >= (int)fb_width || y < 0 || y >= (int)fb_height)
     return 0;
 
-  uint32_t *row = (uint32_t *)((uint8_t *)framebuffer + y * fb_pitch);
-  return row[x];
+  return vesa_row(y)[x];
 }
 
 /*
- * Draw horizontal line (fast)
+ * Horizontal line worker without dirty tracking (callers mark once)
  */
-void vesa_hline(int x, int y, int len, uint32_t color) {
-  if (!vesa_mode_active)
-    return;
+static void vesa_hline_raw(int x, int y, int len, uint32_t color) {
   if (y < 0 || y >= (int)fb_height)
     return;
   if (x < 0) {
@@ -156,33 +280,49 @@ void vesa_hline(int x, int y, int len, uint32_t color) {
   if (len <= 0)
     return;
 
-  uint32_t *row = (uint32_t *)((uint8_t *)framebuffer + y * fb_pitch);
-  for (int i = 0; i < len; i++) {
-    row[x + i] = color;
-  }
+  memset32(vesa_row(y) + x, color, len);
+}
+
+/*
+ * Draw horizontal line (fast)
+ */
+void vesa_hline(int x, int y, int len, uint32_t color) {
+  if (!vesa_mode_active)
+    return;
+  vesa_hline_raw(x, y, len, color);
+  vesa_mark_dirty(x, y, len, 1);
 }
 
 /*
  * Draw vertical line
  */
 void vesa_vline(int x, int y, int len, uint32_t color) {
+  if (!vesa_mode_active)
+    return;
   for (int i = 0; i < len; i++) {
-    vesa_put_pixel(x, y + i, color);
+    vesa_plot(x, y + i, color);
   }
+  vesa_mark_dirty(x, y, 1, len);
 }
 
 /*
  * Draw line (Bresenham)
  */
 void vesa_line(int x0, int y0, int x1, int y1, uint32_t color) {
+  if (!vesa_mode_active)
+    return;
+
   int dx = (x1 > x0) ? (x1 - x0) : (x0 - x1);
   int dy = (y1 > y0) ? (y1 - y0) : (y0 - y1);
   int sx = (x0 < x1) ? 1 : -1;
   int sy = (y0 < y1) ? 1 : -1;
   int err = dx - dy;
 
+  /* One bounding-box dirty entry covers the whole line */
+  vesa_mark_dirty((x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1, dx + 1, dy + 1);
+
   while (1) {
-    vesa_put_pixel(x0, y0, color);
+    vesa_plot(x0, y0, color);
     if (x0 == x1 && y0 == y1)
       break;
     int e2 = 2 * err;
@@ -211,9 +351,71 @@ void vesa_rect(int x, int y, int w, int h, uint32_t color) {
  * Fill rectangle
  */
 void vesa_fill_rect(int x, int y, int w, int h, uint32_t color) {
+  if (!vesa_mode_active)
+    return;
+  for (int i = 0; i < h; i++) {
+    vesa_hline_raw(x, y + i, w, color);
+  }
+  vesa_mark_dirty(x, y, w, h);
+}
+
+/*
+ * Copy a rectangle between regions of the draw target, row by row.
+ * Regions may overlap (window drag, scrolling), so the copy order is
+ * chosen to never overwrite source pixels before they are read.
+ */
+void vesa_blit(int sx, int sy, int dx, int dy, int w, int h) {
+  if (!vesa_mode_active)
+    return;
+
+  /* Clip both rectangles in step so source and dest stay aligned */
+  if (sx < 0) {
+    w += sx;
+    dx -= sx;
+    sx = 0;
+  }
+  if (sy < 0) {
+    h += sy;
+    dy -= sy;
+    sy = 0;
+  }
+  if (dx < 0) {
+    w += dx;
+    sx -= dx;
+    dx = 0;
+  }
+  if (dy < 0) {
+    h += dy;
+    sy -= dy;
+    dy = 0;
+  }
+  if (sx + w > (int)fb_width)
+    w = fb_width - sx;
+  if (dx + w > (int)fb_width)
+    w = fb_width - dx;
+  if (sy + h > (int)fb_height)
+    h = fb_height - sy;
+  if (dy + h > (int)fb_height)
+    h = fb_height - dy;
+  if (w <= 0 || h <= 0)
+    return;
+
+  int backward_rows = dy > sy;
+  int backward_cols = (dy == sy) && dx > sx;
+
   for (int i = 0; i < h; i++) {
-    vesa_hline(x, y + i, w, color);
+    int row = backward_rows ? h - 1 - i : i;
+    uint32_t *s = vesa_row(sy + row) + sx;
+    uint32_t *d = vesa_row(dy + row) + dx;
+    if (backward_cols) {
+      for (int j = w - 1; j >= 0; j--)
+        d[j] = s[j];
+    } else {
+      memcpy(d, s, w * 4);
+    }
   }
+
+  vesa_mark_dirty(dx, dy, w, h);
 }
 
 /*
@@ -321,34 +523,100 @@ static const uint8_t vesa_font[96][8] = {
 /*
  * Draw character at (x, y) - 8x8 font
  */
-void vesa_draw_char(int x, int y, char c, uint32_t color) {
+/* Glyph atlas: every possible 8-bit font row expanded once into
+ * per-pixel dword masks, so an on-screen character row blits
+ * branch-free as dst = (dst & ~m) | (color & m) instead of testing
+ * each font bit and bounds-checking each pixel. */
+static uint32_t glyph_row_mask[256][8];
+static int glyph_atlas_ready = 0;
+
+static void vesa_atlas_init(void) {
+  for (int bits = 0; bits < 256; bits++) {
+    for (int col = 0; col < 8; col++) {
+      glyph_row_mask[bits][col] = (bits & (0x80 >> col)) ? 0xFFFFFFFF : 0;
+    }
+  }
+  glyph_atlas_ready = 1;
+}
+
+static int vesa_glyph_index(char c) {
   if (c < 32 || c > 127)
     c = '?';
   int idx = c - 32;
   if (idx >= 96)
     idx = 0;
+  return idx;
+}
 
-  const uint8_t *glyph = vesa_font[idx];
+static void vesa_draw_char_raw(int x, int y, char c, uint32_t color) {
+  const uint8_t *glyph = vesa_font[vesa_glyph_index(c)];
+
+  if (glyph_atlas_ready && x >= 0 && y >= 0 && x + 8 <= (int)fb_width &&
+      y + 8 <= (int)fb_height) {
+    /* Fully on screen: mask-blit one row at a time */
+    for (int row = 0; row < 8; row++) {
+      const uint32_t *m = glyph_row_mask[glyph[row]];
+      uint32_t *dst = vesa_row(y + row) + x;
+      for (int col = 0; col < 8; col++) {
+        dst[col] = (dst[col] & ~m[col]) | (color & m[col]);
+      }
+    }
+    return;
+  }
 
+  /* Clipped fallback */
   for (int row = 0; row < 8; row++) {
     uint8_t bits = glyph[row];
     for (int col = 0; col < 8; col++) {
       if (bits & (0x80 >> col)) {
-        vesa_put_pixel(x + col, y + row, color);
+        vesa_plot(x + col, y + row, color);
       }
     }
   }
 }
 
+void vesa_draw_char(int x, int y, char c, uint32_t color) {
+  if (!vesa_mode_active)
+    return;
+  vesa_draw_char_raw(x, y, c, color);
+  vesa_mark_dirty(x, y, 8, 8);
+}
+
 /*
- * Draw string
+ * Draw string - one dirty entry for the whole run of glyphs. When the
+ * run is fully on screen it is rendered row-major: each screen row of
+ * the run is blitted in one pass, touching each backbuffer row once.
  */
 void vesa_draw_string(int x, int y, const char *str, uint32_t color) {
-  while (*str) {
-    vesa_draw_char(x, y, *str, color);
-    x += 8;
-    str++;
+  if (!vesa_mode_active)
+    return;
+
+  int len = 0;
+  while (str[len])
+    len++;
+  if (len == 0)
+    return;
+
+  if (glyph_atlas_ready && x >= 0 && y >= 0 && x + 8 * len <= (int)fb_width &&
+      y + 8 <= (int)fb_height) {
+    for (int row = 0; row < 8; row++) {
+      uint32_t *dst = vesa_row(y + row) + x;
+      for (int i = 0; i < len; i++) {
+        const uint8_t *glyph = vesa_font[vesa_glyph_index(str[i])];
+        const uint32_t *m = glyph_row_mask[glyph[row]];
+        for (int col = 0; col < 8; col++) {
+          dst[col] = (dst[col] & ~m[col]) | (color & m[col]);
+        }
+        dst += 8;
+      }
+    }
+  } else {
+    for (int i = 0; i < len; i++) {
+      vesa_draw_char_raw(x + 8 * i, y, str[i], color);
+    }
   }
+
+  vesa_mark_dirty(x, y, 8 * len, 8);
 }
 
 /*
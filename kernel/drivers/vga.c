@@ -1,121 +1,238 @@
-/*
- * NanoSec OS - VGA Text Mode Driver
- */
-
-#include "../kernel.h"
-
-/* VGA constants */
-#define VGA_MEMORY 0xB8000
-#define VGA_WIDTH 80
-#define VGA_HEIGHT 25
-#define VGA_CTRL_PORT 0x3D4
-#define VGA_DATA_PORT 0x3D5
-
-/* State */
-static uint16_t *vga_buffer = (uint16_t *)VGA_MEMORY;
-static int cursor_x = 0;
-static int cursor_y = 0;
-static vga_color_t current_color = VGA_COLOR_LIGHT_GREY;
-
-static inline uint16_t vga_entry(char c, uint8_t color) {
-  return (uint16_t)c | ((uint16_t)color << 8);
-}
-
-static inline uint8_t vga_color_byte(vga_color_t fg, vga_color_t bg) {
-  return fg | (bg << 4);
-}
-
-static void update_cursor(void) {
-  uint16_t pos = cursor_y * VGA_WIDTH + cursor_x;
-  outb(VGA_CTRL_PORT, 0x0F);
-  outb(VGA_DATA_PORT, (uint8_t)(pos & 0xFF));
-  outb(VGA_CTRL_PORT, 0x0E);
-  outb(VGA_DATA_PORT, (uint8_t)((pos >> 8) & 0xFF));
-}
-
-static void vga_scroll(void) {
-  uint8_t color = vga_color_byte(current_color, VGA_COLOR_BLACK);
-  for (int y = 0; y < VGA_HEIGHT - 1; y++) {
-    for (int x = 0; x < VGA_WIDTH; x++) {
-      vga_buffer[y * VGA_WIDTH + x] = vga_buffer[(y + 1) * VGA_WIDTH + x];
-    }
-  }
-  for (int x = 0; x < VGA_WIDTH; x++) {
-    vga_buffer[(VGA_HEIGHT - 1) * VGA_WIDTH + x] = vga_entry(' ', color);
-  }
-  cursor_y = VGA_HEIGHT - 1;
-}
-
-void vga_init(void) {
-  current_color = VGA_COLOR_LIGHT_GREY;
-  cursor_x = 0;
-  cursor_y = 0;
-  outb(VGA_CTRL_PORT, 0x0A);
-  outb(VGA_DATA_PORT, (inb(VGA_DATA_PORT) & 0xC0) | 0);
-  outb(VGA_CTRL_PORT, 0x0B);
-  outb(VGA_DATA_PORT, (inb(VGA_DATA_PORT) & 0xE0) | 15);
-  update_cursor();
-}
-
-void vga_clear(void) {
-  uint8_t color = vga_color_byte(current_color, VGA_COLOR_BLACK);
-  for (int i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
-    vga_buffer[i] = vga_entry(' ', color);
-  }
-  cursor_x = 0;
-  cursor_y = 0;
-  update_cursor();
-}
-
-/* External pipe capture functions */
-extern int pipe_is_active(void);
-extern void pipe_write_char(char c);
-
-void vga_putchar(char c) {
-  /* If pipe is capturing, send to buffer instead of screen */
-  if (pipe_is_active()) {
-    pipe_write_char(c);
-    return;
-  }
-
-  uint8_t color = vga_color_byte(current_color, VGA_COLOR_BLACK);
-
-  switch (c) {
-  case '\n':
-    cursor_x = 0;
-    cursor_y++;
-    break;
-  case '\r':
-    cursor_x = 0;
-    break;
-  case '\t':
-    cursor_x = (cursor_x + 8) & ~7;
-    break;
-  case '\b':
-    if (cursor_x > 0)
-      cursor_x--;
-    break;
-  default:
-    vga_buffer[cursor_y * VGA_WIDTH + cursor_x] = vga_entry(c, color);
-    cursor_x++;
-    break;
-  }
-
-  if (cursor_x >= VGA_WIDTH) {
-    cursor_x = 0;
-    cursor_y++;
-  }
-  if (cursor_y >= VGA_HEIGHT) {
-    vga_scroll();
-  }
-  update_cursor();
-}
-
-void vga_puts(const char *str) {
-  while (*str)
-    vga_putchar(*str++);
-}
-
-void vga_set_color(vga_color_t color) { current_color = color; }
-
-vga_color_t vga_get_color(void) { return current_color; }
+/*
+ * NanoSec OS - VGA Text Mode Driver
+ */
+
+#include "../kernel.h"
+
+/* VGA constants */
+#define VGA_MEMORY 0xB8000
+#define VGA_WIDTH 80
+#define VGA_HEIGHT 25
+#define VGA_CTRL_PORT 0x3D4
+#define VGA_DATA_PORT 0x3D5
+
+/* Virtual console: all output lands in a scrollback ring of SB_LINES
+ * lines in system memory; the visible 80x25 window is blitted into
+ * VGA memory with row-wide copies. Scrolling moves the window instead
+ * of shuffling VGA cells, and old output stays reachable with
+ * Shift-PgUp/PgDn. */
+#define SB_LINES 2000
+
+static uint16_t scrollback[SB_LINES * VGA_WIDTH];
+
+/* State */
+static uint16_t *vga_buffer = (uint16_t *)VGA_MEMORY;
+static int cur_line = 0;    /* Logical line the cursor is on (monotonic) */
+static int cursor_x = 0;
+static int view_offset = 0; /* Lines scrolled back from the live view */
+static vga_color_t current_color = VGA_COLOR_LIGHT_GREY;
+
+static inline uint16_t vga_entry(char c, uint8_t color) {
+  return (uint16_t)c | ((uint16_t)color << 8);
+}
+
+static inline uint8_t vga_color_byte(vga_color_t fg, vga_color_t bg) {
+  return fg | (bg << 4);
+}
+
+/* Ring slot for a logical line */
+static uint16_t *sb_line(int line) {
+  return &scrollback[(line % SB_LINES) * VGA_WIDTH];
+}
+
+/* Top logical line of the live (not scrolled back) window */
+static int live_top(void) {
+  int top = cur_line - (VGA_HEIGHT - 1);
+  return top < 0 ? 0 : top;
+}
+
+static void update_cursor(void) {
+  uint16_t pos;
+  if (view_offset > 0) {
+    /* Viewing history: park the cursor off screen */
+    pos = VGA_WIDTH * VGA_HEIGHT;
+  } else {
+    pos = (cur_line - live_top()) * VGA_WIDTH + cursor_x;
+  }
+  outb(VGA_CTRL_PORT, 0x0F);
+  outb(VGA_DATA_PORT, (uint8_t)(pos & 0xFF));
+  outb(VGA_CTRL_PORT, 0x0E);
+  outb(VGA_DATA_PORT, (uint8_t)((pos >> 8) & 0xFF));
+}
+
+/*
+ * Blit the visible window from the scrollback ring into VGA memory -
+ * one wide copy per row
+ */
+static void vga_refresh(void) {
+  int top = live_top() - view_offset;
+  if (top < 0)
+    top = 0;
+
+  for (int y = 0; y < VGA_HEIGHT; y++) {
+    memcpy(&vga_buffer[y * VGA_WIDTH], sb_line(top + y), VGA_WIDTH * 2);
+  }
+}
+
+/* Fill a logical line with blanks in the current color */
+static void sb_clear_line(int line) {
+  uint16_t blank =
+      vga_entry(' ', vga_color_byte(current_color, VGA_COLOR_BLACK));
+  uint16_t *row = sb_line(line);
+  for (int x = 0; x < VGA_WIDTH; x++)
+    row[x] = blank;
+}
+
+/*
+ * Move the cursor to the next logical line. Returns nonzero when the
+ * visible window moved (caller must refresh).
+ */
+static int advance_line(void) {
+  cur_line++;
+  sb_clear_line(cur_line);
+  return cur_line >= VGA_HEIGHT;
+}
+
+void vga_init(void) {
+  current_color = VGA_COLOR_LIGHT_GREY;
+  cur_line = 0;
+  cursor_x = 0;
+  view_offset = 0;
+  for (int i = 0; i < VGA_HEIGHT; i++)
+    sb_clear_line(i);
+  outb(VGA_CTRL_PORT, 0x0A);
+  outb(VGA_DATA_PORT, (inb(VGA_DATA_PORT) & 0xC0) | 0);
+  outb(VGA_CTRL_PORT, 0x0B);
+  outb(VGA_DATA_PORT, (inb(VGA_DATA_PORT) & 0xE0) | 15);
+  update_cursor();
+}
+
+void vga_clear(void) {
+  cur_line = 0;
+  cursor_x = 0;
+  view_offset = 0;
+  for (int i = 0; i < SB_LINES; i++)
+    sb_clear_line(i);
+  vga_refresh();
+  update_cursor();
+}
+
+/* External pipe capture functions */
+extern int pipe_is_active(void);
+extern void pipe_write_char(char c);
+extern void pipe_capture_write(const char *buf, size_t len);
+
+/*
+ * Put one character into the virtual buffer. Printable characters on
+ * the live view are also written straight through to VGA memory, so
+ * the common case stays a single cell store. Returns nonzero when the
+ * window moved and the caller must refresh.
+ */
+static int vga_emit(char c) {
+  uint8_t color = vga_color_byte(current_color, VGA_COLOR_BLACK);
+  int scrolled = 0;
+
+  switch (c) {
+  case '\n':
+    cursor_x = 0;
+    scrolled = advance_line();
+    break;
+  case '\r':
+    cursor_x = 0;
+    break;
+  case '\t':
+    cursor_x = (cursor_x + 8) & ~7;
+    break;
+  case '\b':
+    if (cursor_x > 0)
+      cursor_x--;
+    break;
+  default:
+    sb_line(cur_line)[cursor_x] = vga_entry(c, color);
+    vga_buffer[(cur_line - live_top()) * VGA_WIDTH + cursor_x] =
+        vga_entry(c, color);
+    cursor_x++;
+    break;
+  }
+
+  if (cursor_x >= VGA_WIDTH) {
+    cursor_x = 0;
+    scrolled |= advance_line();
+  }
+  return scrolled;
+}
+
+void vga_putchar(char c) {
+  /* If pipe is capturing, send to buffer instead of screen */
+  if (pipe_is_active()) {
+    pipe_write_char(c);
+    return;
+  }
+
+  /* New output snaps the view back to live */
+  if (view_offset > 0) {
+    view_offset = 0;
+    vga_refresh();
+  }
+
+  if (vga_emit(c))
+    vga_refresh();
+  update_cursor();
+}
+
+void vga_puts(const char *str) {
+  while (*str)
+    vga_putchar(*str++);
+}
+
+/*
+ * Bulk write: emit a whole buffer with one window refresh and one
+ * hardware cursor update at the end, however many scrolls happened
+ */
+void vga_write(const char *buf, size_t len) {
+  if (pipe_is_active()) {
+    pipe_capture_write(buf, len);
+    return;
+  }
+
+  if (view_offset > 0) {
+    view_offset = 0;
+    vga_refresh();
+  }
+
+  int scrolled = 0;
+  for (size_t i = 0; i < len; i++)
+    scrolled |= vga_emit(buf[i]);
+
+  if (scrolled)
+    vga_refresh();
+  update_cursor();
+}
+
+/*
+ * Scroll the view through history: positive lines go back in time,
+ * negative return toward the live view
+ */
+void vga_scrollback(int lines) {
+  /* Oldest line still held by the ring */
+  int oldest = cur_line - SB_LINES + 1;
+  if (oldest < 0)
+    oldest = 0;
+  int max_back = live_top() - oldest;
+
+  int offset = view_offset + lines;
+  if (offset > max_back)
+    offset = max_back;
+  if (offset < 0)
+    offset = 0;
+  if (offset == view_offset)
+    return;
+
+  view_offset = offset;
+  vga_refresh();
+  update_cursor();
+}
+
+void vga_set_color(vga_color_t color) { current_color = color; }
+
+vga_color_t vga_get_color(void) { return current_color; }
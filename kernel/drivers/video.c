@@ -215,6 +215,50 @@ void gfx_fill_rect(int x, int y, int w, int h, uint8_t color) {
   }
 }
 
+/*
+ * Wait for the start of the next vertical retrace so a repaint lands
+ * while the beam is off screen. Both loops are bounded - some
+ * emulators never flip the status bit and we must not hang on them.
+ */
+void gfx_wait_vsync(void) {
+  if (!graphics_mode)
+    return;
+
+  int timeout = 100000;
+  while (timeout-- && (inb(VGA_INSTAT_READ) & 0x08))
+    ;
+  timeout = 100000;
+  while (timeout-- && !(inb(VGA_INSTAT_READ) & 0x08))
+    ;
+}
+
+/*
+ * Blit one 8-pixel glyph row from a font bitmask - one mode/bounds
+ * check per row instead of one gfx_put_pixel call per set bit
+ */
+void gfx_glyph_row(int x, int y, uint8_t bits, uint8_t color) {
+  if (!graphics_mode || !bits)
+    return;
+  if (y < 0 || y >= GFX_HEIGHT)
+    return;
+
+  uint8_t *row = framebuffer + y * GFX_WIDTH;
+  if (x >= 0 && x + 8 <= GFX_WIDTH) {
+    for (int col = 0; col < 8; col++) {
+      if (bits & (0x80 >> col))
+        row[x + col] = color;
+    }
+    return;
+  }
+
+  /* Clipped at a screen edge */
+  for (int col = 0; col < 8; col++) {
+    int px = x + col;
+    if ((bits & (0x80 >> col)) && px >= 0 && px < GFX_WIDTH)
+      row[px] = color;
+  }
+}
+
 /*
  * Draw circle
  */
@@ -5,24 +5,19 @@
 
 #include "kernel.h"
 
-#define MAX_ENV_VARS 32
-#define MAX_VAR_NAME 32
-#define MAX_VAR_VALUE 128
+#define MAX_VAR_NAME VARTAB_NAME
+#define MAX_VAR_VALUE VARTAB_VALUE
+#define ENV_SLOTS 64 /* Power of two; holds up to 32 variables */
 
-typedef struct {
-  char name[MAX_VAR_NAME];
-  char value[MAX_VAR_VALUE];
-  int set;
-} env_var_t;
-
-static env_var_t env_vars[MAX_ENV_VARS];
+static vartab_entry_t env_slots[ENV_SLOTS];
+static vartab_t env_tab;
 static int env_initialized = 0;
 
 /*
  * Initialize environment
  */
 void env_init(void) {
-  memset(env_vars, 0, sizeof(env_vars));
+  vartab_init(&env_tab, env_slots, ENV_SLOTS);
 
   /* Set default variables */
   env_set("HOME", "/root");
@@ -39,51 +34,18 @@ void env_init(void) {
  * Set environment variable
  */
 int env_set(const char *name, const char *value) {
-  /* Check if exists */
-  for (int i = 0; i < MAX_ENV_VARS; i++) {
-    if (env_vars[i].set && strcmp(env_vars[i].name, name) == 0) {
-      strncpy(env_vars[i].value, value, MAX_VAR_VALUE - 1);
-      return 0;
-    }
-  }
-
-  /* Find empty slot */
-  for (int i = 0; i < MAX_ENV_VARS; i++) {
-    if (!env_vars[i].set) {
-      strncpy(env_vars[i].name, name, MAX_VAR_NAME - 1);
-      strncpy(env_vars[i].value, value, MAX_VAR_VALUE - 1);
-      env_vars[i].set = 1;
-      return 0;
-    }
-  }
-
-  return -1; /* No space */
+  return vartab_set(&env_tab, name, value);
 }
 
 /*
  * Get environment variable
  */
-const char *env_get(const char *name) {
-  for (int i = 0; i < MAX_ENV_VARS; i++) {
-    if (env_vars[i].set && strcmp(env_vars[i].name, name) == 0) {
-      return env_vars[i].value;
-    }
-  }
-  return NULL;
-}
+const char *env_get(const char *name) { return vartab_get(&env_tab, name); }
 
 /*
  * Unset environment variable
  */
-int env_unset(const char *name) {
-  for (int i = 0; i < MAX_ENV_VARS; i++) {
-    if (env_vars[i].set && strcmp(env_vars[i].name, name) == 0) {
-      env_vars[i].set = 0;
-      return 0;
-    }
-  }
-  return -1;
-}
+int env_unset(const char *name) { return vartab_unset(&env_tab, name); }
 
 /* ============ Shell Commands ============ */
 
@@ -95,9 +57,9 @@ void cmd_export(const char *args) {
   if (args[0] == '\0') {
     /* Show all */
     kprintf("\n");
-    for (int i = 0; i < MAX_ENV_VARS; i++) {
-      if (env_vars[i].set) {
-        kprintf("%s=%s\n", env_vars[i].name, env_vars[i].value);
+    for (int i = 0; i < ENV_SLOTS; i++) {
+      if (env_slots[i].state == VARTAB_USED) {
+        kprintf("%s=%s\n", env_slots[i].name, env_slots[i].value);
       }
     }
     kprintf("\n");
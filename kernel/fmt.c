@@ -0,0 +1,83 @@
+/*
+ * NanoSec OS - Integer Formatting Core
+ * ======================================
+ * Shared digit conversion for kprintf and the fs utils snprintf.
+ *
+ * Formatting runs on every logging, status and trace path, and the
+ * naive divide-per-digit loop costs a hardware divide per character.
+ * The decimal path here pulls two digits per divide out of a 100-entry
+ * pair table, and the hex path is a pure nibble-table lookup with no
+ * division at all.  Both entry points clip to the caller's capacity,
+ * so a narrow buffer truncates instead of overflowing.
+ */
+
+#include "kernel.h"
+
+/* "00".."99" packed as character pairs */
+static const char dec_pairs[] = "00010203040506070809"
+                                "10111213141516171819"
+                                "20212223242526272829"
+                                "30313233343536373839"
+                                "40414243444546474849"
+                                "50515253545556575859"
+                                "60616263646566676869"
+                                "70717273747576777879"
+                                "80818283848586878889"
+                                "90919293949596979899";
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/*
+ * Format an unsigned value into dst (capacity cap, not NUL-terminated).
+ * base is 10 or 16, width is the minimum field width (0 for none) and
+ * pad is the fill character (' ' or '0').  Returns characters written.
+ */
+int fmt_uint(char *dst, size_t cap, uint32_t value, int base, int width,
+             char pad) {
+  char tmp[12]; /* u32 is at most 10 decimal digits */
+  int n = 0;
+  int out = 0;
+
+  if (base == 16) {
+    do {
+      tmp[n++] = hex_digits[value & 0xF];
+      value >>= 4;
+    } while (value);
+  } else {
+    while (value >= 100) {
+      uint32_t pair = value % 100;
+      value /= 100;
+      tmp[n++] = dec_pairs[pair * 2 + 1];
+      tmp[n++] = dec_pairs[pair * 2];
+    }
+    if (value >= 10) {
+      tmp[n++] = dec_pairs[value * 2 + 1];
+      tmp[n++] = dec_pairs[value * 2];
+    } else {
+      tmp[n++] = '0' + (char)value;
+    }
+  }
+
+  while (width > n && (size_t)out < cap) {
+    dst[out++] = pad;
+    width--;
+  }
+  while (n > 0 && (size_t)out < cap)
+    dst[out++] = tmp[--n];
+  return out;
+}
+
+/*
+ * Signed wrapper; the sign occupies one column of the field width and
+ * is emitted before any zero padding, printf-style.
+ */
+int fmt_int(char *dst, size_t cap, int value, int base, int width, char pad) {
+  if (value < 0) {
+    if (cap == 0)
+      return 0;
+    dst[0] = '-';
+    return 1 + fmt_uint(dst + 1, cap - 1, 0u - (uint32_t)value, base,
+                        width > 0 ? width - 1 : 0, pad);
+  }
+  return fmt_uint(dst, cap, (uint32_t)value, base, width, pad);
+}
@@ -0,0 +1,240 @@
+/*
+ * NanoSec OS - Block Cache
+ * ==========================
+ * Sector cache between the filesystems and the IDE driver. Reads are
+ * served from memory when possible, writes are buffered (write-back)
+ * and flushed by bcache_sync or when a dirty block is evicted.
+ */
+
+#include "../kernel.h"
+
+/* External IDE functions */
+extern int ide_read(int drive, uint32_t lba, uint8_t count, void *buffer);
+extern int ide_write(int drive, uint32_t lba, uint8_t count,
+                     const void *buffer);
+
+#define BCACHE_SECTOR 512
+#define BCACHE_ORDER 3 /* 8 pages from the page allocator = 32KB */
+#define BCACHE_BLOCKS ((8 * 4096) / BCACHE_SECTOR)
+#define BCACHE_HASH 128 /* Power of 2 */
+
+typedef struct {
+  int drive;
+  uint32_t lba;
+  uint32_t stamp; /* Last-use tick for LRU */
+  int valid;
+  int dirty;
+  int hash_next;
+  uint8_t *data;
+} bcache_block_t;
+
+static bcache_block_t blocks[BCACHE_BLOCKS];
+static int hash_heads[BCACHE_HASH];
+static uint32_t bcache_clock;
+static int bcache_ready;
+
+/* Statistics for the bcache command */
+static uint32_t stat_hits;
+static uint32_t stat_misses;
+static uint32_t stat_writebacks;
+
+static uint32_t bcache_hash(int drive, uint32_t lba) {
+  return (((lba ^ (uint32_t)drive) * 2654435761u) >> 25) & (BCACHE_HASH - 1);
+}
+
+/*
+ * Lazy init: grab the data area from the page allocator on first use
+ */
+static int bcache_init(void) {
+  if (bcache_ready)
+    return 0;
+
+  uint32_t area = page_alloc_order(BCACHE_ORDER);
+  if (!area)
+    return -1;
+
+  for (int i = 0; i < BCACHE_BLOCKS; i++) {
+    blocks[i].data = (uint8_t *)(area + i * BCACHE_SECTOR);
+    blocks[i].valid = 0;
+    blocks[i].dirty = 0;
+  }
+  for (int i = 0; i < BCACHE_HASH; i++)
+    hash_heads[i] = -1;
+
+  bcache_ready = 1;
+  return 0;
+}
+
+/* Find a cached block, bumping its LRU stamp */
+static bcache_block_t *bcache_find(int drive, uint32_t lba) {
+  uint32_t bucket = bcache_hash(drive, lba);
+  for (int i = hash_heads[bucket]; i >= 0; i = blocks[i].hash_next) {
+    if (blocks[i].drive == drive && blocks[i].lba == lba) {
+      blocks[i].stamp = ++bcache_clock;
+      return &blocks[i];
+    }
+  }
+  return NULL;
+}
+
+/* Flush one dirty block to disk */
+static void bcache_flush_block(bcache_block_t *b) {
+  if (!b->dirty)
+    return;
+  ide_write(b->drive, b->lba, 1, b->data);
+  b->dirty = 0;
+  stat_writebacks++;
+}
+
+/* Unlink a block from its hash bucket */
+static void bcache_unhash(bcache_block_t *b) {
+  uint32_t bucket = bcache_hash(b->drive, b->lba);
+  int idx = b - blocks;
+  int *link = &hash_heads[bucket];
+  while (*link >= 0 && *link != idx)
+    link = &blocks[*link].hash_next;
+  if (*link == idx)
+    *link = b->hash_next;
+}
+
+/*
+ * Claim a block for (drive, lba): evict the least recently used
+ * entry, flushing it first if dirty, and rehash it for the new LBA.
+ * The caller fills data and sets valid/dirty.
+ */
+static bcache_block_t *bcache_claim(int drive, uint32_t lba) {
+  bcache_block_t *victim = &blocks[0];
+
+  for (int i = 0; i < BCACHE_BLOCKS; i++) {
+    if (!blocks[i].valid) {
+      victim = &blocks[i];
+      break;
+    }
+    if (victim->valid && blocks[i].stamp < victim->stamp)
+      victim = &blocks[i];
+  }
+
+  if (victim->valid) {
+    bcache_flush_block(victim);
+    bcache_unhash(victim);
+  }
+
+  victim->drive = drive;
+  victim->lba = lba;
+  victim->stamp = ++bcache_clock;
+  victim->valid = 0;
+  victim->dirty = 0;
+
+  uint32_t bucket = bcache_hash(drive, lba);
+  victim->hash_next = hash_heads[bucket];
+  hash_heads[bucket] = victim - blocks;
+
+  return victim;
+}
+
+/*
+ * Read one sector through the cache
+ */
+int bcache_read(int drive, uint32_t lba, void *buffer) {
+  if (bcache_init() < 0)
+    return ide_read(drive, lba, 1, buffer); /* No memory: pass through */
+
+  bcache_block_t *b = bcache_find(drive, lba);
+  if (b && b->valid) {
+    stat_hits++;
+    memcpy(buffer, b->data, BCACHE_SECTOR);
+    return 0;
+  }
+
+  stat_misses++;
+  if (!b)
+    b = bcache_claim(drive, lba);
+  if (ide_read(drive, lba, 1, b->data) < 0) {
+    bcache_unhash(b);
+    b->valid = 0;
+    return -1;
+  }
+  b->valid = 1;
+  memcpy(buffer, b->data, BCACHE_SECTOR);
+  return 0;
+}
+
+/*
+ * Write one sector: buffered, flushed on sync or eviction
+ */
+int bcache_write(int drive, uint32_t lba, const void *buffer) {
+  if (bcache_init() < 0)
+    return ide_write(drive, lba, 1, buffer); /* No memory: pass through */
+
+  bcache_block_t *b = bcache_find(drive, lba);
+  if (!b)
+    b = bcache_claim(drive, lba); /* Full overwrite: no read needed */
+
+  memcpy(b->data, buffer, BCACHE_SECTOR);
+  b->valid = 1;
+  b->dirty = 1;
+  return 0;
+}
+
+/* Completion callback for scheduled writebacks */
+static void bcache_sync_done(int status, void *ctx) {
+  bcache_block_t *b = (bcache_block_t *)ctx;
+  if (status == 0) {
+    b->dirty = 0;
+    stat_writebacks++;
+  }
+}
+
+/*
+ * Flush all dirty blocks to disk. The blocks go through the I/O
+ * scheduler, which sorts them by LBA and merges adjacent sectors
+ * into multi-sector writes.
+ */
+void bcache_sync(void) {
+  if (!bcache_ready)
+    return;
+  for (int i = 0; i < BCACHE_BLOCKS; i++) {
+    bcache_block_t *b = &blocks[i];
+    if (!b->valid || !b->dirty)
+      continue;
+    if (io_submit(b->drive, b->lba, 1, b->data, 1, bcache_sync_done, b) < 0) {
+      io_flush(); /* Queue full: drain and retry */
+      if (io_submit(b->drive, b->lba, 1, b->data, 1, bcache_sync_done, b) < 0)
+        bcache_flush_block(b);
+    }
+  }
+  io_flush();
+}
+
+/*
+ * bcache command - show cache statistics, sync on request
+ */
+void cmd_bcache(const char *args) {
+  if (strcmp(args, "sync") == 0) {
+    bcache_sync();
+    kprintf("bcache: synced\n");
+    return;
+  }
+
+  int cached = 0, dirty = 0;
+  for (int i = 0; i < BCACHE_BLOCKS; i++) {
+    if (blocks[i].valid) {
+      cached++;
+      if (blocks[i].dirty)
+        dirty++;
+    }
+  }
+
+  kprintf("\nBlock Cache\n");
+  kprintf("===========\n");
+  kprintf("  Blocks:     %d/%d cached (%d dirty)\n", cached, BCACHE_BLOCKS,
+          dirty);
+  kprintf("  Hits:       %d\n", stat_hits);
+  kprintf("  Misses:     %d\n", stat_misses);
+  kprintf("  Writebacks: %d\n", stat_writebacks);
+  if (stat_hits + stat_misses > 0) {
+    kprintf("  Hit rate:   %d%%\n",
+            (stat_hits * 100) / (stat_hits + stat_misses));
+  }
+  kprintf("\nUse 'bcache sync' to flush dirty blocks\n\n");
+}
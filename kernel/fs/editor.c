@@ -2,114 +2,345 @@
  * NanoSec OS - Simple Text Editor
  * =================================
  * nedit - NanoSec Editor (like nano/vi)
+ *
+ * Text lives in a gap buffer: the cursor IS the gap, so typing is a
+ * store into the gap and backspace shrinks it - no tail shifting.
+ * The line index is split the same way: entries up to the cursor's
+ * line are offsets from the front of the buffer, entries after it
+ * are offsets from the END, so an insertion at the cursor moves no
+ * index entry; crossing a line boundary converts exactly one.
+ *
+ * The editor paints the VGA text page directly (the scrollback
+ * console has no notion of rows): a keystroke redraws only its own
+ * line, structural edits repaint from the edited line down, and
+ * only scrolling repaints the whole window.
  */
 
 #include "../kernel.h"
 
-#define EDIT_MAX_LINES 50
-#define EDIT_MAX_COLS 80
-
-static char edit_buffer[EDIT_MAX_LINES][EDIT_MAX_COLS];
-static int edit_lines = 0;
-static int edit_cursor_line = 0;
-static int edit_cursor_col = 0;
-static char edit_filename[64];
-static int edit_modified = 0;
+#define ED_ROWS 22 /* Content rows (row 0 header, row 24 footer) */
+#define ED_COLS 80
+#define ED_MAX_LINES 2048
+#define ED_INITIAL 4096
+
+#define ED_VRAM ((volatile uint16_t *)0xB8000)
+#define ED_ATTR_TEXT 0x07 /* Grey on black */
+#define ED_ATTR_BAR 0x30  /* Black on cyan */
+#define ED_ATTR_FOOT 0x20 /* Black on green */
+
+static char *ed_buf = NULL;
+static int ed_cap = 0;
+static int ed_gs = 0, ed_ge = 0; /* Gap is [ed_gs, ed_ge) */
+
+/* starts[i]: offset of line i - from the front for i <= ed_cur_line,
+ * from the buffer end for i > ed_cur_line */
+static int ed_starts[ED_MAX_LINES];
+static int ed_nlines = 0;
+static int ed_cur_line = 0, ed_cur_col = 0;
+static int ed_top = 0; /* First visible line */
+static int ed_modified = 0;
+static char ed_filename[64];
 
 /* External filesystem functions */
 extern int fs_write(const char *name, const char *data, size_t len);
-extern int fs_read(const char *name, char *buf, size_t max);
 
-/*
- * Redraw editor screen
- */
-static void edit_redraw(void) {
-  vga_clear();
+/* ============ Gap buffer ============ */
+
+/* Double the buffer; back half moves to the new end, so the
+ * end-relative index entries keep their values */
+static int ed_grow(void) {
+  int new_cap = ed_cap * 2;
+  char *nb = kmalloc(new_cap);
+  if (!nb)
+    return -1;
+  memcpy(nb, ed_buf, ed_gs);
+  int back = ed_cap - ed_ge;
+  memcpy(nb + new_cap - back, ed_buf + ed_ge, back);
+  kfree(ed_buf);
+  ed_buf = nb;
+  ed_ge = new_cap - back;
+  ed_cap = new_cap;
+  return 0;
+}
 
-  /* Header */
-  vga_set_color(VGA_COLOR_BLACK + (VGA_COLOR_CYAN << 4));
-  kprintf(" NanoSec Editor - %s%s", edit_filename,
-          edit_modified ? " [modified]" : "");
-  for (int i = strlen(edit_filename) + 20; i < 80; i++)
-    kprintf(" ");
-  vga_set_color(VGA_COLOR_LIGHT_GREY);
-  kprintf("\n");
+/* Move the cursor (= gap) one character left/right, keeping the
+ * split line index consistent when a newline crosses the gap */
+static int ed_left(void) {
+  if (ed_gs == 0)
+    return 0;
+  char c = ed_buf[ed_gs - 1];
+  ed_gs--;
+  ed_ge--;
+  ed_buf[ed_ge] = c;
+  if (c == '\n') {
+    ed_starts[ed_cur_line] = ed_cap - (ed_ge + 1); /* Now end-relative */
+    ed_cur_line--;
+    ed_cur_col = ed_gs - ed_starts[ed_cur_line];
+  } else {
+    ed_cur_col--;
+  }
+  return 1;
+}
 
-  /* Content */
-  for (int i = 0; i < 22; i++) {
-    if (i < edit_lines) {
-      kprintf("%s", edit_buffer[i]);
-    }
-    kprintf("\n");
+static int ed_right(void) {
+  if (ed_ge == ed_cap)
+    return 0;
+  char c = ed_buf[ed_ge];
+  ed_buf[ed_gs] = c;
+  ed_gs++;
+  ed_ge++;
+  if (c == '\n') {
+    ed_cur_line++;
+    ed_starts[ed_cur_line] = ed_gs; /* Now front-relative */
+    ed_cur_col = 0;
+  } else {
+    ed_cur_col++;
   }
+  return 1;
+}
 
-  /* Footer */
-  vga_set_color(VGA_COLOR_BLACK + (VGA_COLOR_GREEN << 4));
-  kprintf(" ^S Save  ^Q Quit  ^G Help                                Line %d, "
-          "Col %d ",
-          edit_cursor_line + 1, edit_cursor_col + 1);
-  vga_set_color(VGA_COLOR_LIGHT_GREY);
+static void ed_up(void) {
+  if (ed_cur_line == 0)
+    return;
+  int target = ed_cur_col;
+  int line = ed_cur_line;
+  while (ed_cur_line == line)
+    ed_left();
+  while (ed_cur_col > target)
+    ed_left();
 }
 
-/*
- * Load file into editor
- */
-static int edit_load(const char *filename) {
-  char buf[4096];
-  int len = fs_read(filename, buf, sizeof(buf) - 1);
+static void ed_down(void) {
+  if (ed_cur_line >= ed_nlines - 1)
+    return;
+  int target = ed_cur_col;
+  int line = ed_cur_line;
+  while (ed_cur_line == line)
+    ed_right();
+  while (ed_cur_col < target && ed_ge < ed_cap && ed_buf[ed_ge] != '\n')
+    ed_right();
+}
 
-  memset(edit_buffer, 0, sizeof(edit_buffer));
-  edit_lines = 0;
-  edit_cursor_line = 0;
-  edit_cursor_col = 0;
-  edit_modified = 0;
-  strncpy(edit_filename, filename, 63);
+/* Insert at the cursor: a store into the gap, O(1) amortized */
+static void ed_insert(char c) {
+  if (ed_gs == ed_ge && ed_grow() < 0)
+    return;
+  if (c == '\n' && ed_nlines >= ED_MAX_LINES)
+    return;
+  ed_buf[ed_gs++] = c;
+  ed_modified = 1;
+  if (c == '\n') {
+    for (int i = ed_nlines; i > ed_cur_line + 1; i--)
+      ed_starts[i] = ed_starts[i - 1];
+    ed_nlines++;
+    ed_cur_line++;
+    ed_starts[ed_cur_line] = ed_gs;
+    ed_cur_col = 0;
+  } else {
+    ed_cur_col++;
+  }
+}
 
-  if (len < 0) {
-    /* New file */
-    edit_lines = 1;
-    return 0;
+/* Delete before the cursor; returns 1 when two lines joined */
+static int ed_backspace(void) {
+  if (ed_gs == 0)
+    return -1;
+  char c = ed_buf[ed_gs - 1];
+  ed_gs--;
+  ed_modified = 1;
+  if (c == '\n') {
+    for (int i = ed_cur_line; i < ed_nlines - 1; i++)
+      ed_starts[i] = ed_starts[i + 1];
+    ed_nlines--;
+    ed_cur_line--;
+    ed_cur_col = ed_gs - ed_starts[ed_cur_line];
+    return 1;
+  }
+  ed_cur_col--;
+  return 0;
+}
+
+/* Copy line idx into out (clipped, no newline); returns length */
+static int ed_get_line(int idx, char *out, int max) {
+  int n = 0;
+
+  if (idx < ed_cur_line) {
+    int s = ed_starts[idx];
+    int e = ed_starts[idx + 1] - 1;
+    while (s < e && n < max)
+      out[n++] = ed_buf[s++];
+  } else if (idx == ed_cur_line) {
+    int s = ed_starts[idx];
+    while (s < ed_gs && n < max)
+      out[n++] = ed_buf[s++];
+    int e = (idx + 1 < ed_nlines) ? ed_cap - ed_starts[idx + 1] - 1 : ed_cap;
+    s = ed_ge;
+    while (s < e && n < max)
+      out[n++] = ed_buf[s++];
+  } else {
+    int s = ed_cap - ed_starts[idx];
+    int e = (idx + 1 < ed_nlines) ? ed_cap - ed_starts[idx + 1] - 1 : ed_cap;
+    while (s < e && n < max)
+      out[n++] = ed_buf[s++];
   }
+  return n;
+}
 
-  buf[len] = '\0';
-
-  /* Parse lines */
-  int line = 0, col = 0;
-  for (int i = 0; i < len && line < EDIT_MAX_LINES; i++) {
-    if (buf[i] == '\n') {
-      edit_buffer[line][col] = '\0';
-      line++;
-      col = 0;
-    } else if (col < EDIT_MAX_COLS - 1) {
-      edit_buffer[line][col++] = buf[i];
+/* ============ Screen ============ */
+
+static void ed_put_row(int row, const char *text, int len, uint8_t attr) {
+  volatile uint16_t *dst = ED_VRAM + row * ED_COLS;
+  for (int x = 0; x < ED_COLS; x++)
+    dst[x] = ((uint16_t)attr << 8) | (uint8_t)(x < len ? text[x] : ' ');
+}
+
+static void ed_draw_line(int idx) {
+  char row[ED_COLS];
+  int len = ed_get_line(idx, row, ED_COLS);
+  ed_put_row(idx - ed_top + 1, row, len, ED_ATTR_TEXT);
+}
+
+static void ed_draw_header(void) {
+  char bar[ED_COLS];
+  int n = 0;
+  const char *p = " NanoSec Editor - ";
+  while (*p)
+    bar[n++] = *p++;
+  for (p = ed_filename; *p && n < 60; p++)
+    bar[n++] = *p;
+  if (ed_modified) {
+    p = " [modified]";
+    while (*p)
+      bar[n++] = *p++;
+  }
+  ed_put_row(0, bar, n, ED_ATTR_BAR);
+}
+
+static void ed_draw_footer(void) {
+  char bar[ED_COLS];
+  int n = 0;
+  const char *p = " ^S Save  ^Q Quit  arrows move                    Line ";
+  while (*p)
+    bar[n++] = *p++;
+  n += fmt_int(bar + n, 8, ed_cur_line + 1, 10, 0, ' ');
+  bar[n++] = ',';
+  bar[n++] = ' ';
+  p = "Col ";
+  while (*p)
+    bar[n++] = *p++;
+  n += fmt_int(bar + n, 8, ed_cur_col + 1, 10, 0, ' ');
+  ed_put_row(24, bar, n, ED_ATTR_FOOT);
+}
+
+static void ed_cursor_update(void) {
+  int col = ed_cur_col < ED_COLS - 1 ? ed_cur_col : ED_COLS - 1;
+  int pos = (ed_cur_line - ed_top + 1) * ED_COLS + col;
+  outb(0x3D4, 14);
+  outb(0x3D5, (pos >> 8) & 0xFF);
+  outb(0x3D4, 15);
+  outb(0x3D5, pos & 0xFF);
+}
+
+/* Full repaint - scroll and startup only */
+static void ed_draw_full(void) {
+  ed_draw_header();
+  for (int r = 0; r < ED_ROWS; r++) {
+    int idx = ed_top + r;
+    if (idx < ed_nlines) {
+      ed_draw_line(idx);
+    } else {
+      ed_put_row(r + 1, "", 0, ED_ATTR_TEXT);
     }
   }
+  ed_put_row(23, "", 0, ED_ATTR_TEXT);
+  ed_draw_footer();
+  ed_cursor_update();
+}
 
-  edit_lines = line + 1;
-  if (edit_lines < 1)
-    edit_lines = 1;
+/* ============ File I/O ============ */
+
+/*
+ * Load through the streaming handles - file size is capped by the
+ * heap, not a stack buffer
+ */
+static int edit_load(const char *filename) {
+  ed_cap = ED_INITIAL;
+  ed_buf = kmalloc(ed_cap);
+  if (!ed_buf) {
+    kprintf("nedit: out of memory\n");
+    return -1;
+  }
+  ed_gs = 0;
+  ed_ge = ed_cap;
+  ed_nlines = 1;
+  ed_starts[0] = 0;
+  ed_cur_line = 0;
+  ed_cur_col = 0;
+  ed_top = 0;
+  ed_modified = 0;
+  strncpy(ed_filename, filename, 63);
+  ed_filename[63] = '\0';
+
+  int fd = fs_open(filename, 0);
+  if (fd >= 0) {
+    char chunk[512];
+    int len;
+    while ((len = fs_pread(fd, chunk, sizeof(chunk))) > 0) {
+      while (ed_ge - ed_gs < len) {
+        if (ed_grow() < 0) {
+          fs_close(fd);
+          kfree(ed_buf);
+          ed_buf = NULL;
+          kprintf("nedit: out of memory\n");
+          return -1;
+        }
+      }
+      memcpy(ed_buf + ed_gs, chunk, len);
+      ed_gs += len;
+    }
+    fs_close(fd);
+
+    /* Index the lines (all front-relative; cursor is at the end).
+     * A file the index cannot describe is refused outright: every
+     * newline left out of the index would still be crossed by the
+     * walk-back below and push ed_cur_line past the array. */
+    for (int p = 0; p < ed_gs; p++) {
+      if (ed_buf[p] != '\n')
+        continue;
+      if (ed_nlines >= ED_MAX_LINES) {
+        kfree(ed_buf);
+        ed_buf = NULL;
+        kprintf("nedit: %s has more than %d lines\n", filename, ED_MAX_LINES);
+        return -1;
+      }
+      ed_starts[ed_nlines++] = p + 1;
+    }
+    ed_cur_line = ed_nlines - 1;
+    ed_cur_col = ed_gs - ed_starts[ed_cur_line];
 
+    /* Walk the gap back to the top of the file */
+    while (ed_left())
+      ;
+  }
   return 0;
 }
 
 /*
- * Save file from editor
+ * Save: truncating write of the front half, then one append of the
+ * back half - never a contiguous copy of the whole text
  */
 static int edit_save(void) {
-  char buf[4096];
-  int pos = 0;
-
-  for (int i = 0; i < edit_lines && pos < 4000; i++) {
-    int len = strlen(edit_buffer[i]);
-    memcpy(&buf[pos], edit_buffer[i], len);
-    pos += len;
-    buf[pos++] = '\n';
+  fs_write(ed_filename, ed_buf, ed_gs);
+
+  int back = ed_cap - ed_ge;
+  if (back > 0) {
+    int fd = fs_open(ed_filename, 0);
+    if (fd < 0)
+      return -1;
+    fs_append(fd, ed_buf + ed_ge, back);
+    fs_close(fd);
   }
-  buf[pos] = '\0';
-
-  fs_write(edit_filename, buf, pos);
-  edit_modified = 0;
-
+  ed_modified = 0;
   return 0;
 }
 
@@ -122,61 +353,79 @@ void cmd_nedit(const char *args) {
     return;
   }
 
-  /* Load file */
-  edit_load(args);
-  edit_redraw();
+  if (edit_load(args) < 0) /* edit_load reports the reason */
+    return;
+  ed_draw_full();
 
   /* Editor loop */
   while (1) {
     char c = keyboard_getchar();
+    int structural = 0; /* Lines appeared or vanished */
+    int moved_only = 0;
 
-    /* Ctrl+Q = Quit */
     if (c == 17) { /* Ctrl+Q */
       break;
+    } else if (c == 19) { /* Ctrl+S */
+      edit_save();
+    } else if (c == 0x10) { /* Up */
+      ed_up();
+      moved_only = 1;
+    } else if (c == 0x0E) { /* Down */
+      ed_down();
+      moved_only = 1;
+    } else if (c == 0x02) { /* Left */
+      ed_left();
+      moved_only = 1;
+    } else if (c == 0x06) { /* Right */
+      ed_right();
+      moved_only = 1;
+    } else if (c == '\n') {
+      ed_insert('\n');
+      structural = 1;
+    } else if (c == '\b') {
+      structural = (ed_backspace() == 1);
+    } else if (c >= 32 && c < 127) {
+      ed_insert(c);
+    } else {
+      continue;
     }
 
-    /* Ctrl+S = Save */
-    if (c == 19) { /* Ctrl+S */
-      edit_save();
-      edit_redraw();
+    /* Scroll if the cursor left the window - full repaint */
+    if (ed_cur_line < ed_top) {
+      ed_top = ed_cur_line;
+      ed_draw_full();
+      continue;
+    }
+    if (ed_cur_line >= ed_top + ED_ROWS) {
+      ed_top = ed_cur_line - ED_ROWS + 1;
+      ed_draw_full();
       continue;
     }
 
-    /* Handle special keys */
-    if (c == '\n') {
-      /* New line */
-      if (edit_lines < EDIT_MAX_LINES - 1) {
-        edit_cursor_line++;
-        edit_cursor_col = 0;
-        if (edit_cursor_line >= edit_lines) {
-          edit_lines = edit_cursor_line + 1;
-        }
-        edit_modified = 1;
-      }
-    } else if (c == '\b') {
-      /* Backspace */
-      if (edit_cursor_col > 0) {
-        edit_cursor_col--;
-        /* Shift line left */
-        char *line = edit_buffer[edit_cursor_line];
-        int len = strlen(line);
-        for (int i = edit_cursor_col; i < len; i++) {
-          line[i] = line[i + 1];
-        }
-        edit_modified = 1;
-      }
-    } else if (c >= 32 && c < 127) {
-      /* Regular character */
-      if (edit_cursor_col < EDIT_MAX_COLS - 2) {
-        edit_buffer[edit_cursor_line][edit_cursor_col++] = c;
-        edit_buffer[edit_cursor_line][edit_cursor_col] = '\0';
-        edit_modified = 1;
+    if (structural) {
+      /* Lines below the edit shifted: repaint from there down */
+      int from = ed_cur_line > 0 ? ed_cur_line - 1 : 0;
+      if (from < ed_top)
+        from = ed_top;
+      for (int idx = from; idx < ed_top + ED_ROWS; idx++) {
+        if (idx < ed_nlines)
+          ed_draw_line(idx);
+        else
+          ed_put_row(idx - ed_top + 1, "", 0, ED_ATTR_TEXT);
       }
+    } else if (!moved_only) {
+      /* A keystroke touches exactly its own line */
+      ed_draw_line(ed_cur_line);
     }
 
-    edit_redraw();
+    ed_draw_header();
+    ed_draw_footer();
+    ed_cursor_update();
   }
 
+  kfree(ed_buf);
+  ed_buf = NULL;
+
   /* Clear and return to shell */
   vga_clear();
   kprintf("Exited editor.\n");
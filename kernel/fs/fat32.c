@@ -86,11 +86,25 @@ static struct {
   uint32_t sectors_per_cluster;
   uint32_t bytes_per_cluster;
   uint32_t fat_size;
-  uint8_t *fat_cache; /* One sector of FAT */
-  uint32_t fat_cache_sector;
   uint8_t *cluster_buf; /* One cluster buffer */
 } fat32;
 
+/* FAT sector cache: a few 512B slots with LRU replacement. Walking a
+ * cluster chain touches the same FAT sector 128 times in a row, and
+ * directory scans bounce between a handful of sectors, so a small
+ * cache eliminates nearly all FAT I/O. */
+#define FAT_CACHE_SLOTS 8
+
+typedef struct {
+  uint32_t sector;
+  uint32_t stamp; /* Last-use tick for LRU */
+  int valid;
+  uint8_t data[512];
+} fat_cache_slot_t;
+
+static fat_cache_slot_t fat_cache[FAT_CACHE_SLOTS];
+static uint32_t fat_cache_clock;
+
 /* Sector buffer */
 static uint8_t sector_buf[512];
 
@@ -99,6 +113,36 @@ extern int ide_read(int drive, uint32_t lba, uint8_t count, void *buffer);
 extern int ide_write(int drive, uint32_t lba, uint8_t count,
                      const void *buffer);
 
+/*
+ * Look up a FAT sector in the cache, filling the LRU slot on a miss.
+ * Returns a pointer to the cached sector, or NULL on I/O error.
+ */
+static uint8_t *fat32_fat_sector(uint32_t sector) {
+  fat_cache_slot_t *victim = &fat_cache[0];
+
+  for (int i = 0; i < FAT_CACHE_SLOTS; i++) {
+    fat_cache_slot_t *slot = &fat_cache[i];
+    if (slot->valid && slot->sector == sector) {
+      slot->stamp = ++fat_cache_clock;
+      return slot->data;
+    }
+    /* Track the least recently used (or any invalid) slot */
+    if (!slot->valid || (victim->valid && slot->stamp < victim->stamp)) {
+      victim = slot;
+    }
+  }
+
+  if (bcache_read(fat32.drive, sector, victim->data) < 0) {
+    victim->valid = 0;
+    return NULL;
+  }
+
+  victim->sector = sector;
+  victim->stamp = ++fat_cache_clock;
+  victim->valid = 1;
+  return victim->data;
+}
+
 /*
  * Read FAT entry
  */
@@ -107,34 +151,29 @@ static uint32_t fat32_read_fat(uint32_t cluster) {
   uint32_t sector = fat32.fat_start + (offset / 512);
   uint32_t entry_offset = offset % 512;
 
-  /* Read FAT sector if not cached */
-  if (fat32.fat_cache_sector != sector) {
-    ide_read(fat32.drive, sector, 1, fat32.fat_cache);
-    fat32.fat_cache_sector = sector;
-  }
+  uint8_t *data = fat32_fat_sector(sector);
+  if (!data)
+    return 0x0FFFFFFF; /* Treat I/O error as end of chain */
 
-  return *(uint32_t *)(fat32.fat_cache + entry_offset) & 0x0FFFFFFF;
+  return *(uint32_t *)(data + entry_offset) & 0x0FFFFFFF;
 }
 
 /*
- * Write FAT entry
+ * Write FAT entry (write-through: the cached copy stays current)
  */
 static void fat32_write_fat(uint32_t cluster, uint32_t value) {
   uint32_t offset = cluster * 4;
   uint32_t sector = fat32.fat_start + (offset / 512);
   uint32_t entry_offset = offset % 512;
 
-  /* Read FAT sector if not cached */
-  if (fat32.fat_cache_sector != sector) {
-    ide_read(fat32.drive, sector, 1, fat32.fat_cache);
-    fat32.fat_cache_sector = sector;
-  }
+  uint8_t *data = fat32_fat_sector(sector);
+  if (!data)
+    return;
 
-  *(uint32_t *)(fat32.fat_cache + entry_offset) =
-      (*(uint32_t *)(fat32.fat_cache + entry_offset) & 0xF0000000) |
-      (value & 0x0FFFFFFF);
+  *(uint32_t *)(data + entry_offset) =
+      (*(uint32_t *)(data + entry_offset) & 0xF0000000) | (value & 0x0FFFFFFF);
 
-  ide_write(fat32.drive, sector, 1, fat32.fat_cache);
+  bcache_write(fat32.drive, sector, data);
 }
 
 /*
@@ -142,7 +181,15 @@ static void fat32_write_fat(uint32_t cluster, uint32_t value) {
  */
 static int fat32_read_cluster(uint32_t cluster, void *buffer) {
   uint32_t lba = fat32.data_start + (cluster - 2) * fat32.sectors_per_cluster;
-  return ide_read(fat32.drive, lba, fat32.sectors_per_cluster, buffer);
+  uint8_t *buf = (uint8_t *)buffer;
+
+  /* Sector by sector through the block cache, so re-reading the same
+   * directory or tail cluster costs no disk I/O */
+  for (uint32_t s = 0; s < fat32.sectors_per_cluster; s++) {
+    if (bcache_read(fat32.drive, lba + s, buf + s * 512) < 0)
+      return -1;
+  }
+  return 0;
 }
 
 /*
@@ -152,7 +199,7 @@ int fat32_mount(int drive) {
   fat32_bpb_t *bpb = (fat32_bpb_t *)sector_buf;
 
   /* Read boot sector */
-  if (ide_read(drive, 0, 1, sector_buf) < 0) {
+  if (bcache_read(drive, 0, sector_buf) < 0) {
     return -1;
   }
 
@@ -176,14 +223,15 @@ int fat32_mount(int drive) {
   fat32.root_cluster = bpb->root_cluster;
 
   /* Allocate buffers */
-  fat32.fat_cache = kmalloc(512);
   fat32.cluster_buf = kmalloc(fat32.bytes_per_cluster);
-  fat32.fat_cache_sector = 0xFFFFFFFF;
-
-  if (!fat32.fat_cache || !fat32.cluster_buf) {
+  if (!fat32.cluster_buf) {
     return -4;
   }
 
+  /* Invalidate the FAT sector cache */
+  memset(fat_cache, 0, sizeof(fat_cache));
+  fat_cache_clock = 0;
+
   fat32.mounted = 1;
 
   kprintf("  [OK] FAT32 (cluster size: %d bytes)\n", fat32.bytes_per_cluster);
@@ -271,20 +319,48 @@ int fat32_read_file(uint32_t start_cluster, void *buffer, uint32_t size) {
   uint32_t bytes_read = 0;
   uint32_t cluster = start_cluster;
 
-  while (bytes_read < size && cluster < 0x0FFFFFF8) {
-    if (fat32_read_cluster(cluster, fat32.cluster_buf) < 0) {
-      return -1;
-    }
+  /* ide_read takes a uint8_t sector count, so cap each run at 255
+   * sectors' worth of clusters */
+  uint32_t max_run = 255 / fat32.sectors_per_cluster;
+  if (max_run == 0)
+    max_run = 1;
 
-    uint32_t to_copy = fat32.bytes_per_cluster;
-    if (bytes_read + to_copy > size) {
-      to_copy = size - bytes_read;
-    }
+  while (bytes_read < size && cluster < 0x0FFFFFF8) {
+    uint32_t remaining = size - bytes_read;
+
+    if (remaining >= fat32.bytes_per_cluster) {
+      /* Whole clusters left: walk the FAT for a contiguous run and
+       * read it with a single multi-sector transfer, straight into
+       * the caller's buffer */
+      uint32_t want = remaining / fat32.bytes_per_cluster;
+      if (want > max_run)
+        want = max_run;
+
+      uint32_t run = 1;
+      uint32_t next = fat32_read_fat(cluster);
+      while (run < want && next == cluster + run) {
+        next = fat32_read_fat(next);
+        run++;
+      }
 
-    memcpy(buf + bytes_read, fat32.cluster_buf, to_copy);
-    bytes_read += to_copy;
+      uint32_t lba =
+          fat32.data_start + (cluster - 2) * fat32.sectors_per_cluster;
+      if (ide_read(fat32.drive, lba, run * fat32.sectors_per_cluster,
+                   buf + bytes_read) < 0) {
+        return -1;
+      }
 
-    cluster = fat32_read_fat(cluster);
+      bytes_read += run * fat32.bytes_per_cluster;
+      cluster = next;
+    } else {
+      /* Partial tail cluster: bounce through the cluster buffer */
+      if (fat32_read_cluster(cluster, fat32.cluster_buf) < 0) {
+        return -1;
+      }
+      memcpy(buf + bytes_read, fat32.cluster_buf, remaining);
+      bytes_read += remaining;
+      cluster = fat32_read_fat(cluster);
+    }
   }
 
   return bytes_read;
@@ -133,23 +133,29 @@ void cmd_head(const char *args) {
     return;
   }
 
-  char buf[4096];
-  int len = fs_read(filename, buf, sizeof(buf) - 1);
-  if (len < 0) {
+  int fd = fs_open(filename, 0);
+  if (fd < 0) {
     kprintf_color("Cannot read: ", VGA_COLOR_RED);
     kprintf("%s\n", filename);
     return;
   }
-  buf[len] = '\0';
 
-  /* Print first N lines */
+  /* Stream chunks, stopping after N lines */
+  char buf[512];
   int lines = 0;
-  for (i = 0; i < len && lines < n; i++) {
-    vga_putchar(buf[i]);
-    if (buf[i] == '\n')
-      lines++;
+  char last = '\n';
+  int len;
+  while (lines < n && (len = fs_pread(fd, buf, sizeof(buf))) > 0) {
+    for (i = 0; i < len && lines < n; i++) {
+      vga_putchar(buf[i]);
+      last = buf[i];
+      if (buf[i] == '\n')
+        lines++;
+    }
   }
-  if (lines > 0 && buf[i - 1] != '\n')
+  fs_close(fd);
+
+  if (lines > 0 && last != '\n')
     kprintf("\n");
 }
 
@@ -185,41 +191,44 @@ void cmd_tail(const char *args) {
     return;
   }
 
-  char buf[4096];
-  int len = fs_read(filename, buf, sizeof(buf) - 1);
-  if (len < 0) {
+  int fd = fs_open(filename, 0);
+  if (fd < 0) {
     kprintf_color("Cannot read: ", VGA_COLOR_RED);
     kprintf("%s\n", filename);
     return;
   }
-  buf[len] = '\0';
 
-  /* Count total lines */
+  /* Pass 1: count lines */
+  char buf[512];
   int total_lines = 0;
-  for (i = 0; i < len; i++) {
-    if (buf[i] == '\n')
-      total_lines++;
+  int len;
+  char last = '\n';
+  while ((len = fs_pread(fd, buf, sizeof(buf))) > 0) {
+    for (i = 0; i < len; i++) {
+      if (buf[i] == '\n')
+        total_lines++;
+      last = buf[i];
+    }
   }
 
-  /* Find start position */
   int skip_lines = total_lines - n;
   if (skip_lines < 0)
     skip_lines = 0;
 
+  /* Pass 2: skip, then print */
+  fs_seek(fd, 0);
   int lines = 0;
-  int start = 0;
-  for (i = 0; i < len && lines < skip_lines; i++) {
-    if (buf[i] == '\n') {
-      lines++;
-      start = i + 1;
+  while ((len = fs_pread(fd, buf, sizeof(buf))) > 0) {
+    for (i = 0; i < len; i++) {
+      if (lines >= skip_lines)
+        vga_putchar(buf[i]);
+      if (buf[i] == '\n')
+        lines++;
     }
   }
+  fs_close(fd);
 
-  /* Print remaining */
-  for (i = start; i < len; i++) {
-    vga_putchar(buf[i]);
-  }
-  if (len > 0 && buf[len - 1] != '\n')
+  if (last != '\n')
     kprintf("\n");
 }
 
@@ -232,29 +241,34 @@ void cmd_wc(const char *args) {
     return;
   }
 
-  char buf[4096];
-  int len = fs_read(args, buf, sizeof(buf) - 1);
-  if (len < 0) {
+  int fd = fs_open(args, 0);
+  if (fd < 0) {
     kprintf_color("Cannot read: ", VGA_COLOR_RED);
     kprintf("%s\n", args);
     return;
   }
-  buf[len] = '\0';
 
-  int lines = 0, words = 0, chars = len;
+  /* Stream in chunks - no whole-file buffer, no size ceiling */
+  char buf[512];
+  int lines = 0, words = 0, chars = 0;
   int in_word = 0;
-
-  for (int i = 0; i < len; i++) {
-    if (buf[i] == '\n')
-      lines++;
-
-    if (buf[i] == ' ' || buf[i] == '\n' || buf[i] == '\t') {
-      in_word = 0;
-    } else if (!in_word) {
-      in_word = 1;
-      words++;
+  int len;
+
+  while ((len = fs_pread(fd, buf, sizeof(buf))) > 0) {
+    chars += len;
+    for (int i = 0; i < len; i++) {
+      if (buf[i] == '\n')
+        lines++;
+
+      if (buf[i] == ' ' || buf[i] == '\n' || buf[i] == '\t') {
+        in_word = 0;
+      } else if (!in_word) {
+        in_word = 1;
+        words++;
+      }
     }
   }
+  fs_close(fd);
 
   kprintf("  %d  %d  %d %s\n", lines, words, chars, args);
 }
@@ -283,51 +297,48 @@ void cmd_grep(const char *args) {
     return;
   }
 
-  char buf[4096];
-  int len = fs_read(filename, buf, sizeof(buf) - 1);
-  if (len < 0) {
+  int fd = fs_open(filename, 0);
+  if (fd < 0) {
     kprintf_color("Cannot read: ", VGA_COLOR_RED);
     kprintf("%s\n", filename);
     return;
   }
-  buf[len] = '\0';
 
-  /* Search line by line */
+  /* Compile the pattern once, then stream the file in chunks and
+   * Horspool-search each assembled line */
+  strsearch_t search;
+  strsearch_compile(&search, pattern);
+
+  char buf[512];
   char line[256];
   int line_idx = 0;
-  int line_num = 1;
   int matches = 0;
-
-  for (i = 0; i <= len; i++) {
-    if (buf[i] == '\n' || buf[i] == '\0') {
-      line[line_idx] = '\0';
-
-      /* Simple substring search */
-      int found = 0;
-      for (int j = 0; j <= line_idx - (int)strlen(pattern); j++) {
-        int match = 1;
-        for (int k = 0; pattern[k]; k++) {
-          if (line[j + k] != pattern[k]) {
-            match = 0;
-            break;
-          }
-        }
-        if (match) {
-          found = 1;
-          break;
+  int len;
+
+  while ((len = fs_pread(fd, buf, sizeof(buf))) > 0) {
+    for (i = 0; i < len; i++) {
+      if (buf[i] == '\n') {
+        line[line_idx] = '\0';
+        if (strsearch_find(&search, line, line_idx)) {
+          kprintf_color("%d:", VGA_COLOR_YELLOW);
+          kprintf("%s\n", line);
+          matches++;
         }
+        line_idx = 0;
+      } else if (line_idx < 255) {
+        line[line_idx++] = buf[i];
       }
-
-      if (found) {
-        kprintf_color("%d:", VGA_COLOR_YELLOW);
-        kprintf("%s\n", line);
-        matches++;
-      }
-
-      line_idx = 0;
-      line_num++;
-    } else if (line_idx < 255) {
-      line[line_idx++] = buf[i];
+    }
+  }
+  fs_close(fd);
+
+  /* Final line without trailing newline */
+  if (line_idx > 0) {
+    line[line_idx] = '\0';
+    if (strsearch_find(&search, line, line_idx)) {
+      kprintf_color("%d:", VGA_COLOR_YELLOW);
+      kprintf("%s\n", line);
+      matches++;
     }
   }
 
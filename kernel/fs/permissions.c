@@ -6,90 +6,30 @@
 
 #include "../kernel.h"
 
-/* Permission bits */
-#define PERM_R 0x04
-#define PERM_W 0x02
-#define PERM_X 0x01
-
-/* Extended file structure would have these fields */
-typedef struct {
-  uint16_t owner_uid;
-  uint16_t owner_gid;
-  uint16_t mode; /* rwxrwxrwx */
-} file_perms_t;
-
-/* Simple file permission storage */
-#define MAX_PERM_ENTRIES 32
-
-typedef struct {
-  char filename[32];
-  uint16_t uid;
-  uint16_t gid;
-  uint16_t mode;
-} perm_entry_t;
-
-static perm_entry_t perms[MAX_PERM_ENTRIES];
-static int perm_count = 0;
-
 /*
- * Initialize default permissions
+ * Permission metadata lives on the filesystem nodes themselves
+ * (uid/gid/mode on fs_node_t, with a decision cache in ramfs.c);
+ * this file is the chmod/chown front end.
  */
-void perms_init(void) {
-  memset(perms, 0, sizeof(perms));
-  perm_count = 0;
 
-  /* Set default permissions for existing files */
-  strcpy(perms[0].filename, "readme.txt");
-  perms[0].uid = 0;
-  perms[0].gid = 0;
-  perms[0].mode = 0644; /* rw-r--r-- */
-
-  strcpy(perms[1].filename, "system.log");
-  perms[1].uid = 0;
-  perms[1].gid = 0;
-  perms[1].mode = 0600; /* rw------- */
-
-  perm_count = 2;
-}
-
-/*
- * Find permission entry
- */
-static perm_entry_t *find_perm(const char *filename) {
-  for (int i = 0; i < perm_count; i++) {
-    if (strcmp(perms[i].filename, filename) == 0) {
-      return &perms[i];
-    }
-  }
-  return NULL;
+void perms_init(void) {
+  /* Node metadata is initialized by the filesystem; nothing to do,
+   * kept for the boot sequence's sake */
 }
 
 /*
  * Set file permission
  */
 int set_file_mode(const char *filename, uint16_t mode) {
-  perm_entry_t *p = find_perm(filename);
-
-  if (p) {
-    /* Check ownership */
-    if (!user_is_root() && p->uid != user_get_uid()) {
-      return -1; /* Permission denied */
-    }
-    p->mode = mode;
-    return 0;
-  }
+  uint16_t uid;
+  if (fs_get_meta(filename, &uid, NULL, NULL) < 0)
+    return -1; /* No such file */
 
-  /* Create new entry */
-  if (perm_count < MAX_PERM_ENTRIES) {
-    strncpy(perms[perm_count].filename, filename, 31);
-    perms[perm_count].uid = user_get_uid();
-    perms[perm_count].gid = 0;
-    perms[perm_count].mode = mode;
-    perm_count++;
-    return 0;
-  }
+  /* Check ownership */
+  if (!user_is_root() && uid != user_get_uid())
+    return -1; /* Permission denied */
 
-  return -2; /* No space */
+  return fs_set_mode(filename, mode);
 }
 
 /*
@@ -100,25 +40,7 @@ int set_file_owner(const char *filename, uint16_t uid, uint16_t gid) {
     return -1; /* Only root can chown */
   }
 
-  perm_entry_t *p = find_perm(filename);
-
-  if (p) {
-    p->uid = uid;
-    p->gid = gid;
-    return 0;
-  }
-
-  /* Create new entry */
-  if (perm_count < MAX_PERM_ENTRIES) {
-    strncpy(perms[perm_count].filename, filename, 31);
-    perms[perm_count].uid = uid;
-    perms[perm_count].gid = gid;
-    perms[perm_count].mode = 0644;
-    perm_count++;
-    return 0;
-  }
-
-  return -2;
+  return fs_set_owner(filename, uid, gid);
 }
 
 /*
@@ -229,23 +151,22 @@ void cmd_chown(const char *args) {
 }
 
 /*
- * ls -l style output
+ * ls -l style output for one path
  */
 void cmd_ls_long(const char *args) {
-  (void)args;
-
-  kprintf("\n");
-  kprintf("Mode       Owner   Size  Name\n");
-  kprintf("---------  -----  -----  ----\n");
-
-  /* Show files with permissions */
-  for (int i = 0; i < perm_count; i++) {
-    char mode_buf[10];
-    mode_to_str(perms[i].mode, mode_buf);
+  if (args[0] == '\0') {
+    kprintf("Usage: lsl <file>\n");
+    return;
+  }
 
-    kprintf("-%s  %5d  %5d  %s\n", mode_buf, perms[i].uid,
-            0, /* Size would come from filesystem */
-            perms[i].filename);
+  uint16_t uid, gid, mode;
+  if (fs_get_meta(args, &uid, &gid, &mode) < 0) {
+    kprintf("No such file: %s\n", args);
+    return;
   }
-  kprintf("\n");
+
+  char mode_buf[10];
+  mode_to_str(mode, mode_buf);
+  kprintf("%c%s  uid %d  gid %d  %s\n", fs_isdir(args) ? 'd' : '-', mode_buf,
+          uid, gid, args);
 }
@@ -1,603 +1,1050 @@
-/*
- * NanoSec OS - Hierarchical RAM Filesystem
- * ==========================================
- * Tree-based filesystem with proper directory support
- */
-
-#include "../kernel.h"
-
-/* Filesystem limits */
-#define MAX_NODES 128
-#define MAX_NAME 32
-#define MAX_DATA 4096
-#define MAX_PATH 256
-
-/* Node types */
-#define NODE_FREE 0
-#define NODE_FILE 1
-#define NODE_DIR 2
-
-/* Filesystem node */
-typedef struct fs_node {
-  char name[MAX_NAME];
-  uint8_t type;
-  int parent; /* Index of parent node (-1 for root) */
-  uint32_t size;
-  uint8_t data[MAX_DATA];
-  uint32_t created;
-  uint32_t modified;
-} fs_node_t;
-
-/* Filesystem state */
-static fs_node_t nodes[MAX_NODES];
-static int current_dir = 0; /* Index of current directory (0 = root) */
-
-/* Forward declarations */
-static fs_node_t *find_in_dir(int parent, const char *name);
-static int find_node_index(int parent, const char *name);
-static int alloc_node(void);
-
-/* Export nodes for utils.c */
-fs_node_t *fs_get_nodes(void) { return nodes; }
-
-/*
- * Initialize filesystem with FHS structure
- */
-int fs_init(void) {
-  memset(nodes, 0, sizeof(nodes));
-
-  /* Create root directory */
-  nodes[0].type = NODE_DIR;
-  strcpy(nodes[0].name, "/");
-  nodes[0].parent = -1;
-
-  /* Create FHS directories */
-  const char *fhs_dirs[] = {"bin", "sbin", "etc", "var",  "tmp", "home", "root",
-                            "usr", "lib",  "dev", "proc", "mnt", "opt",  NULL};
-
-  for (int i = 0; fhs_dirs[i]; i++) {
-    int idx = alloc_node();
-    if (idx > 0) {
-      nodes[idx].type = NODE_DIR;
-      strncpy(nodes[idx].name, fhs_dirs[i], MAX_NAME - 1);
-      nodes[idx].parent = 0; /* Parent is root */
-    }
-  }
-
-  /* Create /var/log */
-  int var_idx = find_node_index(0, "var");
-  if (var_idx > 0) {
-    int log_idx = alloc_node();
-    if (log_idx > 0) {
-      nodes[log_idx].type = NODE_DIR;
-      strcpy(nodes[log_idx].name, "log");
-      nodes[log_idx].parent = var_idx;
-    }
-  }
-
-  /* Create /home/guest */
-  int home_idx = find_node_index(0, "home");
-  if (home_idx > 0) {
-    int guest_idx = alloc_node();
-    if (guest_idx > 0) {
-      nodes[guest_idx].type = NODE_DIR;
-      strcpy(nodes[guest_idx].name, "guest");
-      nodes[guest_idx].parent = home_idx;
-    }
-  }
-
-  /* Create readme.txt in root */
-  int readme_idx = alloc_node();
-  if (readme_idx > 0) {
-    nodes[readme_idx].type = NODE_FILE;
-    strcpy(nodes[readme_idx].name, "readme.txt");
-    nodes[readme_idx].parent = 0;
-    strcpy((char *)nodes[readme_idx].data,
-           "Welcome to NanoSec OS!\n"
-           "======================\n\n"
-           "This is a custom operating system.\n"
-           "Type 'help' for available commands.\n");
-    nodes[readme_idx].size = strlen((char *)nodes[readme_idx].data);
-  }
-
-  /* Create command binaries in /bin */
-  int bin_idx = find_node_index(0, "bin");
-  if (bin_idx > 0) {
-    const char *bin_cmds[] = {
-        "ls",   "cat",     "cd",    "pwd",  "mkdir",  "touch", "rm",   "cp",
-        "mv",   "echo",    "clear", "help", "man",    "head",  "tail", "wc",
-        "grep", "history", "alias", "env",  "export", NULL};
-    for (int i = 0; bin_cmds[i]; i++) {
-      int idx = alloc_node();
-      if (idx > 0) {
-        nodes[idx].type = NODE_FILE;
-        strncpy(nodes[idx].name, bin_cmds[i], MAX_NAME - 1);
-        nodes[idx].parent = bin_idx;
-        strcpy((char *)nodes[idx].data, "#!/bin/sh\n# NanoSec builtin\n");
-        nodes[idx].size = strlen((char *)nodes[idx].data);
-      }
-    }
-  }
-
-  /* Create system commands in /sbin */
-  int sbin_idx = find_node_index(0, "sbin");
-  if (sbin_idx > 0) {
-    const char *sbin_cmds[] = {"reboot",   "shutdown", "halt",     "init",
-                               "mount",    "umount",   "ifconfig", "route",
-                               "iptables", "modprobe", NULL};
-    for (int i = 0; sbin_cmds[i]; i++) {
-      int idx = alloc_node();
-      if (idx > 0) {
-        nodes[idx].type = NODE_FILE;
-        strncpy(nodes[idx].name, sbin_cmds[i], MAX_NAME - 1);
-        nodes[idx].parent = sbin_idx;
-        strcpy((char *)nodes[idx].data, "#!/bin/sh\n# NanoSec system cmd\n");
-        nodes[idx].size = strlen((char *)nodes[idx].data);
-      }
-    }
-  }
-
-  /* Create /etc config files */
-  int etc_idx = find_node_index(0, "etc");
-  if (etc_idx > 0) {
-    /* hostname */
-    int idx = alloc_node();
-    if (idx > 0) {
-      nodes[idx].type = NODE_FILE;
-      strcpy(nodes[idx].name, "hostname");
-      nodes[idx].parent = etc_idx;
-      strcpy((char *)nodes[idx].data, "nanosec\n");
-      nodes[idx].size = strlen((char *)nodes[idx].data);
-    }
-    /* passwd */
-    idx = alloc_node();
-    if (idx > 0) {
-      nodes[idx].type = NODE_FILE;
-      strcpy(nodes[idx].name, "passwd");
-      nodes[idx].parent = etc_idx;
-      strcpy((char *)nodes[idx].data,
-             "root:x:0:0:root:/root:/bin/sh\nguest:x:1000:1000:Guest:/home/"
-             "guest:/bin/sh\n");
-      nodes[idx].size = strlen((char *)nodes[idx].data);
-    }
-    /* motd */
-    idx = alloc_node();
-    if (idx > 0) {
-      nodes[idx].type = NODE_FILE;
-      strcpy(nodes[idx].name, "motd");
-      nodes[idx].parent = etc_idx;
-      strcpy((char *)nodes[idx].data, "Welcome to NanoSec OS!\n");
-      nodes[idx].size = strlen((char *)nodes[idx].data);
-    }
-  }
-
-  current_dir = 0;
-  return 0;
-}
-
-/*
- * Allocate a new node
- */
-static int alloc_node(void) {
-  for (int i = 1; i < MAX_NODES; i++) {
-    if (nodes[i].type == NODE_FREE) {
-      memset(&nodes[i], 0, sizeof(fs_node_t));
-      nodes[i].created = timer_get_ticks();
-      nodes[i].modified = nodes[i].created;
-      return i;
-    }
-  }
-  return -1;
-}
-
-/*
- * Find node by name in a parent directory
- */
-static int find_node_index(int parent, const char *name) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].type != NODE_FREE && nodes[i].parent == parent &&
-        strcmp(nodes[i].name, name) == 0) {
-      return i;
-    }
-  }
-  return -1;
-}
-
-static fs_node_t *find_in_dir(int parent, const char *name) {
-  int idx = find_node_index(parent, name);
-  return (idx >= 0) ? &nodes[idx] : NULL;
-}
-
-/*
- * Resolve path to node index
- * Returns node index or -1 if not found
- */
-static int resolve_path(const char *path) {
-  if (path[0] == '\0' || strcmp(path, "/") == 0) {
-    return 0; /* Root */
-  }
-
-  int dir = (path[0] == '/') ? 0 : current_dir;
-  const char *p = (path[0] == '/') ? path + 1 : path;
-
-  char component[MAX_NAME];
-
-  while (*p) {
-    /* Extract path component */
-    int i = 0;
-    while (*p && *p != '/' && i < MAX_NAME - 1) {
-      component[i++] = *p++;
-    }
-    component[i] = '\0';
-
-    if (*p == '/')
-      p++;
-
-    if (component[0] == '\0')
-      continue;
-
-    /* Handle . and .. */
-    if (strcmp(component, ".") == 0) {
-      continue;
-    } else if (strcmp(component, "..") == 0) {
-      if (nodes[dir].parent >= 0) {
-        dir = nodes[dir].parent;
-      }
-      continue;
-    }
-
-    /* Find component in current dir */
-    int idx = find_node_index(dir, component);
-    if (idx < 0) {
-      return -1; /* Not found */
-    }
-
-    dir = idx;
-  }
-
-  return dir;
-}
-
-/*
- * Get full path of a node
- */
-static void get_full_path(int idx, char *path, size_t size) {
-  if (idx == 0) {
-    strcpy(path, "/");
-    return;
-  }
-
-  /* Build path backwards */
-  char temp[MAX_PATH];
-  temp[0] = '\0';
-
-  while (idx > 0) {
-    char part[MAX_NAME + 2];
-    strcpy(part, "/");
-    strcat(part, nodes[idx].name);
-
-    char old[MAX_PATH];
-    strcpy(old, temp);
-    strcpy(temp, part);
-    strcat(temp, old);
-
-    idx = nodes[idx].parent;
-  }
-
-  if (temp[0] == '\0')
-    strcpy(temp, "/");
-  strncpy(path, temp, size - 1);
-  path[size - 1] = '\0';
-}
-
-/*
- * Get current working directory path
- */
-const char *fhs_getcwd(void) {
-  static char cwd_path[MAX_PATH];
-  get_full_path(current_dir, cwd_path, MAX_PATH);
-  return cwd_path;
-}
-
-/*
- * Create directory
- */
-int fs_mkdir(const char *name) {
-  /* Check if already exists */
-  if (find_in_dir(current_dir, name)) {
-    return -1;
-  }
-
-  int idx = alloc_node();
-  if (idx < 0)
-    return -1;
-
-  nodes[idx].type = NODE_DIR;
-  strncpy(nodes[idx].name, name, MAX_NAME - 1);
-  nodes[idx].parent = current_dir;
-
-  return 0;
-}
-
-/*
- * Check if path is a directory
- */
-int fs_isdir(const char *name) {
-  int idx = resolve_path(name);
-  return (idx >= 0 && nodes[idx].type == NODE_DIR);
-}
-
-/*
- * Change directory
- */
-int fhs_chdir(const char *path) {
-  if (strcmp(path, "/") == 0) {
-    current_dir = 0;
-    return 0;
-  }
-
-  int idx = resolve_path(path);
-  if (idx < 0 || nodes[idx].type != NODE_DIR) {
-    return -1;
-  }
-
-  current_dir = idx;
-  return 0;
-}
-
-/*
- * ls - List directory contents
- */
-void cmd_ls(const char *args) {
-  int dir = current_dir;
-
-  if (args[0] != '\0') {
-    dir = resolve_path(args);
-    if (dir < 0) {
-      kprintf("ls: %s: No such directory\n", args);
-      return;
-    }
-  }
-
-  kprintf("\n");
-
-  int count = 0;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].type != NODE_FREE && nodes[i].parent == dir) {
-      if (nodes[i].type == NODE_DIR) {
-        kprintf_color(nodes[i].name, VGA_COLOR_CYAN);
-        kprintf("/\n");
-      } else {
-        /* Simple format without width specifier */
-        kprintf("%s", nodes[i].name);
-        /* Pad to 20 chars */
-        int len = strlen(nodes[i].name);
-        for (int p = len; p < 20; p++)
-          kprintf(" ");
-        kprintf("%d bytes\n", nodes[i].size);
-      }
-      count++;
-    }
-  }
-
-  if (count == 0) {
-    kprintf("(empty)\n");
-  }
-  kprintf("\n");
-}
-
-/*
- * cat - Show file contents
- */
-void cmd_cat(const char *args) {
-  if (args[0] == '\0') {
-    kprintf("Usage: cat <filename>\n");
-    return;
-  }
-
-  int idx = resolve_path(args);
-  if (idx < 0) {
-    kprintf_color("File not found: ", VGA_COLOR_RED);
-    kprintf("%s\n", args);
-    return;
-  }
-
-  if (nodes[idx].type == NODE_DIR) {
-    kprintf_color("Is a directory\n", VGA_COLOR_RED);
-    return;
-  }
-
-  kprintf("\n%s", (char *)nodes[idx].data);
-  if (nodes[idx].size > 0 && nodes[idx].data[nodes[idx].size - 1] != '\n') {
-    kprintf("\n");
-  }
-  kprintf("\n");
-}
-
-/*
- * touch - Create empty file
- */
-void cmd_touch(const char *args) {
-  if (args[0] == '\0') {
-    kprintf("Usage: touch <filename>\n");
-    return;
-  }
-
-  if (find_in_dir(current_dir, args)) {
-    return; /* Already exists */
-  }
-
-  int idx = alloc_node();
-  if (idx < 0) {
-    kprintf_color("Filesystem full\n", VGA_COLOR_RED);
-    return;
-  }
-
-  nodes[idx].type = NODE_FILE;
-  strncpy(nodes[idx].name, args, MAX_NAME - 1);
-  nodes[idx].parent = current_dir;
-  nodes[idx].size = 0;
-
-  kprintf("Created: %s\n", args);
-}
-
-/*
- * rm - Remove file or directory
- */
-void cmd_rm(const char *args) {
-  if (args[0] == '\0') {
-    kprintf("Usage: rm [-rf] <file>\n");
-    return;
-  }
-
-  const char *target = args;
-  int recursive = 0;
-
-  if (args[0] == '-') {
-    if (strncmp(args, "-rf", 3) == 0 || strncmp(args, "-r", 2) == 0) {
-      recursive = 1;
-    }
-    while (*target && *target != ' ')
-      target++;
-    while (*target == ' ')
-      target++;
-  }
-
-  int idx = resolve_path(target);
-  if (idx < 0) {
-    kprintf("rm: %s: No such file\n", target);
-    return;
-  }
-
-  if (idx == 0) {
-    kprintf("rm: cannot remove root\n");
-    return;
-  }
-
-  if (nodes[idx].type == NODE_DIR && !recursive) {
-    kprintf("rm: %s: Is a directory (use -rf)\n", target);
-    return;
-  }
-
-  /* Remove node and children */
-  if (nodes[idx].type == NODE_DIR) {
-    /* Remove children first */
-    for (int i = 0; i < MAX_NODES; i++) {
-      if (nodes[i].parent == idx) {
-        nodes[i].type = NODE_FREE;
-      }
-    }
-  }
-
-  nodes[idx].type = NODE_FREE;
-  kprintf("Removed: %s\n", target);
-}
-
-/*
- * pwd - Print working directory
- */
-void cmd_pwd(const char *args) {
-  (void)args;
-  kprintf("%s\n", fhs_getcwd());
-}
-
-/*
- * fs_write - Write to file
- */
-int fs_write(const char *name, const char *data, size_t len) {
-  int idx = resolve_path(name);
-
-  if (idx < 0) {
-    /* Create new file */
-    idx = alloc_node();
-    if (idx < 0)
-      return -1;
-
-    nodes[idx].type = NODE_FILE;
-    strncpy(nodes[idx].name, name, MAX_NAME - 1);
-    nodes[idx].parent = current_dir;
-  }
-
-  if (len > MAX_DATA)
-    len = MAX_DATA;
-  memcpy(nodes[idx].data, data, len);
-  nodes[idx].size = len;
-  nodes[idx].modified = timer_get_ticks();
-
-  return 0;
-}
-
-/*
- * fs_read - Read file
- */
-int fs_read(const char *name, char *buf, size_t max) {
-  int idx = resolve_path(name);
-  if (idx < 0 || nodes[idx].type == NODE_DIR) {
-    return -1;
-  }
-
-  size_t len = nodes[idx].size;
-  if (len > max)
-    len = max;
-  memcpy(buf, nodes[idx].data, len);
-
-  return len;
-}
-
-/*
- * Echo with redirect
- */
-void cmd_echo_file(const char *args) {
-  const char *p = args;
-  const char *redirect = NULL;
-  int append = 0;
-
-  while (*p) {
-    if (*p == '>') {
-      redirect = p;
-      if (*(p + 1) == '>')
-        append = 1;
-      break;
-    }
-    p++;
-  }
-
-  if (!redirect) {
-    kprintf("%s\n", args);
-    return;
-  }
-
-  /* Get text */
-  char text[256];
-  int i = 0;
-  p = args;
-  while (p < redirect && i < 255) {
-    text[i++] = *p++;
-  }
-  while (i > 0 && text[i - 1] == ' ')
-    i--;
-  text[i] = '\0';
-
-  /* Get filename */
-  p = redirect + 1 + append;
-  while (*p == ' ')
-    p++;
-
-  char filename[64];
-  i = 0;
-  while (*p && *p != ' ' && i < 63) {
-    filename[i++] = *p++;
-  }
-  filename[i] = '\0';
-
-  if (filename[0] == '\0') {
-    kprintf("Missing filename\n");
-    return;
-  }
-
-  /* Append newline */
-  strcat(text, "\n");
-
-  fs_write(filename, text, strlen(text));
-  kprintf("Wrote to %s\n", filename);
-}
+/*
+ * NanoSec OS - Hierarchical RAM Filesystem
+ * ==========================================
+ * Tree-based filesystem with proper directory support
+ */
+
+#include "../kernel.h"
+
+/* Filesystem limits */
+#define MAX_NODES 256
+#define MAX_NAME 32
+#define MAX_PATH 256
+
+/* Node types */
+#define NODE_FREE 0
+#define NODE_FILE 1
+#define NODE_DIR 2
+
+/* File data lives in a chain of heap-backed extents, so a node costs
+ * only what it holds: empty files and directories carry no data at
+ * all, and files grow extent by extent to available memory instead of
+ * hitting a fixed per-node ceiling. */
+#define EXTENT_SIZE 1024
+
+typedef struct fs_extent {
+  struct fs_extent *next;
+  uint8_t data[EXTENT_SIZE];
+} fs_extent_t;
+
+/* Filesystem node */
+typedef struct fs_node {
+  char name[MAX_NAME];
+  uint8_t type;
+  int parent; /* Index of parent node (-1 for root) */
+  uint32_t size;
+  fs_extent_t *extents; /* Data chain (NULL when empty) */
+  uint32_t created;
+  uint32_t modified;
+  int first_child;  /* Head of this directory's child list (-1 none) */
+  int next_sibling; /* Next node in the same directory (-1 end) */
+  int hash_next;    /* Next node in the same name-hash bucket (-1 end) */
+  uint16_t uid;     /* Owner (appended: utils.c mirrors this layout) */
+  uint16_t gid;
+  uint16_t mode; /* rwxrwxrwx */
+} fs_node_t;
+
+/* Filesystem state */
+static fs_node_t nodes[MAX_NODES];
+static int current_dir = 0; /* Index of current directory (0 = root) */
+
+/* Name lookup index: (parent, name) hashes to a bucket whose chain is
+ * threaded through hash_next. Lookups and directory walks are then
+ * proportional to directory size, not to MAX_NODES. */
+#define FS_HASH_SIZE 64
+static int fs_hash_heads[FS_HASH_SIZE];
+
+/* Forward declarations */
+static fs_node_t *find_in_dir(int parent, const char *name);
+static int find_node_index(int parent, const char *name);
+static int alloc_node(void);
+
+/* Export nodes for utils.c */
+fs_node_t *fs_get_nodes(void) { return nodes; }
+
+/*
+ * Extent chain helpers. All file data access goes through these so
+ * the rest of the code never cares how the bytes are laid out.
+ */
+
+/* Free a node's entire data chain */
+static void node_free_data(fs_node_t *n) {
+  fs_extent_t *e = n->extents;
+  while (e) {
+    fs_extent_t *next = e->next;
+    kfree(e);
+    e = next;
+  }
+  n->extents = NULL;
+  n->size = 0;
+}
+
+/* Walk to the extent covering a given index, optionally growing the
+ * chain on the way. Returns NULL if out of range (or out of memory). */
+static fs_extent_t *node_extent_at(fs_node_t *n, uint32_t index, int grow) {
+  fs_extent_t **link = &n->extents;
+  for (;;) {
+    if (!*link) {
+      if (!grow)
+        return NULL;
+      fs_extent_t *e = (fs_extent_t *)kmalloc(sizeof(fs_extent_t));
+      if (!e)
+        return NULL;
+      e->next = NULL;
+      *link = e;
+    }
+    if (index == 0)
+      return *link;
+    index--;
+    link = &(*link)->next;
+  }
+}
+
+/* Write into a node at an offset, allocating extents as needed.
+ * Returns the number of bytes actually written (short on OOM). */
+static size_t node_write(fs_node_t *n, uint32_t off, const uint8_t *buf,
+                         size_t len) {
+  size_t written = 0;
+  while (written < len) {
+    uint32_t pos = off + written;
+    fs_extent_t *e = node_extent_at(n, pos / EXTENT_SIZE, 1);
+    if (!e)
+      break; /* Out of memory */
+    uint32_t eo = pos % EXTENT_SIZE;
+    size_t chunk = EXTENT_SIZE - eo;
+    if (chunk > len - written)
+      chunk = len - written;
+    memcpy(e->data + eo, buf + written, chunk);
+    written += chunk;
+  }
+  if (off + written > n->size)
+    n->size = off + written;
+  n->modified = timer_get_ticks();
+  return written;
+}
+
+/* Read from a node at an offset. Returns bytes copied (0 past EOF). */
+static size_t node_read(const fs_node_t *n, uint32_t off, uint8_t *buf,
+                        size_t len) {
+  if (off >= n->size)
+    return 0;
+  if (len > n->size - off)
+    len = n->size - off;
+
+  fs_extent_t *e = n->extents;
+  for (uint32_t skip = off / EXTENT_SIZE; e && skip > 0; skip--)
+    e = e->next;
+
+  size_t done = 0;
+  while (e && done < len) {
+    uint32_t eo = (off + done) % EXTENT_SIZE;
+    size_t chunk = EXTENT_SIZE - eo;
+    if (chunk > len - done)
+      chunk = len - done;
+    memcpy(buf + done, e->data + eo, chunk);
+    done += chunk;
+    if (eo + chunk == EXTENT_SIZE)
+      e = e->next;
+  }
+  return done;
+}
+
+/* Seed a file with a string during fs_init */
+static void node_set_contents(int idx, const char *text) {
+  node_write(&nodes[idx], 0, (const uint8_t *)text, strlen(text));
+}
+
+/*
+ * Name index and directory links
+ */
+
+static uint32_t fs_name_hash(int parent, const char *name) {
+  uint32_t hash = 5381 ^ ((uint32_t)parent * 2654435761u);
+  while (*name) {
+    hash = ((hash << 5) + hash) + (uint8_t)*name++; /* djb2 */
+  }
+  return hash & (FS_HASH_SIZE - 1);
+}
+
+/* Link a node under its parent: tail of the child list (so directory
+ * listings keep creation order) and head of its hash bucket */
+static void attach_node(int idx, int parent) {
+  nodes[idx].parent = parent;
+
+  nodes[idx].next_sibling = -1;
+  if (nodes[parent].first_child < 0) {
+    nodes[parent].first_child = idx;
+  } else {
+    int tail = nodes[parent].first_child;
+    while (nodes[tail].next_sibling >= 0)
+      tail = nodes[tail].next_sibling;
+    nodes[tail].next_sibling = idx;
+  }
+
+  uint32_t bucket = fs_name_hash(parent, nodes[idx].name);
+  nodes[idx].hash_next = fs_hash_heads[bucket];
+  fs_hash_heads[bucket] = idx;
+}
+
+/* Unlink a node from its parent's child list and its hash bucket */
+static void detach_node(int idx) {
+  int parent = nodes[idx].parent;
+
+  if (parent >= 0) {
+    int *link = &nodes[parent].first_child;
+    while (*link >= 0 && *link != idx)
+      link = &nodes[*link].next_sibling;
+    if (*link == idx)
+      *link = nodes[idx].next_sibling;
+  }
+
+  uint32_t bucket = fs_name_hash(parent, nodes[idx].name);
+  int *link = &fs_hash_heads[bucket];
+  while (*link >= 0 && *link != idx)
+    link = &nodes[*link].hash_next;
+  if (*link == idx)
+    *link = nodes[idx].hash_next;
+}
+
+/*
+ * Initialize filesystem with FHS structure
+ */
+int fs_init(void) {
+  memset(nodes, 0, sizeof(nodes));
+  for (int i = 0; i < FS_HASH_SIZE; i++)
+    fs_hash_heads[i] = -1;
+
+  /* Create root directory */
+  nodes[0].type = NODE_DIR;
+  strcpy(nodes[0].name, "/");
+  nodes[0].parent = -1;
+  nodes[0].first_child = -1;
+  nodes[0].next_sibling = -1;
+  nodes[0].hash_next = -1;
+  nodes[0].mode = 0755;
+
+  /* Create FHS directories */
+  const char *fhs_dirs[] = {"bin", "sbin", "etc", "var",  "tmp", "home", "root",
+                            "usr", "lib",  "dev", "proc", "mnt", "opt",  NULL};
+
+  for (int i = 0; fhs_dirs[i]; i++) {
+    int idx = alloc_node();
+    if (idx > 0) {
+      nodes[idx].type = NODE_DIR;
+      strncpy(nodes[idx].name, fhs_dirs[i], MAX_NAME - 1);
+      attach_node(idx, 0);
+    }
+  }
+
+  /* Create /var/log */
+  int var_idx = find_node_index(0, "var");
+  if (var_idx > 0) {
+    int log_idx = alloc_node();
+    if (log_idx > 0) {
+      nodes[log_idx].type = NODE_DIR;
+      strcpy(nodes[log_idx].name, "log");
+      attach_node(log_idx, var_idx);
+    }
+  }
+
+  /* Create /home/guest */
+  int home_idx = find_node_index(0, "home");
+  if (home_idx > 0) {
+    int guest_idx = alloc_node();
+    if (guest_idx > 0) {
+      nodes[guest_idx].type = NODE_DIR;
+      strcpy(nodes[guest_idx].name, "guest");
+      attach_node(guest_idx, home_idx);
+    }
+  }
+
+  /* Create readme.txt in root */
+  int readme_idx = alloc_node();
+  if (readme_idx > 0) {
+    nodes[readme_idx].type = NODE_FILE;
+    strcpy(nodes[readme_idx].name, "readme.txt");
+    attach_node(readme_idx, 0);
+    node_set_contents(readme_idx, "Welcome to NanoSec OS!\n"
+                                  "======================\n\n"
+                                  "This is a custom operating system.\n"
+                                  "Type 'help' for available commands.\n");
+  }
+
+  /* Create command binaries in /bin */
+  int bin_idx = find_node_index(0, "bin");
+  if (bin_idx > 0) {
+    const char *bin_cmds[] = {
+        "ls",   "cat",     "cd",    "pwd",  "mkdir",  "touch", "rm",   "cp",
+        "mv",   "echo",    "clear", "help", "man",    "head",  "tail", "wc",
+        "grep", "history", "alias", "env",  "export", NULL};
+    for (int i = 0; bin_cmds[i]; i++) {
+      int idx = alloc_node();
+      if (idx > 0) {
+        nodes[idx].type = NODE_FILE;
+        strncpy(nodes[idx].name, bin_cmds[i], MAX_NAME - 1);
+        attach_node(idx, bin_idx);
+        node_set_contents(idx, "#!/bin/sh\n# NanoSec builtin\n");
+      }
+    }
+  }
+
+  /* Create system commands in /sbin */
+  int sbin_idx = find_node_index(0, "sbin");
+  if (sbin_idx > 0) {
+    const char *sbin_cmds[] = {"reboot",   "shutdown", "halt",     "init",
+                               "mount",    "umount",   "ifconfig", "route",
+                               "iptables", "modprobe", NULL};
+    for (int i = 0; sbin_cmds[i]; i++) {
+      int idx = alloc_node();
+      if (idx > 0) {
+        nodes[idx].type = NODE_FILE;
+        strncpy(nodes[idx].name, sbin_cmds[i], MAX_NAME - 1);
+        attach_node(idx, sbin_idx);
+        node_set_contents(idx, "#!/bin/sh\n# NanoSec system cmd\n");
+      }
+    }
+  }
+
+  /* Create /etc config files */
+  int etc_idx = find_node_index(0, "etc");
+  if (etc_idx > 0) {
+    /* hostname */
+    int idx = alloc_node();
+    if (idx > 0) {
+      nodes[idx].type = NODE_FILE;
+      strcpy(nodes[idx].name, "hostname");
+      attach_node(idx, etc_idx);
+      node_set_contents(idx, "nanosec\n");
+    }
+    /* passwd */
+    idx = alloc_node();
+    if (idx > 0) {
+      nodes[idx].type = NODE_FILE;
+      strcpy(nodes[idx].name, "passwd");
+      attach_node(idx, etc_idx);
+      node_set_contents(
+          idx, "root:x:0:0:root:/root:/bin/sh\nguest:x:1000:1000:Guest:/home/"
+               "guest:/bin/sh\n");
+    }
+    /* motd */
+    idx = alloc_node();
+    if (idx > 0) {
+      nodes[idx].type = NODE_FILE;
+      strcpy(nodes[idx].name, "motd");
+      attach_node(idx, etc_idx);
+      node_set_contents(idx, "Welcome to NanoSec OS!\n");
+    }
+  }
+
+  /* Boot-created tree belongs to root; directories get the usual
+   * traversal bits */
+  for (int i = 0; i < MAX_NODES; i++) {
+    if (nodes[i].type == NODE_DIR)
+      nodes[i].mode = 0755;
+  }
+
+  current_dir = 0;
+  return 0;
+}
+
+/*
+ * Allocate a new node
+ */
+static int alloc_node(void) {
+  for (int i = 1; i < MAX_NODES; i++) {
+    if (nodes[i].type == NODE_FREE) {
+      memset(&nodes[i], 0, sizeof(fs_node_t));
+      nodes[i].created = timer_get_ticks();
+      nodes[i].modified = nodes[i].created;
+      nodes[i].first_child = -1;
+      nodes[i].next_sibling = -1;
+      nodes[i].hash_next = -1;
+      nodes[i].uid = user_get_uid();
+      nodes[i].gid = 0;
+      nodes[i].mode = 0644; /* fs_mkdir raises this for directories */
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ * Find node by name in a parent directory
+ */
+static int find_node_index(int parent, const char *name) {
+  uint32_t bucket = fs_name_hash(parent, name);
+  for (int i = fs_hash_heads[bucket]; i >= 0; i = nodes[i].hash_next) {
+    if (nodes[i].parent == parent && strcmp(nodes[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static fs_node_t *find_in_dir(int parent, const char *name) {
+  int idx = find_node_index(parent, name);
+  return (idx >= 0) ? &nodes[idx] : NULL;
+}
+
+/*
+ * Resolve path to node index
+ * Returns node index or -1 if not found
+ */
+static int resolve_path(const char *path) {
+  if (path[0] == '\0' || strcmp(path, "/") == 0) {
+    return 0; /* Root */
+  }
+
+  int dir = (path[0] == '/') ? 0 : current_dir;
+  const char *p = (path[0] == '/') ? path + 1 : path;
+
+  char component[MAX_NAME];
+
+  while (*p) {
+    /* Extract path component */
+    int i = 0;
+    while (*p && *p != '/' && i < MAX_NAME - 1) {
+      component[i++] = *p++;
+    }
+    component[i] = '\0';
+
+    if (*p == '/')
+      p++;
+
+    if (component[0] == '\0')
+      continue;
+
+    /* Handle . and .. */
+    if (strcmp(component, ".") == 0) {
+      continue;
+    } else if (strcmp(component, "..") == 0) {
+      if (nodes[dir].parent >= 0) {
+        dir = nodes[dir].parent;
+      }
+      continue;
+    }
+
+    /* Find component in current dir */
+    int idx = find_node_index(dir, component);
+    if (idx < 0) {
+      return -1; /* Not found */
+    }
+
+    dir = idx;
+  }
+
+  return dir;
+}
+
+/*
+ * Get full path of a node
+ */
+static void get_full_path(int idx, char *path, size_t size) {
+  if (idx == 0) {
+    strcpy(path, "/");
+    return;
+  }
+
+  /* Build path backwards */
+  char temp[MAX_PATH];
+  temp[0] = '\0';
+
+  while (idx > 0) {
+    char part[MAX_NAME + 2];
+    strcpy(part, "/");
+    strcat(part, nodes[idx].name);
+
+    char old[MAX_PATH];
+    strcpy(old, temp);
+    strcpy(temp, part);
+    strcat(temp, old);
+
+    idx = nodes[idx].parent;
+  }
+
+  if (temp[0] == '\0')
+    strcpy(temp, "/");
+  strncpy(path, temp, size - 1);
+  path[size - 1] = '\0';
+}
+
+/* ============ Completion support ============ */
+
+/*
+ * Walk accessors for tab completion: resolve a directory once, then
+ * iterate its child list - cost proportional to the directory, not
+ * to the node table.
+ */
+int fs_resolve_dir(const char *path) {
+  int idx = resolve_path(path);
+  if (idx < 0 || nodes[idx].type != NODE_DIR)
+    return -1;
+  return idx;
+}
+
+int fs_first_child(int dir) {
+  if (dir < 0 || dir >= MAX_NODES)
+    return -1;
+  return nodes[dir].first_child;
+}
+
+int fs_next_sibling(int idx) {
+  if (idx < 0 || idx >= MAX_NODES)
+    return -1;
+  return nodes[idx].next_sibling;
+}
+
+const char *fs_node_name(int idx) { return nodes[idx].name; }
+
+int fs_node_isdir(int idx) { return nodes[idx].type == NODE_DIR; }
+
+/*
+ * Get current working directory path
+ */
+const char *fhs_getcwd(void) {
+  static char cwd_path[MAX_PATH];
+  get_full_path(current_dir, cwd_path, MAX_PATH);
+  return cwd_path;
+}
+
+/*
+ * Create directory
+ */
+int fs_mkdir(const char *name) {
+  /* Check if already exists */
+  if (find_in_dir(current_dir, name)) {
+    return -1;
+  }
+
+  int idx = alloc_node();
+  if (idx < 0)
+    return -1;
+
+  nodes[idx].type = NODE_DIR;
+  nodes[idx].mode = 0755;
+  strncpy(nodes[idx].name, name, MAX_NAME - 1);
+  attach_node(idx, current_dir);
+
+  return 0;
+}
+
+/*
+ * Check if path is a directory
+ */
+int fs_isdir(const char *name) {
+  int idx = resolve_path(name);
+  return (idx >= 0 && nodes[idx].type == NODE_DIR);
+}
+
+/*
+ * Identity stamp for a file: returns its node index and stores the
+ * last-modified tick. Lets callers cache derived data (e.g. compiled
+ * scripts) and notice when the file changed underneath them.
+ */
+int fs_stamp(const char *name, uint32_t *modified) {
+  int idx = resolve_path(name);
+  if (idx < 0 || nodes[idx].type == NODE_DIR)
+    return -1;
+  if (modified)
+    *modified = nodes[idx].modified;
+  return idx;
+}
+
+/*
+ * Permission checks with a decision cache
+ * ========================================
+ * user_check_permission walks mode bits and ownership per call; a
+ * pipeline touching the same files repeatedly re-derives identical
+ * decisions. Recent (node, access) verdicts are kept in a small
+ * direct-mapped cache, invalidated wholesale by bumping a generation
+ * counter on chmod/chown and identity changes (login/logout/su).
+ */
+#define PERM_CACHE_SIZE 64
+
+typedef struct {
+  int16_t node;
+  uint8_t access;
+  uint8_t allow;
+  uint32_t gen;
+} perm_cache_t;
+
+static perm_cache_t perm_cache[PERM_CACHE_SIZE];
+static uint32_t perm_gen = 1;
+
+void fs_perm_flush(void) { perm_gen++; }
+
+static int node_access(int idx, int access) {
+  perm_cache_t *e =
+      &perm_cache[((uint32_t)idx * 4 + (uint32_t)access) &
+                  (PERM_CACHE_SIZE - 1)];
+  if (e->gen == perm_gen && e->node == idx && e->access == access)
+    return e->allow;
+
+  int allow = user_check_permission(nodes[idx].uid, nodes[idx].gid,
+                                    nodes[idx].mode, access);
+  e->node = (int16_t)idx;
+  e->access = (uint8_t)access;
+  e->allow = (uint8_t)allow;
+  e->gen = perm_gen;
+  return allow;
+}
+
+/*
+ * fs_access - can the current user access this path this way?
+ */
+int fs_access(const char *name, int access_type) {
+  int idx = resolve_path(name);
+  if (idx < 0)
+    return 0;
+  return node_access(idx, access_type);
+}
+
+/*
+ * Owner/mode accessors (chmod/chown live in permissions.c)
+ */
+int fs_get_meta(const char *name, uint16_t *uid, uint16_t *gid,
+                uint16_t *mode) {
+  int idx = resolve_path(name);
+  if (idx < 0)
+    return -1;
+  if (uid)
+    *uid = nodes[idx].uid;
+  if (gid)
+    *gid = nodes[idx].gid;
+  if (mode)
+    *mode = nodes[idx].mode;
+  return 0;
+}
+
+int fs_set_mode(const char *name, uint16_t mode) {
+  int idx = resolve_path(name);
+  if (idx < 0)
+    return -1;
+  nodes[idx].mode = mode;
+  fs_perm_flush();
+  return 0;
+}
+
+int fs_set_owner(const char *name, uint16_t uid, uint16_t gid) {
+  int idx = resolve_path(name);
+  if (idx < 0)
+    return -1;
+  nodes[idx].uid = uid;
+  nodes[idx].gid = gid;
+  fs_perm_flush();
+  return 0;
+}
+
+/*
+ * Change directory
+ */
+int fhs_chdir(const char *path) {
+  if (strcmp(path, "/") == 0) {
+    current_dir = 0;
+    return 0;
+  }
+
+  int idx = resolve_path(path);
+  if (idx < 0 || nodes[idx].type != NODE_DIR) {
+    return -1;
+  }
+
+  current_dir = idx;
+  return 0;
+}
+
+/*
+ * ls - List directory contents
+ */
+void cmd_ls(const char *args) {
+  int dir = current_dir;
+
+  if (args[0] != '\0') {
+    dir = resolve_path(args);
+    if (dir < 0) {
+      kprintf("ls: %s: No such directory\n", args);
+      return;
+    }
+  }
+
+  kprintf("\n");
+
+  int count = 0;
+  for (int i = nodes[dir].first_child; i >= 0; i = nodes[i].next_sibling) {
+    if (nodes[i].type == NODE_DIR) {
+      kprintf_color(nodes[i].name, VGA_COLOR_CYAN);
+      kprintf("/\n");
+    } else {
+      /* Simple format without width specifier */
+      kprintf("%s", nodes[i].name);
+      /* Pad to 20 chars */
+      int len = strlen(nodes[i].name);
+      for (int p = len; p < 20; p++)
+        kprintf(" ");
+      kprintf("%d bytes\n", nodes[i].size);
+    }
+    count++;
+  }
+
+  if (count == 0) {
+    kprintf("(empty)\n");
+  }
+  kprintf("\n");
+}
+
+/*
+ * cat - Show file contents
+ */
+void cmd_cat(const char *args) {
+  if (args[0] == '\0') {
+    kprintf("Usage: cat <filename>\n");
+    return;
+  }
+
+  int idx = resolve_path(args);
+  if (idx < 0) {
+    kprintf_color("File not found: ", VGA_COLOR_RED);
+    kprintf("%s\n", args);
+    return;
+  }
+
+  if (nodes[idx].type == NODE_DIR) {
+    kprintf_color("Is a directory\n", VGA_COLOR_RED);
+    return;
+  }
+
+  /* Stream the file one extent at a time */
+  kprintf("\n");
+  char chunk[EXTENT_SIZE + 1];
+  uint32_t off = 0;
+  char last = '\n';
+  while (off < nodes[idx].size) {
+    size_t got = node_read(&nodes[idx], off, (uint8_t *)chunk, EXTENT_SIZE);
+    if (got == 0)
+      break;
+    chunk[got] = '\0';
+    kprintf("%s", chunk);
+    last = chunk[got - 1];
+    off += got;
+  }
+  if (last != '\n') {
+    kprintf("\n");
+  }
+  kprintf("\n");
+}
+
+/*
+ * touch - Create empty file
+ */
+void cmd_touch(const char *args) {
+  if (args[0] == '\0') {
+    kprintf("Usage: touch <filename>\n");
+    return;
+  }
+
+  if (find_in_dir(current_dir, args)) {
+    return; /* Already exists */
+  }
+
+  int idx = alloc_node();
+  if (idx < 0) {
+    kprintf_color("Filesystem full\n", VGA_COLOR_RED);
+    return;
+  }
+
+  nodes[idx].type = NODE_FILE;
+  strncpy(nodes[idx].name, args, MAX_NAME - 1);
+  attach_node(idx, current_dir);
+  nodes[idx].size = 0;
+
+  kprintf("Created: %s\n", args);
+}
+
+/*
+ * rm - Remove file or directory
+ */
+void cmd_rm(const char *args) {
+  if (args[0] == '\0') {
+    kprintf("Usage: rm [-rf] <file>\n");
+    return;
+  }
+
+  const char *target = args;
+  int recursive = 0;
+
+  if (args[0] == '-') {
+    if (strncmp(args, "-rf", 3) == 0 || strncmp(args, "-r", 2) == 0) {
+      recursive = 1;
+    }
+    while (*target && *target != ' ')
+      target++;
+    while (*target == ' ')
+      target++;
+  }
+
+  int idx = resolve_path(target);
+  if (idx < 0) {
+    kprintf("rm: %s: No such file\n", target);
+    return;
+  }
+
+  if (idx == 0) {
+    kprintf("rm: cannot remove root\n");
+    return;
+  }
+
+  if (nodes[idx].type == NODE_DIR && !recursive) {
+    kprintf("rm: %s: Is a directory (use -rf)\n", target);
+    return;
+  }
+
+  /* Remove node and children */
+  if (nodes[idx].type == NODE_DIR) {
+    /* Remove children first */
+    int i = nodes[idx].first_child;
+    while (i >= 0) {
+      int next = nodes[i].next_sibling;
+      detach_node(i);
+      node_free_data(&nodes[i]);
+      nodes[i].type = NODE_FREE;
+      i = next;
+    }
+  }
+
+  detach_node(idx);
+  node_free_data(&nodes[idx]);
+  nodes[idx].type = NODE_FREE;
+  kprintf("Removed: %s\n", target);
+}
+
+/*
+ * pwd - Print working directory
+ */
+void cmd_pwd(const char *args) {
+  (void)args;
+  kprintf("%s\n", fhs_getcwd());
+}
+
+/*
+ * fs_write - Write to file
+ */
+int fs_write(const char *name, const char *data, size_t len) {
+  int idx = resolve_path(name);
+
+  if (idx >= 0 && !node_access(idx, PERM_WRITE))
+    return -1; /* Permission denied */
+
+  if (idx < 0) {
+    /* Create new file */
+    idx = alloc_node();
+    if (idx < 0)
+      return -1;
+
+    nodes[idx].type = NODE_FILE;
+    strncpy(nodes[idx].name, name, MAX_NAME - 1);
+    attach_node(idx, current_dir);
+  }
+
+  /* Replace contents: drop the old chain, then grow a fresh one */
+  node_free_data(&nodes[idx]);
+  if (node_write(&nodes[idx], 0, (const uint8_t *)data, len) < len)
+    return -1; /* Out of memory */
+
+  return 0;
+}
+
+/*
+ * fs_read - Read file
+ */
+int fs_read(const char *name, char *buf, size_t max) {
+  int idx = resolve_path(name);
+  if (idx < 0 || nodes[idx].type == NODE_DIR) {
+    return -1;
+  }
+  if (!node_access(idx, PERM_READ))
+    return -1; /* Permission denied */
+
+  return node_read(&nodes[idx], 0, (uint8_t *)buf, max);
+}
+
+/*
+ * Streaming file handles
+ * ======================
+ * fs_open returns a small descriptor carrying a node and a position,
+ * so tools can read or write files a chunk at a time instead of
+ * copying whole files through stack buffers. fs_append in particular
+ * writes only the new bytes at the end of the extent chain, so log
+ * appends no longer cost a full-file copy.
+ */
+
+#define MAX_HANDLES 8
+
+typedef struct {
+  int node;     /* Node index, or -1 if free */
+  uint32_t pos; /* Current read/write offset */
+  int in_use;
+} fs_handle_t;
+
+static fs_handle_t handles[MAX_HANDLES];
+
+/*
+ * fs_open - Open a file, optionally creating it (FS_O_CREATE)
+ * Returns a descriptor >= 0, or -1 on error
+ */
+int fs_open(const char *name, int flags) {
+  int idx = resolve_path(name);
+
+  if (idx >= 0 && !node_access(idx, PERM_READ))
+    return -1; /* Permission denied */
+
+  if (idx < 0) {
+    if (!(flags & FS_O_CREATE))
+      return -1;
+    idx = alloc_node();
+    if (idx < 0)
+      return -1;
+    nodes[idx].type = NODE_FILE;
+    strncpy(nodes[idx].name, name, MAX_NAME - 1);
+    attach_node(idx, current_dir);
+  }
+
+  if (nodes[idx].type == NODE_DIR)
+    return -1;
+
+  for (int fd = 0; fd < MAX_HANDLES; fd++) {
+    if (!handles[fd].in_use) {
+      handles[fd].node = idx;
+      handles[fd].pos = 0;
+      handles[fd].in_use = 1;
+      return fd;
+    }
+  }
+  return -1; /* No free handle */
+}
+
+void fs_close(int fd) {
+  if (fd >= 0 && fd < MAX_HANDLES)
+    handles[fd].in_use = 0;
+}
+
+/* Validate a descriptor, returning its handle or NULL */
+static fs_handle_t *fs_handle(int fd) {
+  if (fd < 0 || fd >= MAX_HANDLES || !handles[fd].in_use)
+    return NULL;
+  return &handles[fd];
+}
+
+/*
+ * fs_fsize - Size of an open file
+ */
+int fs_fsize(int fd) {
+  fs_handle_t *h = fs_handle(fd);
+  return h ? (int)nodes[h->node].size : -1;
+}
+
+/*
+ * fs_seek - Set the handle's position
+ */
+int fs_seek(int fd, uint32_t off) {
+  fs_handle_t *h = fs_handle(fd);
+  if (!h)
+    return -1;
+  h->pos = off;
+  return 0;
+}
+
+/*
+ * fs_pread - Read at the handle's position, advancing it
+ * Returns bytes read (0 at EOF), or -1 on a bad descriptor
+ */
+int fs_pread(int fd, char *buf, size_t max) {
+  fs_handle_t *h = fs_handle(fd);
+  if (!h)
+    return -1;
+  size_t got = node_read(&nodes[h->node], h->pos, (uint8_t *)buf, max);
+  h->pos += got;
+  return got;
+}
+
+/*
+ * fs_pwrite - Write at the handle's position, advancing it
+ * Returns bytes written, or -1 on a bad descriptor
+ */
+int fs_pwrite(int fd, const char *buf, size_t len) {
+  fs_handle_t *h = fs_handle(fd);
+  if (!h)
+    return -1;
+  size_t put = node_write(&nodes[h->node], h->pos, (const uint8_t *)buf, len);
+  h->pos += put;
+  return put;
+}
+
+/*
+ * fs_append - Write at end of file
+ * Returns bytes written, or -1 on a bad descriptor
+ */
+int fs_append(int fd, const char *buf, size_t len) {
+  fs_handle_t *h = fs_handle(fd);
+  if (!h)
+    return -1;
+  return node_write(&nodes[h->node], nodes[h->node].size,
+                    (const uint8_t *)buf, len);
+}
+
+/*
+ * Echo with redirect
+ */
+void cmd_echo_file(const char *args) {
+  const char *p = args;
+  const char *redirect = NULL;
+  int append = 0;
+
+  while (*p) {
+    if (*p == '>') {
+      redirect = p;
+      if (*(p + 1) == '>')
+        append = 1;
+      break;
+    }
+    p++;
+  }
+
+  if (!redirect) {
+    kprintf("%s\n", args);
+    return;
+  }
+
+  /* Get text */
+  char text[256];
+  int i = 0;
+  p = args;
+  while (p < redirect && i < 255) {
+    text[i++] = *p++;
+  }
+  while (i > 0 && text[i - 1] == ' ')
+    i--;
+  text[i] = '\0';
+
+  /* Get filename */
+  p = redirect + 1 + append;
+  while (*p == ' ')
+    p++;
+
+  char filename[64];
+  i = 0;
+  while (*p && *p != ' ' && i < 63) {
+    filename[i++] = *p++;
+  }
+  filename[i] = '\0';
+
+  if (filename[0] == '\0') {
+    kprintf("Missing filename\n");
+    return;
+  }
+
+  /* Append newline */
+  strcat(text, "\n");
+
+  fs_write(filename, text, strlen(text));
+  kprintf("Wrote to %s\n", filename);
+}
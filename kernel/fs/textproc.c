@@ -13,14 +13,150 @@ extern void shell_execute_simple(const char *cmd);
 extern int pipe_is_active(void);
 extern void pipe_write_char(char c);
 
+/* ============ Streaming line engine ============ */
+
+/*
+ * Shared by the text-processing commands: the file is pulled through
+ * an offset-based fs handle in chunks and handed to the callback one
+ * line at a time, so nothing materializes the whole file and the
+ * size ceiling is the filesystem's, not a stack buffer's.  Output
+ * goes through vga_write, which the pipe layer already intercepts in
+ * bulk, so stages compose without extra copies.
+ */
+#define STREAM_CHUNK 512
+#define STREAM_LINE_MAX 256
+
+/* Newline scan, word at a time: XOR replicates the target byte to
+ * zero and the classic (v - 0x01010101) & ~v & 0x80808080 test
+ * flags any zero byte in the word */
+static const char *find_nl(const char *p, const char *end) {
+  while (p < end && ((size_t)p & 3)) {
+    if (*p == '\n')
+      return p;
+    p++;
+  }
+  while (end - p >= 4) {
+    uint32_t v = *(const uint32_t *)p ^ 0x0A0A0A0Au;
+    if ((v - 0x01010101u) & ~v & 0x80808080u)
+      break;
+    p += 4;
+  }
+  while (p < end) {
+    if (*p == '\n')
+      return p;
+    p++;
+  }
+  return NULL;
+}
+
+/*
+ * Stream a file through fn line by line (line is NUL-terminated,
+ * newline stripped; overlong lines are split at STREAM_LINE_MAX-1).
+ * Returns 0, or -1 if the file cannot be opened.
+ */
+int stream_lines(const char *filename, line_fn_t fn, void *ctx) {
+  int fd = fs_open(filename, 0);
+  if (fd < 0)
+    return -1;
+
+  char buf[STREAM_CHUNK];
+  char line[STREAM_LINE_MAX];
+  int line_len = 0;
+  int len;
+
+  while ((len = fs_pread(fd, buf, sizeof(buf))) > 0) {
+    const char *p = buf;
+    const char *end = buf + len;
+    while (p < end) {
+      const char *nl = find_nl(p, end);
+      const char *seg_end = nl ? nl : end;
+      while (p < seg_end) {
+        int room = STREAM_LINE_MAX - 1 - line_len;
+        int take = (int)(seg_end - p);
+        if (take > room)
+          take = room;
+        memcpy(line + line_len, p, take);
+        line_len += take;
+        p += take;
+        if (line_len == STREAM_LINE_MAX - 1) {
+          line[line_len] = '\0';
+          fn(line, line_len, ctx);
+          line_len = 0;
+        }
+      }
+      if (nl) {
+        line[line_len] = '\0';
+        fn(line, line_len, ctx);
+        line_len = 0;
+        p = nl + 1;
+      }
+    }
+  }
+  fs_close(fd);
+
+  /* Final line without a trailing newline */
+  if (line_len > 0) {
+    line[line_len] = '\0';
+    fn(line, line_len, ctx);
+  }
+  return 0;
+}
+
+/* ============ tr ============ */
+
+/* Expand ranges like a-z into dst; returns length */
+static int tr_expand(const char *src, char *dst) {
+  int n = 0;
+  for (const char *p = src; *p && n < 255; p++) {
+    if (*(p + 1) == '-' && *(p + 2)) {
+      char start = *p, end = *(p + 2);
+      for (char c = start; c <= end && n < 255; c++)
+        dst[n++] = c;
+      p += 2;
+    } else {
+      dst[n++] = *p;
+    }
+  }
+  dst[n] = '\0';
+  return n;
+}
+
+/* Build the 256-entry translation table from two set specs */
+static void tr_build(char *trans, const char *from, const char *to) {
+  char from_exp[256], to_exp[256];
+
+  for (int i = 0; i < 256; i++)
+    trans[i] = i;
+
+  int fi = tr_expand(from, from_exp);
+  int ti = tr_expand(to, to_exp);
+
+  int len = fi < ti ? fi : ti;
+  for (int i = 0; i < len; i++)
+    trans[(unsigned char)from_exp[i]] = to_exp[i];
+}
+
+typedef struct {
+  char trans[256];
+} tr_ctx_t;
+
+static void tr_line(const char *line, int len, void *vctx) {
+  tr_ctx_t *ctx = (tr_ctx_t *)vctx;
+  char out[STREAM_LINE_MAX];
+  for (int i = 0; i < len; i++)
+    out[i] = ctx->trans[(unsigned char)line[i]];
+  vga_write(out, len);
+  vga_write("\n", 1);
+}
+
 /*
  * tr - Translate characters
- * Usage: tr <from> <to>
- * Example: tr a-z A-Z    (uppercase)
- *          tr abc xyz    (a->x, b->y, c->z)
+ * Usage: tr <from> <to> [file]
+ * Example: tr a-z A-Z file.txt  (uppercase)
+ *          tr abc xyz           (a->x, b->y, c->z, piped)
  */
 void cmd_tr(const char *args) {
-  char from[64] = "", to[64] = "";
+  char from[64] = "", to[64] = "", filename[64] = "";
 
   /* Parse arguments */
   const char *p = args;
@@ -42,94 +178,51 @@ void cmd_tr(const char *args) {
     to[i++] = *p++;
   to[i] = '\0';
 
+  while (*p == ' ')
+    p++;
+
+  i = 0;
+  while (*p && *p != ' ' && i < 63)
+    filename[i++] = *p++;
+  filename[i] = '\0';
+
   if (from[0] == '\0' || to[0] == '\0') {
-    kprintf("Usage: tr <from> <to>\n");
+    kprintf("Usage: tr <from> <to> [file]\n");
     kprintf("  e.g: echo hello | tr a-z A-Z\n");
     return;
   }
 
-  /* Expand ranges like a-z */
-  char from_exp[256], to_exp[256];
-  int fi = 0, ti = 0;
-
-  for (p = from; *p && fi < 255; p++) {
-    if (*(p + 1) == '-' && *(p + 2)) {
-      char start = *p, end = *(p + 2);
-      for (char c = start; c <= end && fi < 255; c++) {
-        from_exp[fi++] = c;
-      }
-      p += 2;
-    } else {
-      from_exp[fi++] = *p;
-    }
-  }
-  from_exp[fi] = '\0';
-
-  for (p = to; *p && ti < 255; p++) {
-    if (*(p + 1) == '-' && *(p + 2)) {
-      char start = *p, end = *(p + 2);
-      for (char c = start; c <= end && ti < 255; c++) {
-        to_exp[ti++] = c;
-      }
-      p += 2;
-    } else {
-      to_exp[ti++] = *p;
-    }
+  if (filename[0] == '\0') {
+    /* tr without a file requires piped input */
+    kprintf("tr: use with pipe, e.g: cat file | tr a-z A-Z\n");
+    return;
   }
-  to_exp[ti] = '\0';
 
-  /* tr requires piped input - this shows usage */
-  kprintf("tr: use with pipe, e.g: cat file | tr a-z A-Z\n");
+  tr_ctx_t ctx;
+  tr_build(ctx.trans, from, to);
+  if (stream_lines(filename, tr_line, &ctx) < 0)
+    kprintf("tr: cannot read %s\n", filename);
 }
 
 /*
  * tr with piped input (called from shell_pipe.c)
  */
 void tr_process(const char *input, const char *from, const char *to) {
-  /* Build translation table */
   char trans[256];
-  for (int i = 0; i < 256; i++)
-    trans[i] = i;
-
-  /* Expand ranges */
-  char from_exp[256], to_exp[256];
-  int fi = 0, ti = 0;
-  const char *p;
-
-  for (p = from; *p && fi < 255; p++) {
-    if (*(p + 1) == '-' && *(p + 2)) {
-      char start = *p, end = *(p + 2);
-      for (char c = start; c <= end && fi < 255; c++)
-        from_exp[fi++] = c;
-      p += 2;
-    } else {
-      from_exp[fi++] = *p;
-    }
-  }
-  from_exp[fi] = '\0';
+  char out[STREAM_LINE_MAX];
+  tr_build(trans, from, to);
 
-  for (p = to; *p && ti < 255; p++) {
-    if (*(p + 1) == '-' && *(p + 2)) {
-      char start = *p, end = *(p + 2);
-      for (char c = start; c <= end && ti < 255; c++)
-        to_exp[ti++] = c;
-      p += 2;
-    } else {
-      to_exp[ti++] = *p;
-    }
-  }
-  to_exp[ti] = '\0';
-
-  /* Build translation */
-  int len = fi < ti ? fi : ti;
-  for (int i = 0; i < len; i++) {
-    trans[(unsigned char)from_exp[i]] = to_exp[i];
-  }
-
-  /* Translate and output */
+  /* Translate in buffered runs */
+  int n = 0;
   for (const char *c = input; *c; c++) {
-    kprintf("%c", trans[(unsigned char)*c]);
+    out[n++] = trans[(unsigned char)*c];
+    if (n == sizeof(out)) {
+      vga_write(out, n);
+      n = 0;
+    }
   }
+  if (n > 0)
+    vga_write(out, n);
 }
 
 /*
@@ -216,6 +309,35 @@ void xargs_process(const char *input, const char *cmd) {
 void sed_process(const char *input, const char *pattern, const char *replace,
                  int global);
 
+/* Per-line substitute: emit up-to-match, replacement, then the rest */
+typedef struct {
+  strsearch_t search;
+  int pat_len;
+  const char *replace;
+  int rep_len;
+  int global;
+} sed_ctx_t;
+
+static void sed_line(const char *line, int len, void *vctx) {
+  sed_ctx_t *ctx = (sed_ctx_t *)vctx;
+  const char *p = line;
+  int remaining = len;
+
+  while (ctx->pat_len > 0 && remaining >= ctx->pat_len) {
+    const char *hit = strsearch_find(&ctx->search, p, remaining);
+    if (!hit)
+      break;
+    vga_write(p, hit - p);
+    vga_write(ctx->replace, ctx->rep_len);
+    remaining -= (int)(hit - p) + ctx->pat_len;
+    p = hit + ctx->pat_len;
+    if (!ctx->global)
+      break;
+  }
+  vga_write(p, remaining);
+  vga_write("\n", 1);
+}
+
 /*
  * sed - Stream editor (basic)
  * Usage: sed s/pattern/replacement/ [file]
@@ -285,16 +407,16 @@ void cmd_sed(const char *args) {
     return;
   }
 
-  /* Read file and process */
-  char buffer[4096];
-  int len = fs_read(filename, buffer, 4095);
-  if (len < 0) {
-    kprintf("sed: cannot read %s\n", filename);
-    return;
-  }
-  buffer[len] = '\0';
+  /* Stream the file line by line */
+  sed_ctx_t ctx;
+  ctx.pat_len = strlen(pattern);
+  ctx.replace = replacement;
+  ctx.rep_len = strlen(replacement);
+  ctx.global = global;
+  strsearch_compile(&ctx.search, pattern);
 
-  sed_process(buffer, pattern, replacement, global);
+  if (stream_lines(filename, sed_line, &ctx) < 0)
+    kprintf("sed: cannot read %s\n", filename);
 }
 
 /*
@@ -303,32 +425,40 @@ void cmd_sed(const char *args) {
 void sed_process(const char *input, const char *pattern, const char *replace,
                  int global) {
   int pat_len = strlen(pattern);
-  int rep_len = strlen(replace);
+
+  if (pat_len == 0) {
+    kprintf("%s", input);
+    return;
+  }
+
+  /* Compile once, then jump from match to match instead of testing
+   * the pattern at every position */
+  strsearch_t search;
+  strsearch_compile(&search, pattern);
 
   const char *p = input;
-  while (*p) {
-    /* Check for pattern match */
-    int match = 1;
-    for (int i = 0; i < pat_len && p[i]; i++) {
-      if (p[i] != pattern[i]) {
-        match = 0;
-        break;
-      }
-    }
+  int remaining = strlen(input);
 
-    if (match && pat_len > 0) {
-      /* Output replacement */
-      kprintf("%s", replace);
-      p += pat_len;
-      if (!global) {
-        /* Output rest unchanged */
-        kprintf("%s", p);
-        return;
-      }
-    } else {
+  while (remaining >= pat_len) {
+    const char *hit = strsearch_find(&search, p, remaining);
+    if (!hit)
+      break;
+
+    /* Output text before the match, then the replacement */
+    while (p < hit) {
       kprintf("%c", *p++);
+      remaining--;
     }
+    kprintf("%s", replace);
+    p += pat_len;
+    remaining -= pat_len;
+
+    if (!global)
+      break;
   }
+
+  /* Output the rest unchanged */
+  kprintf("%s", p);
 }
 
 /*
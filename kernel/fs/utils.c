@@ -10,23 +10,6 @@
 extern const char *fhs_getcwd(void);
 extern int fs_read(const char *name, char *buf, size_t max);
 
-/* Simple strstr implementation */
-static char *utils_strstr(const char *haystack, const char *needle) {
-  if (!*needle)
-    return (char *)haystack;
-  for (; *haystack; haystack++) {
-    const char *h = haystack;
-    const char *n = needle;
-    while (*h && *n && *h == *n) {
-      h++;
-      n++;
-    }
-    if (!*n)
-      return (char *)haystack;
-  }
-  return NULL;
-}
-
 /* Simple snprintf implementation */
 static int utils_snprintf(char *str, size_t size, const char *fmt, ...) {
   va_list args;
@@ -34,29 +17,26 @@ static int utils_snprintf(char *str, size_t size, const char *fmt, ...) {
   size_t i = 0;
   while (*fmt && i < size - 1) {
     if (*fmt == '%') {
+      char pad = ' ';
+      int width = 0;
       fmt++;
+      if (*fmt == '0') {
+        pad = '0';
+        fmt++;
+      }
+      while (*fmt >= '0' && *fmt <= '9') {
+        width = width * 10 + (*fmt - '0');
+        fmt++;
+      }
       if (*fmt == 's') {
         const char *s = va_arg(args, const char *);
         while (*s && i < size - 1)
           str[i++] = *s++;
       } else if (*fmt == 'd') {
-        int n = va_arg(args, int);
-        char num[16];
-        int j = 0;
-        if (n < 0) {
-          str[i++] = '-';
-          n = -n;
-        }
-        if (n == 0) {
-          str[i++] = '0';
-        } else {
-          while (n > 0 && j < 15) {
-            num[j++] = '0' + (n % 10);
-            n /= 10;
-          }
-          while (j > 0 && i < size - 1)
-            str[i++] = num[--j];
-        }
+        i += fmt_int(str + i, size - 1 - i, va_arg(args, int), 10, width, pad);
+      } else if (*fmt == 'x') {
+        i += fmt_uint(str + i, size - 1 - i, va_arg(args, unsigned int), 16,
+                      width, pad);
       } else {
         str[i++] = *fmt;
       }
@@ -71,7 +51,7 @@ static int utils_snprintf(char *str, size_t size, const char *fmt, ...) {
 }
 
 /* External from ramfs.c - we need access to nodes */
-#define MAX_NODES 128
+#define MAX_NODES 256
 #define MAX_NAME 32
 #define NODE_FREE 0
 #define NODE_FILE 1
@@ -82,9 +62,15 @@ typedef struct {
   uint8_t type;
   int parent;
   uint32_t size;
-  uint8_t data[4096];
+  void *extents; /* Data chain, private to ramfs.c */
   uint32_t created;
   uint32_t modified;
+  int first_child;
+  int next_sibling;
+  int hash_next;
+  uint16_t uid;
+  uint16_t gid;
+  uint16_t mode;
 } fs_node_ext_t;
 
 /* Get node array from ramfs */
@@ -100,31 +86,29 @@ static void find_recursive(int parent, const char *pattern,
   if (!nodes)
     return;
 
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].type != NODE_FREE && nodes[i].parent == parent) {
-      /* Build full path */
-      char path[256];
-      if (strcmp(base_path, "/") == 0) {
-        utils_snprintf(path, 256, "/%s", nodes[i].name);
-      } else {
-        utils_snprintf(path, 256, "%s/%s", base_path, nodes[i].name);
-      }
-
-      /* Check if name matches pattern (simple substring) */
-      if (pattern[0] == '\0' || utils_strstr(nodes[i].name, pattern)) {
-        if (nodes[i].type == NODE_DIR) {
-          kprintf_color(path, VGA_COLOR_CYAN);
-          kprintf("/\n");
-        } else {
-          kprintf("%s\n", path);
-        }
-      }
+  for (int i = nodes[parent].first_child; i >= 0; i = nodes[i].next_sibling) {
+    /* Build full path */
+    char path[256];
+    if (strcmp(base_path, "/") == 0) {
+      utils_snprintf(path, 256, "/%s", nodes[i].name);
+    } else {
+      utils_snprintf(path, 256, "%s/%s", base_path, nodes[i].name);
+    }
 
-      /* Recurse into directories */
+    /* Check if name matches pattern (simple substring) */
+    if (pattern[0] == '\0' || strsearch_strstr(nodes[i].name, pattern)) {
       if (nodes[i].type == NODE_DIR) {
-        find_recursive(i, pattern, path);
+        kprintf_color(path, VGA_COLOR_CYAN);
+        kprintf("/\n");
+      } else {
+        kprintf("%s\n", path);
       }
     }
+
+    /* Recurse into directories */
+    if (nodes[i].type == NODE_DIR) {
+      find_recursive(i, pattern, path);
+    }
   }
 }
 
@@ -146,7 +130,7 @@ void cmd_find(const char *args) {
   }
 
   /* Look for -name */
-  const char *name_arg = utils_strstr(args, "-name");
+  const char *name_arg = strsearch_strstr(args, "-name");
   if (name_arg) {
     name_arg += 5;
     while (*name_arg == ' ')
@@ -241,12 +225,10 @@ static int du_recursive(int parent) {
     return 0;
 
   int total = 0;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].type != NODE_FREE && nodes[i].parent == parent) {
-      total += nodes[i].size;
-      if (nodes[i].type == NODE_DIR) {
-        total += du_recursive(i);
-      }
+  for (int i = nodes[parent].first_child; i >= 0; i = nodes[i].next_sibling) {
+    total += nodes[i].size;
+    if (nodes[i].type == NODE_DIR) {
+      total += du_recursive(i);
     }
   }
   return total;
@@ -264,8 +246,8 @@ void cmd_du(const char *args) {
   kprintf("\n");
 
   /* Show size of each top-level directory */
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].type == NODE_DIR && nodes[i].parent == 0) {
+  for (int i = nodes[0].first_child; i >= 0; i = nodes[i].next_sibling) {
+    if (nodes[i].type == NODE_DIR) {
       int size = du_recursive(i);
       kprintf("%d\t/%s\n", size, nodes[i].name);
     }
@@ -285,38 +267,36 @@ void cmd_more(const char *args) {
     return;
   }
 
-  char buffer[4096];
-  int len = fs_read(args, buffer, 4095);
-
-  if (len < 0) {
+  int fd = fs_open(args, 0);
+  if (fd < 0) {
     kprintf("more: cannot open '%s'\n", args);
     return;
   }
 
-  buffer[len] = '\0';
-
+  /* Stream the file in chunks, paging every 20 lines */
+  char buffer[512];
+  int size = fs_fsize(fd);
+  int shown = 0;
   int lines = 0;
-  const char *p = buffer;
-
-  while (*p) {
-    /* Print one line */
-    while (*p && *p != '\n') {
-      kprintf("%c", *p++);
-    }
-    if (*p == '\n') {
-      kprintf("\n");
-      p++;
-      lines++;
-    }
-
-    /* Pause every 20 lines */
-    if (lines >= 20 && *p) {
-      kprintf("--More-- (Press any key)");
-      keyboard_getchar();
-      kprintf("\r                        \r");
-      lines = 0;
+  int len;
+
+  while ((len = fs_pread(fd, buffer, sizeof(buffer))) > 0) {
+    for (int i = 0; i < len; i++) {
+      kprintf("%c", buffer[i]);
+      shown++;
+      if (buffer[i] == '\n')
+        lines++;
+
+      /* Pause every 20 lines */
+      if (lines >= 20 && shown < size) {
+        kprintf("--More-- (Press any key)");
+        keyboard_getchar();
+        kprintf("\r                        \r");
+        lines = 0;
+      }
     }
   }
+  fs_close(fd);
 }
 
 /*
@@ -420,6 +400,33 @@ void cmd_ln(const char *args) {
   (void)args;
 }
 
+/* One line of cut: emit the requested field, if present */
+typedef struct {
+  char delim;
+  int field;
+} cut_ctx_t;
+
+static void cut_line(const char *line, int len, void *vctx) {
+  cut_ctx_t *ctx = (cut_ctx_t *)vctx;
+  int current_field = 1;
+  int start = 0;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    if (line[i] == ctx->delim) {
+      if (current_field == ctx->field)
+        break;
+      current_field++;
+      start = i + 1;
+    }
+  }
+
+  if (current_field == ctx->field) {
+    vga_write(line + start, i - start);
+    vga_write("\n", 1);
+  }
+}
+
 /*
  * cut - Extract columns from text
  * Usage: cut -d<delim> -f<field> [file]
@@ -459,55 +466,15 @@ void cmd_cut(const char *args) {
   if (field < 1)
     field = 1;
 
-  char buffer[4096];
-  int len = 0;
-
-  if (filename[0]) {
-    len = fs_read(filename, buffer, 4095);
-    if (len < 0) {
-      kprintf("cut: %s: No such file\n", filename);
-      return;
-    }
-    buffer[len] = '\0';
-  } else {
+  if (filename[0] == '\0') {
     kprintf("Usage: cut -d<delim> -f<field> <file>\n");
     return;
   }
 
-  /* Process each line */
-  const char *line = buffer;
-  while (*line) {
-    /* Find the requested field */
-    int current_field = 1;
-    const char *field_start = line;
-    const char *field_end = line;
-
-    while (*field_end && *field_end != '\n') {
-      if (*field_end == delim) {
-        if (current_field == field)
-          break;
-        current_field++;
-        field_start = field_end + 1;
-      }
-      field_end++;
-    }
-
-    if (current_field == field) {
-      /* Print the field */
-      const char *end = field_end;
-      if (*end == delim)
-        end--;
-      while (field_start <= end && *field_start != delim &&
-             *field_start != '\n') {
-        kprintf("%c", *field_start++);
-      }
-      kprintf("\n");
-    }
-
-    /* Move to next line */
-    while (*line && *line != '\n')
-      line++;
-    if (*line == '\n')
-      line++;
-  }
+  /* Stream the file line by line */
+  cut_ctx_t ctx;
+  ctx.delim = delim;
+  ctx.field = field;
+  if (stream_lines(filename, cut_line, &ctx) < 0)
+    kprintf("cut: %s: No such file\n", filename);
 }
@@ -7,6 +7,8 @@
 
 #include "../kernel.h"
 
+extern void proc_sleep(uint32_t ms);
+
 /* Color palette */
 #define COL_BG 0x0A1628      /* Dark navy */
 #define COL_TASKBAR 0x1A1A2E /* Dark purple */
@@ -31,6 +33,17 @@ static int cursor_x = 400;
 static int cursor_y = 300;
 static int show_menu = 0;
 static int active_app = 0; /* 0=none, 1=terminal, 2=files, 3=about */
+static int scene_dirty = 1; /* Desktop needs a full repaint */
+
+/* Save-under cursor: pixels beneath the cursor are saved before it is
+ * drawn and restored when it moves, so cursor motion costs a small
+ * copy instead of a full desktop repaint */
+#define CURSOR_SAVE_W 16
+#define CURSOR_SAVE_H 16
+static uint32_t cursor_save[CURSOR_SAVE_W * CURSOR_SAVE_H];
+static int cursor_saved = 0;
+static int cursor_save_x = 0;
+static int cursor_save_y = 0;
 
 /*
  * Draw a window with title bar
@@ -142,6 +155,37 @@ static void draw_cursor(void) {
   gfx_draw_line(cursor_x, cursor_y, cursor_x + 12, cursor_y + 12, COL_WHITE);
 }
 
+/*
+ * Restore whatever was underneath the cursor
+ */
+static void cursor_hide(void) {
+  if (!cursor_saved)
+    return;
+  for (int row = 0; row < CURSOR_SAVE_H; row++) {
+    for (int col = 0; col < CURSOR_SAVE_W; col++) {
+      gfx_pixel(cursor_save_x + col, cursor_save_y + row,
+                cursor_save[row * CURSOR_SAVE_W + col]);
+    }
+  }
+  cursor_saved = 0;
+}
+
+/*
+ * Save the pixels under the cursor position, then draw it
+ */
+static void cursor_show(void) {
+  for (int row = 0; row < CURSOR_SAVE_H; row++) {
+    for (int col = 0; col < CURSOR_SAVE_W; col++) {
+      cursor_save[row * CURSOR_SAVE_W + col] =
+          gfx_read_pixel(cursor_x + col, cursor_y + row);
+    }
+  }
+  cursor_save_x = cursor_x;
+  cursor_save_y = cursor_y;
+  cursor_saved = 1;
+  draw_cursor();
+}
+
 /*
  * Wait for a new keypress
  */
@@ -151,8 +195,12 @@ static void wait_for_key(void) {
   while (keyboard_getchar_nonblocking() != 0)
     ;
   while (keyboard_getchar_nonblocking() == 0) {
-    for (volatile int i = 0; i < 50000; i++)
-      ;
+    if (timer_is_running()) {
+      proc_sleep(20);
+    } else {
+      for (volatile int i = 0; i < 50000; i++)
+        ;
+    }
   }
 }
 
@@ -170,6 +218,7 @@ static void show_terminal(void) {
   gfx_draw_text(tx, ty + 124, "[Press Q to exit desktop]", COL_YELLOW);
   gfx_draw_text(tx + 100, ty + 220, "Press any key", COL_ACCENT);
 
+  gfx_flush();
   wait_for_key();
 }
 
@@ -203,6 +252,7 @@ static void show_files(void) {
 
   gfx_draw_text(tx + 160, ty + 120, "Press any key", COL_ACCENT);
 
+  gfx_flush();
   wait_for_key();
 }
 
@@ -226,6 +276,7 @@ static void show_about(void) {
 
   gfx_draw_text(tx + 80, ty + 260, "Press any key", COL_ACCENT);
 
+  gfx_flush();
   wait_for_key();
 }
 
@@ -278,6 +329,7 @@ static int handle_input(void) {
     int ty = screen_h - taskbar_h;
     if (cursor_x >= 5 && cursor_x <= 85 && cursor_y >= ty + 5) {
       show_menu = !show_menu;
+      scene_dirty = 1;
     }
   }
 
@@ -300,41 +352,69 @@ void desktop_start(void) {
   active_app = 0;
   show_menu = 0;
 
+  scene_dirty = 1;
+  cursor_saved = 0;
+  int last_cx = cursor_x;
+  int last_cy = cursor_y;
+
   while (running) {
-    /* Draw desktop */
-    gfx_clear_screen(COL_BG);
-    draw_icons();
-    draw_taskbar();
-    draw_start_menu();
-
-    /* Help text */
-    gfx_draw_text(screen_w - 220, screen_h - 80, "1:Term 2:Files 3:About",
-                  COL_GREY);
-    gfx_draw_text(screen_w - 180, screen_h - 60, "Q:Quit WASD:Move", COL_GREY);
-
-    /* Handle active application */
+    /* Handle active application (modal - repaint afterwards) */
     if (active_app == 1) {
       show_terminal();
       active_app = 0;
+      scene_dirty = 1;
     } else if (active_app == 2) {
       show_files();
       active_app = 0;
+      scene_dirty = 1;
     } else if (active_app == 3) {
       show_about();
       active_app = 0;
+      scene_dirty = 1;
     }
 
-    /* Draw cursor */
-    draw_cursor();
+    if (scene_dirty) {
+      /* Full repaint - invalidates the cursor's saved pixels */
+      scene_dirty = 0;
+      cursor_saved = 0;
+
+      gfx_clear_screen(COL_BG);
+      draw_icons();
+      draw_taskbar();
+      draw_start_menu();
+
+      /* Help text */
+      gfx_draw_text(screen_w - 220, screen_h - 80, "1:Term 2:Files 3:About",
+                    COL_GREY);
+      gfx_draw_text(screen_w - 180, screen_h - 60, "Q:Quit WASD:Move",
+                    COL_GREY);
+
+      cursor_show();
+      gfx_flush();
+      last_cx = cursor_x;
+      last_cy = cursor_y;
+    } else if (cursor_x != last_cx || cursor_y != last_cy) {
+      /* Only the cursor moved: restore what was under it and redraw
+       * at the new position - no scene repaint */
+      cursor_hide();
+      cursor_show();
+      gfx_flush();
+      last_cx = cursor_x;
+      last_cy = cursor_y;
+    }
 
     /* Handle input */
     if (handle_input()) {
       running = 0;
     }
 
-    /* Frame delay */
-    for (volatile int i = 0; i < 50000; i++)
-      ;
+    /* Frame delay - sleep when the PIT ticks, spin otherwise */
+    if (timer_is_running()) {
+      proc_sleep(20);
+    } else {
+      for (volatile int i = 0; i < 50000; i++)
+        ;
+    }
   }
 }
 
@@ -1,134 +1,225 @@
-/*
- * NanoSec OS - Graphics Abstraction Layer
- * ========================================
- * Unified graphics API that automatically uses VESA or VGA
- * Provides consistent interface regardless of video mode
- */
-
-#include "../kernel.h"
-
-/* Graphics mode state */
-static int gfx_mode = 0; /* 0=none, 1=VGA 320x200, 2=VESA 800x600 */
-static int screen_width = 0;
-static int screen_height = 0;
-
-/*
- * Initialize graphics - auto-detect best mode
- * Returns: 0=success, -1=failure
- */
-int gfx_init_auto(uint32_t mb_magic, uint32_t *mb_info) {
-  /* Try VESA first (if multiboot with framebuffer) */
-  if (vesa_init(mb_magic, mb_info) == 0) {
-    gfx_mode = 2;
-    screen_width = 800;
-    screen_height = 600;
-    return 0;
-  }
-
-  /* Fall back to VGA Mode 13h */
-  /* gfx_init() would set VGA mode - for now just fail */
-  gfx_mode = 0;
-  return -1;
-}
-
-/*
- * Check if graphics mode is active
- */
-int gfx_mode_active(void) { return gfx_mode > 0; }
-
-/*
- * Check if using VESA high resolution
- */
-int gfx_is_vesa(void) { return gfx_mode == 2; }
-
-/*
- * Get screen dimensions
- */
-void gfx_get_screen_size(int *w, int *h) {
-  if (w)
-    *w = screen_width;
-  if (h)
-    *h = screen_height;
-}
-
-/*
- * Clear screen with color
- */
-void gfx_clear_screen(uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_clear(color);
-  }
-}
-
-/*
- * Draw pixel
- */
-void gfx_pixel(int x, int y, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_put_pixel(x, y, color);
-  }
-}
-
-/*
- * Draw line
- */
-void gfx_draw_line(int x0, int y0, int x1, int y1, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_line(x0, y0, x1, y1, color);
-  }
-}
-
-/*
- * Draw rectangle outline
- */
-void gfx_draw_rect(int x, int y, int w, int h, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_rect(x, y, w, h, color);
-  }
-}
-
-/*
- * Fill rectangle
- */
-void gfx_draw_fill_rect(int x, int y, int w, int h, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_fill_rect(x, y, w, h, color);
-  }
-}
-
-/*
- * Draw horizontal line
- */
-void gfx_draw_hline(int x, int y, int len, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_hline(x, y, len, color);
-  }
-}
-
-/*
- * Draw character
- */
-void gfx_draw_char(int x, int y, char c, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_draw_char(x, y, c, color);
-  }
-}
-
-/*
- * Draw string
- */
-void gfx_draw_text(int x, int y, const char *str, uint32_t color) {
-  if (gfx_mode == 2) {
-    vesa_draw_string(x, y, str, color);
-  }
-}
-
-/*
- * String length helper
- */
-int gfx_strlen(const char *s) {
-  int len = 0;
-  while (*s++)
-    len++;
-  return len;
-}
+/*
+ * NanoSec OS - Graphics Abstraction Layer
+ * ========================================
+ * Unified graphics API over the active video backend.
+ *
+ * The backend is an ops table bound once in gfx_init_auto, so a draw
+ * call is a single indirect jump instead of a mode branch per call
+ * (per pixel, in the worst case).  Batch primitives - span fill,
+ * blit, text run - are first-class ops, so the window manager can
+ * issue a handful of backend calls per frame rather than going
+ * through the per-pixel entry point.  Before init the table points
+ * at no-ops, so early calls are safe without a mode check.
+ */
+
+#include "../kernel.h"
+
+/* Backend operations, bound once at init */
+typedef struct {
+  void (*clear)(uint32_t color);
+  void (*pixel)(int x, int y, uint32_t color);
+  uint32_t (*read_pixel)(int x, int y);
+  void (*line)(int x0, int y0, int x1, int y1, uint32_t color);
+  void (*rect)(int x, int y, int w, int h, uint32_t color);
+  void (*fill_rect)(int x, int y, int w, int h, uint32_t color);
+  void (*blit)(int sx, int sy, int dx, int dy, int w, int h);
+  void (*hline)(int x, int y, int len, uint32_t color);
+  void (*draw_char)(int x, int y, char c, uint32_t color);
+  void (*text)(int x, int y, const char *str, uint32_t color);
+  void (*flush)(void);
+} gfx_ops_t;
+
+/* ============ No-op backend (graphics not initialized) ============ */
+
+static void null_clear(uint32_t color) { (void)color; }
+static void null_pixel(int x, int y, uint32_t color) {
+  (void)x;
+  (void)y;
+  (void)color;
+}
+static uint32_t null_read_pixel(int x, int y) {
+  (void)x;
+  (void)y;
+  return 0;
+}
+static void null_line(int x0, int y0, int x1, int y1, uint32_t color) {
+  (void)x0;
+  (void)y0;
+  (void)x1;
+  (void)y1;
+  (void)color;
+}
+static void null_rect(int x, int y, int w, int h, uint32_t color) {
+  (void)x;
+  (void)y;
+  (void)w;
+  (void)h;
+  (void)color;
+}
+static void null_blit(int sx, int sy, int dx, int dy, int w, int h) {
+  (void)sx;
+  (void)sy;
+  (void)dx;
+  (void)dy;
+  (void)w;
+  (void)h;
+}
+static void null_hline(int x, int y, int len, uint32_t color) {
+  (void)x;
+  (void)y;
+  (void)len;
+  (void)color;
+}
+static void null_draw_char(int x, int y, char c, uint32_t color) {
+  (void)x;
+  (void)y;
+  (void)c;
+  (void)color;
+}
+static void null_text(int x, int y, const char *str, uint32_t color) {
+  (void)x;
+  (void)y;
+  (void)str;
+  (void)color;
+}
+static void null_flush(void) {}
+
+static const gfx_ops_t null_ops = {
+    .clear = null_clear,
+    .pixel = null_pixel,
+    .read_pixel = null_read_pixel,
+    .line = null_line,
+    .rect = null_rect,
+    .fill_rect = null_rect,
+    .blit = null_blit,
+    .hline = null_hline,
+    .draw_char = null_draw_char,
+    .text = null_text,
+    .flush = null_flush,
+};
+
+/* ============ VESA backend ============ */
+
+/* vesa.c signatures match the ops table exactly, so the table binds
+ * the driver entry points directly - no adapter layer */
+static const gfx_ops_t vesa_ops = {
+    .clear = vesa_clear,
+    .pixel = vesa_put_pixel,
+    .read_pixel = vesa_get_pixel,
+    .line = vesa_line,
+    .rect = vesa_rect,
+    .fill_rect = vesa_fill_rect,
+    .blit = vesa_blit,
+    .hline = vesa_hline,
+    .draw_char = vesa_draw_char,
+    .text = vesa_draw_string,
+    .flush = vesa_flush,
+};
+
+/* Graphics mode state */
+static int gfx_mode = 0; /* 0=none, 1=VGA 320x200, 2=VESA 800x600 */
+static int screen_width = 0;
+static int screen_height = 0;
+static const gfx_ops_t *ops = &null_ops;
+
+/*
+ * Initialize graphics - auto-detect best mode
+ * Returns: 0=success, -1=failure
+ */
+int gfx_init_auto(uint32_t mb_magic, uint32_t *mb_info) {
+  /* Try VESA first (if multiboot with framebuffer) */
+  if (vesa_init(mb_magic, mb_info) == 0) {
+    gfx_mode = 2;
+    screen_width = 800;
+    screen_height = 600;
+    ops = &vesa_ops;
+    return 0;
+  }
+
+  /* Fall back to VGA Mode 13h: a mode-13h ops table would bind the
+   * drivers/video.c entry points here once that path is validated */
+  gfx_mode = 0;
+  ops = &null_ops;
+  return -1;
+}
+
+/*
+ * Check if graphics mode is active
+ */
+int gfx_mode_active(void) { return gfx_mode > 0; }
+
+/*
+ * Check if using VESA high resolution
+ */
+int gfx_is_vesa(void) { return gfx_mode == 2; }
+
+/*
+ * Get screen dimensions
+ */
+void gfx_get_screen_size(int *w, int *h) {
+  if (w)
+    *w = screen_width;
+  if (h)
+    *h = screen_height;
+}
+
+/* Every entry point below is one indirect call into the bound
+ * backend - no mode branch */
+
+void gfx_clear_screen(uint32_t color) { ops->clear(color); }
+
+void gfx_pixel(int x, int y, uint32_t color) { ops->pixel(x, y, color); }
+
+uint32_t gfx_read_pixel(int x, int y) { return ops->read_pixel(x, y); }
+
+void gfx_draw_line(int x0, int y0, int x1, int y1, uint32_t color) {
+  ops->line(x0, y0, x1, y1, color);
+}
+
+void gfx_draw_rect(int x, int y, int w, int h, uint32_t color) {
+  ops->rect(x, y, w, h, color);
+}
+
+void gfx_draw_fill_rect(int x, int y, int w, int h, uint32_t color) {
+  ops->fill_rect(x, y, w, h, color);
+}
+
+/*
+ * Copy a rectangle within the screen (drag, scroll)
+ */
+void gfx_blit(int sx, int sy, int dx, int dy, int w, int h) {
+  ops->blit(sx, sy, dx, dy, w, h);
+}
+
+/*
+ * Draw horizontal span
+ */
+void gfx_draw_hline(int x, int y, int len, uint32_t color) {
+  ops->hline(x, y, len, color);
+}
+
+void gfx_draw_char(int x, int y, char c, uint32_t color) {
+  ops->draw_char(x, y, c, color);
+}
+
+/*
+ * Draw a text run
+ */
+void gfx_draw_text(int x, int y, const char *str, uint32_t color) {
+  ops->text(x, y, str, color);
+}
+
+/*
+ * Present the frame - copy pending changes to the framebuffer
+ */
+void gfx_flush(void) { ops->flush(); }
+
+/*
+ * String length helper
+ */
+int gfx_strlen(const char *s) {
+  int len = 0;
+  while (*s++)
+    len++;
+  return len;
+}
@@ -27,12 +27,21 @@
 #define COLOR_BUTTON 7        /* Light grey */
 #define COLOR_BUTTON_TEXT 0   /* Black */
 
+/* Screen size (VGA mode 13h layer) */
+#define WM_SCREEN_W 320
+#define WM_SCREEN_H 200
+
+/* Cursor bounding box for damage purposes */
+#define CURSOR_W 8
+#define CURSOR_H 10
+
 /* Window structure */
 typedef struct {
   int x, y, width, height;
   char title[32];
   uint8_t flags;
   uint8_t bg_color;
+  uint8_t dirty; /* Content changed since last composite */
   void (*draw_callback)(int win_id, int x, int y, int w, int h);
   void (*click_callback)(int win_id, int x, int y, int button);
 } window_t;
@@ -45,6 +54,9 @@ static struct {
   int drag_offset_x, drag_offset_y;
   int cursor_x, cursor_y;
   int running;
+  /* Accumulated screen damage (union of all changes this frame).
+   * damage_w == 0 means nothing to repaint. */
+  int damage_x, damage_y, damage_w, damage_h;
 } wm;
 
 /* External functions */
@@ -53,9 +65,14 @@ extern void gfx_put_pixel(int x, int y, uint8_t color);
 extern void gfx_line(int x0, int y0, int x1, int y1, uint8_t color);
 extern void gfx_rect(int x, int y, int w, int h, uint8_t color);
 extern void gfx_fill_rect(int x, int y, int w, int h, uint8_t color);
+extern void gfx_glyph_row(int x, int y, uint8_t bits, uint8_t color);
+extern uint8_t gfx_get_pixel(int x, int y);
 extern void mouse_get_pos(int *x, int *y);
 extern uint8_t mouse_get_buttons(void);
 extern int mouse_left_pressed(void);
+extern uint32_t mouse_motion_count(void);
+extern void gfx_wait_vsync(void);
+extern void proc_sleep(uint32_t ms);
 
 /* Simple 8x8 font for GUI */
 static const uint8_t font_8x8[96][8] = {
@@ -72,13 +89,9 @@ static void draw_char(int x, int y, char c, uint8_t color) {
     c = '?';
   int idx = c - 32;
 
+  /* One row-blit per font row instead of a per-pixel call loop */
   for (int row = 0; row < 8; row++) {
-    uint8_t bits = font_8x8[idx][row];
-    for (int col = 0; col < 8; col++) {
-      if (bits & (0x80 >> col)) {
-        gfx_put_pixel(x + col, y + row, color);
-      }
-    }
+    gfx_glyph_row(x, y + row, font_8x8[idx][row], color);
   }
 }
 
@@ -92,6 +105,79 @@ static void draw_string(int x, int y, const char *str, uint8_t color) {
   }
 }
 
+/*
+ * Full window bounds including border and title bar
+ */
+static void win_bounds(const window_t *win, int *x, int *y, int *w, int *h) {
+  int title_height = (win->flags & WIN_TITLE_BAR) ? 16 : 0;
+  *x = win->x - 1;
+  *y = win->y - 1;
+  *w = win->width + 2;
+  *h = win->height + title_height + 2;
+}
+
+/*
+ * Grow the frame's damage region to cover a rectangle
+ */
+static void damage_add(int x, int y, int w, int h) {
+  /* Clip to screen */
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > WM_SCREEN_W)
+    w = WM_SCREEN_W - x;
+  if (y + h > WM_SCREEN_H)
+    h = WM_SCREEN_H - y;
+  if (w <= 0 || h <= 0)
+    return;
+
+  if (wm.damage_w == 0) {
+    wm.damage_x = x;
+    wm.damage_y = y;
+    wm.damage_w = w;
+    wm.damage_h = h;
+    return;
+  }
+
+  /* Union with existing damage */
+  int x1 = wm.damage_x + wm.damage_w;
+  int y1 = wm.damage_y + wm.damage_h;
+  if (x < wm.damage_x)
+    wm.damage_x = x;
+  if (y < wm.damage_y)
+    wm.damage_y = y;
+  if (x + w > x1)
+    x1 = x + w;
+  if (y + h > y1)
+    y1 = y + h;
+  wm.damage_w = x1 - wm.damage_x;
+  wm.damage_h = y1 - wm.damage_y;
+}
+
+/*
+ * Damage a window's on-screen footprint
+ */
+static void damage_window(const window_t *win) {
+  int x, y, w, h;
+  win_bounds(win, &x, &y, &w, &h);
+  damage_add(x, y, w, h);
+}
+
+/*
+ * Mark a window's content as changed so the next wm_draw repaints it.
+ * Called by applications when their draw_callback output is stale.
+ */
+void wm_mark_dirty(int id) {
+  if (id >= 0 && id < MAX_WINDOWS) {
+    wm.windows[id].dirty = 1;
+  }
+}
+
 /*
  * Initialize window manager
  */
@@ -120,6 +206,7 @@ int wm_create_window(int x, int y, int w, int h, const char *title,
       win->height = h;
       win->flags = flags | WIN_VISIBLE;
       win->bg_color = COLOR_WINDOW_BG;
+      win->dirty = 1;
       win->draw_callback = NULL;
       win->click_callback = NULL;
       strncpy(win->title, title, 31);
@@ -141,6 +228,8 @@ int wm_create_window(int x, int y, int w, int h, const char *title,
  */
 void wm_destroy_window(int id) {
   if (id >= 0 && id < MAX_WINDOWS) {
+    /* Whatever was underneath needs repainting */
+    damage_window(&wm.windows[id]);
     wm.windows[id].flags = 0;
     if (wm.active_window == id) {
       wm.active_window = -1;
@@ -216,28 +305,153 @@ static void draw_cursor(int x, int y) {
   gfx_line(x, y, x + 7, y + 7, 15);
 }
 
+/* Save-under cursor: the pixels beneath the cursor rectangle are
+ * saved before drawing it and restored on move, so cursor motion
+ * never needs a scene composite. */
+static struct {
+  uint8_t pixels[CURSOR_W * CURSOR_H];
+  int x, y;
+  int visible;
+} cursor_save;
+
+static void cursor_hide(void) {
+  if (!cursor_save.visible)
+    return;
+  for (int row = 0; row < CURSOR_H; row++) {
+    for (int col = 0; col < CURSOR_W; col++) {
+      gfx_put_pixel(cursor_save.x + col, cursor_save.y + row,
+                    cursor_save.pixels[row * CURSOR_W + col]);
+    }
+  }
+  cursor_save.visible = 0;
+}
+
+static void cursor_show(int x, int y) {
+  if (cursor_save.visible)
+    cursor_hide();
+  for (int row = 0; row < CURSOR_H; row++) {
+    for (int col = 0; col < CURSOR_W; col++) {
+      cursor_save.pixels[row * CURSOR_W + col] =
+          gfx_get_pixel(x + col, y + row);
+    }
+  }
+  cursor_save.x = x;
+  cursor_save.y = y;
+  cursor_save.visible = 1;
+  draw_cursor(x, y);
+}
+
+/*
+ * Rectangle intersection test
+ */
+static int rects_intersect(int ax, int ay, int aw, int ah, int bx, int by,
+                           int bw, int bh) {
+  return ax < bx + bw && bx < ax + aw && ay < by + bh && by < ay + ah;
+}
+
 /*
- * Draw all windows and desktop
+ * Check if window id is completely hidden by a window drawn after it.
+ * All windows are opaque, so full containment means occlusion.
+ */
+static int window_occluded(int id) {
+  int x, y, w, h;
+  win_bounds(&wm.windows[id], &x, &y, &w, &h);
+
+  for (int i = 0; i < MAX_WINDOWS; i++) {
+    window_t *above = &wm.windows[i];
+    if (i == id || !(above->flags & WIN_VISIBLE))
+      continue;
+    /* Drawn after id: higher array index, or the active window */
+    if (i != wm.active_window && (id == wm.active_window || i < id))
+      continue;
+
+    int ax, ay, aw, ah;
+    win_bounds(above, &ax, &ay, &aw, &ah);
+    if (x >= ax && y >= ay && x + w <= ax + aw && y + h <= ay + ah)
+      return 1;
+  }
+  return 0;
+}
+
+/*
+ * Composite the damaged part of the frame: repaint the desktop under
+ * the damage region, then every window that touches it, back to
+ * front. Frames with no damage cost nothing.
  */
 void wm_draw(void) {
-  /* Draw desktop */
-  gfx_clear(COLOR_DESKTOP);
+  /* A burst of mouse packets since the last frame is one position
+   * change - the cursor moves save-under, no scene composite */
+  static uint32_t last_motion = 0;
+  uint32_t motion = mouse_motion_count();
+  if (motion != last_motion) {
+    last_motion = motion;
+    mouse_get_pos(&wm.cursor_x, &wm.cursor_y);
+  }
 
-  /* Draw windows (back to front) */
+  /* Windows whose content changed damage their footprint */
   for (int i = 0; i < MAX_WINDOWS; i++) {
-    if (i != wm.active_window) {
-      draw_window(i);
+    if ((wm.windows[i].flags & WIN_VISIBLE) && wm.windows[i].dirty) {
+      damage_window(&wm.windows[i]);
+      wm.windows[i].dirty = 0;
     }
   }
 
-  /* Draw active window on top */
+  if (wm.damage_w == 0) {
+    /* Scene unchanged: only the cursor may need to move */
+    if (!cursor_save.visible || wm.cursor_x != cursor_save.x ||
+        wm.cursor_y != cursor_save.y) {
+      cursor_show(wm.cursor_x, wm.cursor_y);
+    }
+    return;
+  }
+
+  /* Lift the cursor so the composite does not bake it into the
+   * scene (and its saved pixels stay valid) */
+  cursor_hide();
+
+  /* Land the repaint during vertical retrace to avoid tearing */
+  gfx_wait_vsync();
+
+  /* Repaint desktop under the damage */
+  gfx_fill_rect(wm.damage_x, wm.damage_y, wm.damage_w, wm.damage_h,
+                COLOR_DESKTOP);
+
+  /* Redraw windows touching the damage (back to front), skipping any
+   * that are fully hidden by windows above them */
+  for (int i = 0; i < MAX_WINDOWS; i++) {
+    if (i == wm.active_window)
+      continue;
+    window_t *win = &wm.windows[i];
+    if (!(win->flags & WIN_VISIBLE))
+      continue;
+
+    int x, y, w, h;
+    win_bounds(win, &x, &y, &w, &h);
+    if (!rects_intersect(x, y, w, h, wm.damage_x, wm.damage_y, wm.damage_w,
+                         wm.damage_h))
+      continue;
+    if (window_occluded(i))
+      continue;
+    draw_window(i);
+  }
+
+  /* Active window on top */
   if (wm.active_window >= 0) {
-    draw_window(wm.active_window);
+    window_t *win = &wm.windows[wm.active_window];
+    int x, y, w, h;
+    win_bounds(win, &x, &y, &w, &h);
+    if ((win->flags & WIN_VISIBLE) &&
+        rects_intersect(x, y, w, h, wm.damage_x, wm.damage_y, wm.damage_w,
+                        wm.damage_h)) {
+      draw_window(wm.active_window);
+    }
   }
 
-  /* Draw cursor */
-  mouse_get_pos(&wm.cursor_x, &wm.cursor_y);
-  draw_cursor(wm.cursor_x, wm.cursor_y);
+  /* Put the cursor back on top */
+  cursor_show(wm.cursor_x, wm.cursor_y);
+
+  wm.damage_w = 0;
+  wm.damage_h = 0;
 }
 
 /*
@@ -257,8 +471,15 @@ void wm_handle_input(void) {
   if (wm.dragging >= 0) {
     if (buttons & 1) {
       window_t *win = &wm.windows[wm.dragging];
-      win->x = mx - wm.drag_offset_x;
-      win->y = my - wm.drag_offset_y;
+      int nx = mx - wm.drag_offset_x;
+      int ny = my - wm.drag_offset_y;
+      if (nx != win->x || ny != win->y) {
+        /* Damage the union of old and new bounds */
+        damage_window(win);
+        win->x = nx;
+        win->y = ny;
+        damage_window(win);
+      }
     } else {
       wm.dragging = -1;
     }
@@ -292,13 +513,16 @@ void wm_handle_input(void) {
           wm.drag_offset_y = my - win->y;
         }
 
-        /* Activate window */
+        /* Activate window - both title bars change color and the
+         * newly raised window may reveal itself */
         if (wm.active_window != i) {
           if (wm.active_window >= 0) {
             wm.windows[wm.active_window].flags &= ~WIN_ACTIVE;
+            wm.windows[wm.active_window].dirty = 1;
           }
           wm.active_window = i;
           win->flags |= WIN_ACTIVE;
+          win->dirty = 1;
         }
         return;
       }
@@ -318,19 +542,78 @@ void wm_handle_input(void) {
   }
 }
 
+/* Frame pacing: target interval in PIT ticks (100Hz -> 3 ticks is
+ * ~33 FPS) */
+#define WM_TICK_HZ 100
+#define WM_FRAME_TICKS 3
+
+/* Frame-time/FPS overlay, toggled for measurement */
+static int wm_show_fps = 0;
+static int wm_fps_value = 0;
+
+void wm_toggle_fps(void) {
+  wm_show_fps = !wm_show_fps;
+  /* Repaint what the overlay covered when switching it off */
+  damage_add(0, 0, 100, 12);
+}
+
+static void draw_fps_overlay(void) {
+  char buf[16];
+  int p = 0;
+  buf[p++] = 'F';
+  buf[p++] = 'P';
+  buf[p++] = 'S';
+  buf[p++] = ' ';
+  p += fmt_uint(buf + p, sizeof(buf) - 1 - p, (uint32_t)wm_fps_value, 10, 0,
+                ' ');
+  buf[p] = '\0';
+
+  gfx_fill_rect(0, 0, 8 * p + 4, 12, 0);
+  draw_string(2, 2, buf, 15);
+}
+
 /*
- * Run window manager main loop
+ * Run window manager main loop, paced to WM_FRAME_TICKS per frame:
+ * the remainder of each frame interval is spent in proc_sleep rather
+ * than a busy spin. Until the PIT is known to tick, the old delay
+ * loop stays in place so we never sleep on a dead timer.
  */
 void wm_run(void) {
   wm.running = 1;
 
+  /* First frame paints everything */
+  damage_add(0, 0, WM_SCREEN_W, WM_SCREEN_H);
+
+  uint32_t frame_start = timer_get_ticks();
+  uint32_t fps_window = frame_start;
+  int frames = 0;
+
   while (wm.running) {
     wm_handle_input();
     wm_draw();
+    if (wm_show_fps)
+      draw_fps_overlay();
+
+    frames++;
+    uint32_t now = timer_get_ticks();
+    if (now - fps_window >= WM_TICK_HZ) {
+      wm_fps_value = (frames * WM_TICK_HZ) / (now - fps_window);
+      frames = 0;
+      fps_window = now;
+    }
 
-    /* Small delay */
-    for (volatile int i = 0; i < 10000; i++)
-      ;
+    if (timer_is_running()) {
+      /* Sleep away the rest of the frame interval */
+      uint32_t elapsed = now - frame_start;
+      if (elapsed < WM_FRAME_TICKS)
+        proc_sleep((WM_FRAME_TICKS - elapsed) * (1000 / WM_TICK_HZ));
+      frame_start = timer_get_ticks();
+    } else {
+      /* PIT not running in this boot configuration */
+      for (volatile int i = 0; i < 10000; i++)
+        ;
+      frame_start = now;
+    }
   }
 }
 
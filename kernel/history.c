@@ -1,221 +1,420 @@
-/*
- * NanoSec OS - Command History and Aliases
- * ==========================================
- */
-
-#include "kernel.h"
-
-/* Command history */
-#define HISTORY_SIZE 32
-#define MAX_CMD_LEN 256
-
-static char history[HISTORY_SIZE][MAX_CMD_LEN];
-static int history_count = 0;
-static int history_pos = 0;
-
-/* Aliases */
-#define MAX_ALIASES 16
-#define MAX_ALIAS_NAME 16
-
-typedef struct {
-  char name[MAX_ALIAS_NAME];
-  char command[MAX_CMD_LEN];
-  int set;
-} alias_t;
-
-static alias_t aliases[MAX_ALIASES];
-
-/*
- * Add command to history
- */
-void history_add(const char *cmd) {
-  if (cmd[0] == '\0')
-    return;
-
-  /* Don't add duplicates */
-  if (history_count > 0) {
-    int last = (history_count - 1) % HISTORY_SIZE;
-    if (strcmp(history[last], cmd) == 0)
-      return;
-  }
-
-  strncpy(history[history_count % HISTORY_SIZE], cmd, MAX_CMD_LEN - 1);
-  history_count++;
-  history_pos = history_count;
-}
-
-/*
- * Get previous command (up arrow)
- */
-const char *history_prev(void) {
-  if (history_pos > 0 && history_count > 0) {
-    history_pos--;
-    int idx = history_pos % HISTORY_SIZE;
-    if (history_pos < history_count - HISTORY_SIZE) {
-      history_pos = history_count - HISTORY_SIZE;
-    }
-    return history[idx];
-  }
-  return NULL;
-}
-
-/*
- * Get next command (down arrow)
- */
-const char *history_next(void) {
-  if (history_pos < history_count - 1) {
-    history_pos++;
-    return history[history_pos % HISTORY_SIZE];
-  }
-  history_pos = history_count;
-  return "";
-}
-
-/*
- * Show command history
- */
-void cmd_history(const char *args) {
-  (void)args;
-
-  int start = 0;
-  if (history_count > HISTORY_SIZE) {
-    start = history_count - HISTORY_SIZE;
-  }
-
-  kprintf("\n");
-  for (int i = start; i < history_count; i++) {
-    kprintf("  %3d  %s\n", i + 1, history[i % HISTORY_SIZE]);
-  }
-  kprintf("\n");
-}
-
-/* ============ Aliases ============ */
-
-/*
- * Set alias
- */
-int alias_set(const char *name, const char *command) {
-  /* Check if exists */
-  for (int i = 0; i < MAX_ALIASES; i++) {
-    if (aliases[i].set && strcmp(aliases[i].name, name) == 0) {
-      strncpy(aliases[i].command, command, MAX_CMD_LEN - 1);
-      return 0;
-    }
-  }
-
-  /* Find empty slot */
-  for (int i = 0; i < MAX_ALIASES; i++) {
-    if (!aliases[i].set) {
-      strncpy(aliases[i].name, name, MAX_ALIAS_NAME - 1);
-      strncpy(aliases[i].command, command, MAX_CMD_LEN - 1);
-      aliases[i].set = 1;
-      return 0;
-    }
-  }
-
-  return -1;
-}
-
-/*
- * Get alias
- */
-const char *alias_get(const char *name) {
-  for (int i = 0; i < MAX_ALIASES; i++) {
-    if (aliases[i].set && strcmp(aliases[i].name, name) == 0) {
-      return aliases[i].command;
-    }
-  }
-  return NULL;
-}
-
-/*
- * Unset alias
- */
-int alias_unset(const char *name) {
-  for (int i = 0; i < MAX_ALIASES; i++) {
-    if (aliases[i].set && strcmp(aliases[i].name, name) == 0) {
-      aliases[i].set = 0;
-      return 0;
-    }
-  }
-  return -1;
-}
-
-/*
- * alias command
- * Usage: alias name='command' or alias (show all)
- */
-void cmd_alias(const char *args) {
-  if (args[0] == '\0') {
-    /* Show all */
-    kprintf("\n");
-    for (int i = 0; i < MAX_ALIASES; i++) {
-      if (aliases[i].set) {
-        kprintf("alias %s='%s'\n", aliases[i].name, aliases[i].command);
-      }
-    }
-    kprintf("\n");
-    return;
-  }
-
-  /* Parse name=command or name='command' */
-  char name[MAX_ALIAS_NAME], command[MAX_CMD_LEN];
-  int i = 0;
-  const char *p = args;
-
-  while (*p && *p != '=' && i < MAX_ALIAS_NAME - 1) {
-    name[i++] = *p++;
-  }
-  name[i] = '\0';
-
-  if (*p == '=') {
-    p++;
-    if (*p == '\'' || *p == '"')
-      p++; /* Skip quote */
-
-    i = 0;
-    while (*p && *p != '\'' && *p != '"' && i < MAX_CMD_LEN - 1) {
-      command[i++] = *p++;
-    }
-    command[i] = '\0';
-
-    alias_set(name, command);
-    kprintf("alias %s='%s'\n", name, command);
-  } else {
-    /* Show this alias */
-    const char *cmd = alias_get(name);
-    if (cmd) {
-      kprintf("alias %s='%s'\n", name, cmd);
-    } else {
-      kprintf("alias: %s not found\n", name);
-    }
-  }
-}
-
-/*
- * unalias command
- */
-void cmd_unalias(const char *args) {
-  if (args[0] == '\0') {
-    kprintf("Usage: unalias <name>\n");
-    return;
-  }
-
-  if (alias_unset(args) == 0) {
-    kprintf("Removed alias: %s\n", args);
-  } else {
-    kprintf("Alias not found: %s\n", args);
-  }
-}
-
-/*
- * Initialize default aliases
- */
-void alias_init(void) {
-  memset(aliases, 0, sizeof(aliases));
-
-  alias_set("ll", "ls");
-  alias_set("cls", "clear");
-  alias_set("q", "halt");
-  alias_set("?", "help");
-}
+/*
+ * NanoSec OS - Command History and Aliases
+ * ==========================================
+ * History is a growable ring of interned lines: each unique command
+ * is stored once (deduplicated through a small hash), and the ring
+ * holds pointers, so depth costs four bytes per entry instead of a
+ * 256-byte copy.  The ring starts small and doubles up to HIST_MAX
+ * entries, after which it recycles the oldest slots.
+ *
+ * Entries are also chained per leading character, newest first, so
+ * the incremental search behind Ctrl-R only walks lines that share
+ * the prefix's initial rather than the whole window.
+ */
+
+#include "kernel.h"
+
+#define HIST_INITIAL 64
+#define HIST_MAX 1024
+#define MAX_CMD_LEN 256
+
+static char **hist = NULL;  /* ring of interned line pointers */
+static int *hist_link = NULL; /* per-slot: previous entry, same initial */
+static int hist_cap = 0;
+static int history_count = 0; /* lines ever added (free-running) */
+static int history_pos = 0;
+
+/* Newest history index per leading character, -1 when none */
+static int first_head[128];
+static int hist_ready = 0;
+
+/* Interned line pool: one kmalloc'd copy per unique command, found
+ * again through a djb2-chained table.  Lines are never freed - a
+ * recycled ring slot just drops its pointer */
+#define INTERN_BUCKETS 128
+
+typedef struct intern_node {
+  struct intern_node *next;
+  char *text;
+} intern_node_t;
+
+static intern_node_t *intern_tab[INTERN_BUCKETS];
+
+static uint32_t line_hash(const char *s) {
+  uint32_t hash = 5381;
+  while (*s)
+    hash = ((hash << 5) + hash) + (uint8_t)*s++; /* djb2 */
+  return hash & (INTERN_BUCKETS - 1);
+}
+
+static const char *intern_line(const char *cmd) {
+  uint32_t h = line_hash(cmd);
+  for (intern_node_t *n = intern_tab[h]; n; n = n->next) {
+    if (strcmp(n->text, cmd) == 0)
+      return n->text;
+  }
+
+  size_t len = strlen(cmd);
+  if (len >= MAX_CMD_LEN)
+    len = MAX_CMD_LEN - 1;
+  intern_node_t *n = kmalloc(sizeof(intern_node_t));
+  char *text = kmalloc(len + 1);
+  if (!n || !text) {
+    if (n)
+      kfree(n);
+    if (text)
+      kfree(text);
+    return NULL;
+  }
+  memcpy(text, cmd, len);
+  text[len] = '\0';
+  n->text = text;
+  n->next = intern_tab[h];
+  intern_tab[h] = n;
+  return text;
+}
+
+/* Oldest index still resident in the ring */
+static int hist_floor(void) {
+  return history_count > hist_cap ? history_count - hist_cap : 0;
+}
+
+/* Rebuild the per-initial chains; needed after the ring is resized
+ * because slot positions (index mod capacity) all move */
+static void rebuild_chains(void) {
+  for (int i = 0; i < 128; i++)
+    first_head[i] = -1;
+  for (int i = hist_floor(); i < history_count; i++) {
+    int c = (uint8_t)hist[i % hist_cap][0] & 127;
+    hist_link[i % hist_cap] = first_head[c];
+    first_head[c] = i;
+  }
+}
+
+/* Double the ring; on allocation failure the old ring stays and the
+ * oldest entries start getting recycled instead */
+static int hist_grow(void) {
+  int new_cap = hist_cap ? hist_cap * 2 : HIST_INITIAL;
+  char **new_hist = kmalloc(new_cap * sizeof(char *));
+  int *new_link = kmalloc(new_cap * sizeof(int));
+  if (!new_hist || !new_link) {
+    if (new_hist)
+      kfree(new_hist);
+    if (new_link)
+      kfree(new_link);
+    return -1;
+  }
+
+  for (int i = hist_floor(); i < history_count; i++)
+    new_hist[i % new_cap] = hist[i % hist_cap];
+
+  if (hist)
+    kfree(hist);
+  if (hist_link)
+    kfree(hist_link);
+  hist = new_hist;
+  hist_link = new_link;
+  hist_cap = new_cap;
+  rebuild_chains();
+  return 0;
+}
+
+/*
+ * Add command to history
+ */
+void history_add(const char *cmd) {
+  if (cmd[0] == '\0')
+    return;
+
+  if (!hist_ready) {
+    for (int i = 0; i < 128; i++)
+      first_head[i] = -1;
+    hist_ready = 1;
+  }
+
+  /* Don't add duplicates */
+  if (history_count > 0 &&
+      strcmp(hist[(history_count - 1) % hist_cap], cmd) == 0) {
+    history_pos = history_count;
+    return;
+  }
+
+  if (history_count >= hist_cap && hist_cap < HIST_MAX) {
+    if (hist_grow() < 0 && hist_cap == 0)
+      return; /* No ring at all; drop the line */
+  }
+
+  const char *line = intern_line(cmd);
+  if (!line)
+    return;
+
+  int slot = history_count % hist_cap;
+  int c = (uint8_t)line[0] & 127;
+  hist[slot] = (char *)line;
+  hist_link[slot] = first_head[c];
+  first_head[c] = history_count;
+  history_count++;
+  history_pos = history_count;
+}
+
+/*
+ * Get previous command (up arrow)
+ */
+const char *history_prev(void) {
+  if (history_pos > 0 && history_count > 0) {
+    history_pos--;
+    if (history_pos < hist_floor())
+      history_pos = hist_floor();
+    return hist[history_pos % hist_cap];
+  }
+  return NULL;
+}
+
+/*
+ * Get next command (down arrow)
+ */
+const char *history_next(void) {
+  if (history_pos < history_count - 1) {
+    history_pos++;
+    return hist[history_pos % hist_cap];
+  }
+  history_pos = history_count;
+  return "";
+}
+
+static int prefix_match(const char *line, const char *prefix, int len) {
+  for (int i = 0; i < len; i++) {
+    if (line[i] != prefix[i])
+      return 0;
+  }
+  return 1;
+}
+
+/*
+ * nth newest entry starting with prefix (0 = most recent), walking
+ * only the chain of entries that share the prefix's first character.
+ * An empty prefix indexes straight back through the ring.
+ */
+const char *history_search(const char *prefix, int nth) {
+  if (history_count == 0 || hist_cap == 0)
+    return NULL;
+
+  int len = (int)strlen(prefix);
+  if (len == 0) {
+    int idx = history_count - 1 - nth;
+    if (idx < hist_floor())
+      return NULL;
+    return hist[idx % hist_cap];
+  }
+
+  int idx = first_head[(uint8_t)prefix[0] & 127];
+  while (idx >= hist_floor()) {
+    const char *line = hist[idx % hist_cap];
+    if (prefix_match(line, prefix, len)) {
+      if (nth == 0)
+        return line;
+      nth--;
+    }
+    idx = hist_link[idx % hist_cap];
+  }
+  return NULL;
+}
+
+/*
+ * Show command history
+ * Usage: history [n] - last n entries (default 32)
+ */
+void cmd_history(const char *args) {
+  int want = 32;
+  if (args[0] >= '1' && args[0] <= '9') {
+    want = 0;
+    for (const char *p = args; *p >= '0' && *p <= '9'; p++)
+      want = want * 10 + (*p - '0');
+  }
+
+  int start = history_count - want;
+  if (start < hist_floor())
+    start = hist_floor();
+
+  kprintf("\n");
+  for (int i = start; i < history_count; i++) {
+    kprintf("  %3d  %s\n", i + 1, hist[i % hist_cap]);
+  }
+  kprintf("\n");
+}
+
+/* ============ Aliases ============ */
+
+#define MAX_ALIASES 16
+#define MAX_ALIAS_NAME 16
+
+typedef struct {
+  char name[MAX_ALIAS_NAME];
+  char command[MAX_CMD_LEN];
+  int set;
+} alias_t;
+
+static alias_t aliases[MAX_ALIASES];
+
+/* Alias names hashed the same way as the shell's command registry,
+ * so expansion on every dispatch is a probe instead of a scan */
+#define ALIAS_HASH_SIZE 64 /* Power of two, > 2x MAX_ALIASES */
+
+static int8_t alias_hash[ALIAS_HASH_SIZE];
+static int alias_hash_ready = 0;
+
+static uint32_t alias_name_hash(const char *name) {
+  uint32_t hash = 5381;
+  while (*name)
+    hash = ((hash << 5) + hash) + (uint8_t)*name++; /* djb2 */
+  return hash & (ALIAS_HASH_SIZE - 1);
+}
+
+static void alias_hash_build(void) {
+  for (int i = 0; i < ALIAS_HASH_SIZE; i++)
+    alias_hash[i] = -1;
+  for (int i = 0; i < MAX_ALIASES; i++) {
+    if (!aliases[i].set)
+      continue;
+    uint32_t slot = alias_name_hash(aliases[i].name);
+    while (alias_hash[slot] >= 0)
+      slot = (slot + 1) & (ALIAS_HASH_SIZE - 1);
+    alias_hash[slot] = (int8_t)i;
+  }
+  alias_hash_ready = 1;
+}
+
+/*
+ * Set alias
+ */
+int alias_set(const char *name, const char *command) {
+  /* Check if exists */
+  for (int i = 0; i < MAX_ALIASES; i++) {
+    if (aliases[i].set && strcmp(aliases[i].name, name) == 0) {
+      strncpy(aliases[i].command, command, MAX_CMD_LEN - 1);
+      return 0;
+    }
+  }
+
+  /* Find empty slot */
+  for (int i = 0; i < MAX_ALIASES; i++) {
+    if (!aliases[i].set) {
+      strncpy(aliases[i].name, name, MAX_ALIAS_NAME - 1);
+      strncpy(aliases[i].command, command, MAX_CMD_LEN - 1);
+      aliases[i].set = 1;
+      alias_hash_build();
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+/*
+ * Get alias
+ */
+const char *alias_get(const char *name) {
+  if (!alias_hash_ready)
+    alias_hash_build();
+  uint32_t slot = alias_name_hash(name);
+  while (alias_hash[slot] >= 0) {
+    alias_t *a = &aliases[alias_hash[slot]];
+    if (a->set && strcmp(a->name, name) == 0)
+      return a->command;
+    slot = (slot + 1) & (ALIAS_HASH_SIZE - 1);
+  }
+  return NULL;
+}
+
+/*
+ * Unset alias
+ */
+int alias_unset(const char *name) {
+  for (int i = 0; i < MAX_ALIASES; i++) {
+    if (aliases[i].set && strcmp(aliases[i].name, name) == 0) {
+      aliases[i].set = 0;
+      alias_hash_build();
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/*
+ * alias command
+ * Usage: alias name='command' or alias (show all)
+ */
+void cmd_alias(const char *args) {
+  if (args[0] == '\0') {
+    /* Show all */
+    kprintf("\n");
+    for (int i = 0; i < MAX_ALIASES; i++) {
+      if (aliases[i].set) {
+        kprintf("alias %s='%s'\n", aliases[i].name, aliases[i].command);
+      }
+    }
+    kprintf("\n");
+    return;
+  }
+
+  /* Parse name=command or name='command' */
+  char name[MAX_ALIAS_NAME], command[MAX_CMD_LEN];
+  int i = 0;
+  const char *p = args;
+
+  while (*p && *p != '=' && i < MAX_ALIAS_NAME - 1) {
+    name[i++] = *p++;
+  }
+  name[i] = '\0';
+
+  if (*p == '=') {
+    p++;
+    if (*p == '\'' || *p == '"')
+      p++; /* Skip quote */
+
+    i = 0;
+    while (*p && *p != '\'' && *p != '"' && i < MAX_CMD_LEN - 1) {
+      command[i++] = *p++;
+    }
+    command[i] = '\0';
+
+    alias_set(name, command);
+    kprintf("alias %s='%s'\n", name, command);
+  } else {
+    /* Show this alias */
+    const char *cmd = alias_get(name);
+    if (cmd) {
+      kprintf("alias %s='%s'\n", name, cmd);
+    } else {
+      kprintf("alias: %s not found\n", name);
+    }
+  }
+}
+
+/*
+ * unalias command
+ */
+void cmd_unalias(const char *args) {
+  if (args[0] == '\0') {
+    kprintf("Usage: unalias <name>\n");
+    return;
+  }
+
+  if (alias_unset(args) == 0) {
+    kprintf("Removed alias: %s\n", args);
+  } else {
+    kprintf("Alias not found: %s\n", args);
+  }
+}
+
+/*
+ * Initialize default aliases
+ */
+void alias_init(void) {
+  memset(aliases, 0, sizeof(aliases));
+
+  alias_set("ll", "ls");
+  alias_set("cls", "clear");
+  alias_set("q", "halt");
+  alias_set("?", "help");
+}
@@ -20,6 +20,33 @@ static void kernel_main_loop(void);
 static void kernel_login_prompt(void);
 static void print_banner(void);
 
+/* Boot stage thunks: adapt int-returning inits (and their status
+ * prints) to the void(void) shape boot_stage_run expects */
+static void stage_fs(void) {
+  if (fs_init() == 0) {
+    kprintf("  [OK] RAM Filesystem\n");
+  }
+  perms_init();
+}
+
+static void stage_users(void) {
+  if (user_init() == 0) {
+    kprintf("  [OK] User System\n");
+  }
+}
+
+static void stage_shell_env(void) {
+  env_init();
+  alias_init();
+  audit_init();
+  serial_init(0x3F8, 1); /* COM1, 115200 baud */
+}
+
+static void stage_net(void) {
+  kprintf("[BOOT] Initializing network...\n");
+  net_init();
+}
+
 /*
  * Kernel entry point - called from bootloader
  * Receives multiboot magic and info pointer
@@ -35,6 +62,7 @@ void kernel_main(uint32_t mb_magic, uint32_t *mb_info) {
     /* Graphics mode ready - show boot message */
     gfx_draw_text(10, 10, "NanoSec OS - VESA 800x600 Mode", 0x00FF00);
     gfx_draw_text(10, 30, "Initializing...", 0xCCCCCC);
+    gfx_flush();
   } else {
     /* Fall back to VGA text mode */
     print_banner();
@@ -44,9 +72,19 @@ void kernel_main(uint32_t mb_magic, uint32_t *mb_info) {
   kprintf("  [OK] VGA driver\n");
   kprintf("  [OK] Keyboard driver\n");
 
-  /* Initialize memory management */
+  /* Initialize memory management, sized from the Multiboot map */
   kprintf("[BOOT] Setting up memory...\n");
-  mm_init();
+  mm_init_regions(mb_magic, mb_info);
+  boot_stage_run("memory", mm_init);
+
+  /* Detect CPU features so memcpy/memset can use SSE2 when present */
+  boot_stage_run("cpu", cpu_detect);
+
+  /* Calibrate the TSC so ktime_ns() has sub-microsecond resolution */
+  boot_stage_run("tsc", timer_calibrate_tsc);
+
+  /* Anchor the wall clock: one CMOS read now, hourly resync after */
+  boot_stage_run("rtc", rtc_init);
 
   /* TIER 1 DISABLED FOR DEBUG - uncomment when working
   kprintf("[BOOT] Initializing CPU...\n");
@@ -57,37 +95,25 @@ void kernel_main(uint32_t mb_magic, uint32_t *mb_info) {
   proc_init();
   scheduler_init();
   syscall_init();
+  workqueue_init();
   */
 
   /* Initialize filesystem */
   kprintf("[BOOT] Initializing filesystem...\n");
-  if (fs_init() == 0) {
-    kprintf("  [OK] RAM Filesystem\n");
-  }
-  perms_init();
+  boot_stage_run("filesystem", stage_fs);
 
   /* Initialize user system */
   kprintf("[BOOT] Initializing users...\n");
-  if (user_init() == 0) {
-    kprintf("  [OK] User System\n");
-  }
-
-  /* Initialize environment and shell features */
-  env_init();
-  alias_init();
-  audit_init();
+  boot_stage_run("users", stage_users);
 
-  /* Initialize serial console */
-  serial_init(0x3F8, 1); /* COM1, 115200 baud */
+  /* Environment, shell features, serial console */
+  boot_stage_run("shell-env", stage_shell_env);
   klog("NanoSec OS booting...");
 
-  /* Initialize network stack */
-  kprintf("[BOOT] Initializing network...\n");
-  net_init();
-
-  /* Initialize security subsystem */
-  kprintf("[BOOT] Initializing security...\n");
-  kernel_init_security();
+  /* Network probe and the security stack that filters it can wait
+   * until the prompt is live; both run via boot_run_deferred() */
+  boot_stage_defer("network", stage_net);
+  boot_stage_defer("security", kernel_init_security);
 
   /* Enable interrupts - DISABLED until IDT works
   asm volatile("sti");
@@ -98,7 +124,9 @@ void kernel_main(uint32_t mb_magic, uint32_t *mb_info) {
 
   /* Check if graphics mode is available */
   if (gfx_mode_active()) {
-    /* Graphics mode - go directly to graphical login */
+    /* Graphics mode - the desktop needs the deferred stages up
+     * front, so run them before login */
+    boot_run_deferred();
     dm_start();
     /* If returns, user logged out - fall through to CLI */
   } else {
@@ -142,6 +170,8 @@ static void kernel_early_init(void) {
  * Initialize security subsystem
  */
 static void kernel_init_security(void) {
+  kprintf("[BOOT] Initializing security...\n");
+
   /* Initialize firewall */
   if (firewall_init() == 0) {
     kprintf("  [OK] Firewall\n");
@@ -227,19 +257,127 @@ static void kernel_login_prompt(void) {
   }
 }
 
+/* Erase the typed part of the line and replace it with text */
+static void replace_line(char *buf, int *pos, const char *text) {
+  while (*pos > 0) {
+    vga_putchar('\b');
+    vga_putchar(' ');
+    vga_putchar('\b');
+    (*pos)--;
+  }
+  while (*text && *pos < 255) {
+    buf[(*pos)++] = *text;
+    vga_putchar(*text++);
+  }
+}
+
+/* Rub out n echoed characters */
+static void erase_chars(int n) {
+  while (n-- > 0) {
+    vga_putchar('\b');
+    vga_putchar(' ');
+    vga_putchar('\b');
+  }
+}
+
+/*
+ * Ctrl-R incremental history search. Each keystroke narrows the
+ * prefix and redraws in place; Ctrl-R again steps to older matches.
+ * Returns the match to run (executed by the caller) or NULL; any
+ * other key drops the match into the edit buffer for editing.
+ */
+static const char *search_history(char *buf, int *pos) {
+  char prefix[64] = "";
+  int plen = 0, nth = 0, drawn = 0;
+  const char *match = history_search("", 0);
+
+  erase_chars(*pos);
+  *pos = 0;
+
+  while (1) {
+    erase_chars(drawn);
+    kprintf("(search)'%s': %s", prefix, match ? match : "");
+    drawn = 12 + plen + (match ? (int)strlen(match) : 0);
+
+    char c = keyboard_getchar();
+    if (c == '\n') {
+      erase_chars(drawn);
+      return match;
+    } else if (c == 0x12) { /* Ctrl-R: older match */
+      if (history_search(prefix, nth + 1))
+        nth++;
+    } else if (c == '\b') {
+      if (plen > 0)
+        prefix[--plen] = '\0';
+      nth = 0;
+    } else if (c >= ' ' && c < 127 && plen < 63) {
+      prefix[plen++] = c;
+      prefix[plen] = '\0';
+      nth = 0;
+    } else { /* ESC or other control: back to editing */
+      erase_chars(drawn);
+      if (c != 27 && match)
+        replace_line(buf, pos, match);
+      return NULL;
+    }
+    prefix[plen] = '\0';
+    match = history_search(prefix, nth);
+  }
+}
+
 /*
  * Main kernel loop - command processing
  */
 static void kernel_main_loop(void) {
   char cmd_buffer[256];
   int pos = 0;
+  int tab_pending = 0; /* Second tab in a row lists candidates */
 
   kprintf("nanosec# ");
 
+  /* Prompt is live: run the deferred boot stages, then repaint */
+  if (boot_run_deferred() > 0)
+    kprintf("nanosec# ");
+
   while (1) {
     /* Wait for keypress */
     char c = keyboard_getchar();
 
+    if (c == '\t') {
+      int n = shell_complete(cmd_buffer, &pos, tab_pending);
+      if (n > 1 && tab_pending) {
+        /* Candidates were listed; repaint prompt and line */
+        cmd_buffer[pos] = '\0';
+        kprintf("nanosec# %s", cmd_buffer);
+        tab_pending = 0;
+      } else {
+        tab_pending = (n > 1);
+      }
+      continue;
+    }
+    tab_pending = 0;
+
+    if (c == 0x10) { /* Up arrow / Ctrl-P */
+      const char *prev = history_prev();
+      if (prev)
+        replace_line(cmd_buffer, &pos, prev);
+      continue;
+    } else if (c == 0x0E) { /* Down arrow / Ctrl-N */
+      const char *next = history_next();
+      if (next)
+        replace_line(cmd_buffer, &pos, next);
+      continue;
+    } else if (c == 0x12) { /* Ctrl-R */
+      const char *match = search_history(cmd_buffer, &pos);
+      if (match) {
+        kprintf("%s\n", match);
+        shell_execute(match);
+        pos = 0;
+        kprintf("nanosec# ");
+      }
+      continue;
+    }
+
     if (c == '\n') {
       kprintf("\n");
       cmd_buffer[pos] = '\0';
@@ -292,6 +430,14 @@ void kernel_panic(const char *message) {
   vga_set_color(VGA_COLOR_RED);
   kprintf("\n\n!!! KERNEL PANIC !!!\n");
   kprintf("Error: %s\n", message);
+
+  /* Leave the flight recorder's evidence on screen before halting */
+  if (ktrace_mask)
+    ktrace_dump(16);
+
+  /* Staged audit records would otherwise die with us */
+  audit_sync();
+
   kprintf("\nSystem halted.\n");
 
   for (;;) {
@@ -300,74 +446,78 @@ void kernel_panic(const char *message) {
 }
 
 /*
- * Printf implementation
+ * Printf implementation. Output is formatted into a stack buffer and
+ * handed to the console in one vga_write, so a whole message costs a
+ * single hardware cursor update (and at most one scroll refresh)
+ * instead of port I/O per character.
  */
+#define KPRINTF_BUF 256
+
+static void kp_put(char *buf, int *pos, char c) {
+  buf[(*pos)++] = c;
+  if (*pos == KPRINTF_BUF) {
+    vga_write(buf, KPRINTF_BUF);
+    *pos = 0;
+  }
+}
+
 void kprintf(const char *fmt, ...) {
+  char out[KPRINTF_BUF];
+  int pos = 0;
   va_list args;
   va_start(args, fmt);
 
   while (*fmt) {
     if (*fmt == '%') {
+      char pad = ' ';
+      int width = 0;
       fmt++;
+      if (*fmt == '0') {
+        pad = '0';
+        fmt++;
+      }
+      while (*fmt >= '0' && *fmt <= '9') {
+        width = width * 10 + (*fmt - '0');
+        fmt++;
+      }
       switch (*fmt) {
       case 's': {
         const char *s = va_arg(args, const char *);
         while (*s)
-          vga_putchar(*s++);
+          kp_put(out, &pos, *s++);
         break;
       }
       case 'd': {
-        int n = va_arg(args, int);
-        char buf[16];
-        int i = 0;
-        int neg = 0;
-
-        if (n < 0) {
-          neg = 1;
-          n = -n;
-        }
-        if (n == 0)
-          buf[i++] = '0';
-        while (n > 0) {
-          buf[i++] = '0' + (n % 10);
-          n /= 10;
-        }
-        if (neg)
-          vga_putchar('-');
-        while (i > 0)
-          vga_putchar(buf[--i]);
+        char num[24];
+        int len = fmt_int(num, sizeof(num), va_arg(args, int), 10, width, pad);
+        for (int i = 0; i < len; i++)
+          kp_put(out, &pos, num[i]);
         break;
       }
       case 'x': {
-        unsigned int n = va_arg(args, unsigned int);
-        char hex[16];
-        int i = 0;
-        if (n == 0) {
-          vga_putchar('0');
-          break;
-        }
-        while (n > 0) {
-          int d = n & 0xF;
-          hex[i++] = d < 10 ? '0' + d : 'a' + d - 10;
-          n >>= 4;
-        }
-        while (i > 0)
-          vga_putchar(hex[--i]);
+        char num[24];
+        int len = fmt_uint(num, sizeof(num), va_arg(args, unsigned int), 16,
+                           width, pad);
+        for (int i = 0; i < len; i++)
+          kp_put(out, &pos, num[i]);
         break;
       }
       case 'c':
-        vga_putchar((char)va_arg(args, int));
+        kp_put(out, &pos, (char)va_arg(args, int));
         break;
       case '%':
-        vga_putchar('%');
+        kp_put(out, &pos, '%');
         break;
       }
       fmt++;
     } else {
-      vga_putchar(*fmt++);
+      kp_put(out, &pos, *fmt++);
     }
   }
 
+  if (pos > 0)
+    vga_write(out, pos);
+
   va_end(args);
 }
 
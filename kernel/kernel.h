@@ -61,10 +61,13 @@ void pic_eoi(uint8_t irq);
 
 void paging_init(void);
 uint32_t page_alloc(void);
+uint32_t page_alloc_order(int order);
 void page_free(uint32_t phys_addr);
 void page_map(uint32_t virt, uint32_t phys, uint32_t flags);
 void page_unmap(uint32_t virt);
 uint32_t page_get_free(void);
+uint32_t paging_new_directory(void);
+uint32_t paging_clone_directory(uint32_t src_phys);
 
 /* ============================================
  * Process Management (Tier 1)
@@ -80,8 +83,14 @@ void proc_exit(int status);
 void kprintf(const char *fmt, ...);
 void kprintf_color(const char *str, vga_color_t color);
 
+/* Integer formatting core (fmt.c) - returns chars written, clips to cap */
+int fmt_uint(char *dst, size_t cap, uint32_t value, int base, int width,
+             char pad);
+int fmt_int(char *dst, size_t cap, int value, int base, int width, char pad);
+
 /* Memory functions */
 void *memset(void *ptr, int value, size_t num);
+void *memset32(void *dst, uint32_t value, size_t count);
 void *memcpy(void *dest, const void *src, size_t num);
 int memcmp(const void *ptr1, const void *ptr2, size_t num);
 size_t strlen(const char *str);
@@ -89,6 +98,17 @@ int strcmp(const char *s1, const char *s2);
 char *strcpy(char *dest, const char *src);
 char *strncpy(char *dest, const char *src, size_t n);
 
+/* String search engine (strsearch.c): Boyer-Moore-Horspool */
+typedef struct {
+  const char *pattern;
+  int len;
+  int skip[256];
+} strsearch_t;
+
+void strsearch_compile(strsearch_t *s, const char *pattern);
+const char *strsearch_find(const strsearch_t *s, const char *text, int n);
+const char *strsearch_strstr(const char *haystack, const char *needle);
+
 /* ============================================
  * I/O Port Access (inline assembly)
  * ============================================ */
@@ -105,6 +125,12 @@ static inline uint8_t inb(uint16_t port) {
 
 static inline void io_wait(void) { outb(0x80, 0); }
 
+static inline uint64_t rdtsc(void) {
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+
 /* ============================================
  * VGA Driver
  * ============================================ */
@@ -113,6 +139,8 @@ void vga_init(void);
 void vga_clear(void);
 void vga_putchar(char c);
 void vga_puts(const char *str);
+void vga_write(const char *buf, size_t len);
+void vga_scrollback(int lines);
 void vga_set_color(vga_color_t color);
 vga_color_t vga_get_color(void);
 
@@ -123,29 +151,117 @@ vga_color_t vga_get_color(void);
 int keyboard_init(void);
 char keyboard_getchar(void);
 int keyboard_available(void);
+void keyboard_set_wait_hook(void (*hook)(void));
 
 /* ============================================
  * Timer
  * ============================================ */
 
 int timer_init(uint32_t freq);
+void timer_handler(void);
 uint32_t timer_get_ticks(void);
+int timer_is_running(void);
 uint32_t timer_get_uptime(void);
 void timer_delay_ms(uint32_t ms);
+void timer_set_block_hook(void (*hook)(uint32_t ms));
 void delay(uint32_t count);
+void timer_calibrate_tsc(void);
+uint64_t ktime_ns(void);
+uint64_t tsc_to_ns(uint64_t cycles);
+
+/* Vsyscall timekeeping page (timer.c): tick count and TSC
+ * calibration readable without a kernel entry. Seqlock protocol:
+ * read seq, read fields, re-read seq; retry if odd or changed */
+typedef struct {
+  volatile uint32_t seq;
+  volatile uint32_t ticks;
+  uint32_t tsc_mult;
+  uint32_t tsc_shift;
+  uint64_t tsc_base;
+} vsyscall_time_t;
+const vsyscall_time_t *vsyscall_page_addr(void);
+uint64_t div_u64_u32(uint64_t n, uint32_t d);
+int ktimer_add(void (*fn)(void *arg), void *arg, uint32_t delay_ms,
+               uint32_t period_ms);
+void ktimer_cancel(int id);
+
+/* Sampling profiler (cpu/profile.c) */
+void profile_sample(uint32_t eip);
+void cmd_profile(const char *args);
+void cmd_bench(const char *args);
+
+/* Kernel tracepoints (ktrace.c): cycle-stamped flight recorder.
+ * KTRACE() compiles to a mask test; categories toggle at runtime */
+#define KTRACE_SCHED 0x01
+#define KTRACE_IRQ 0x02
+#define KTRACE_NET 0x04
+#define KTRACE_IDE 0x08
+#define KTRACE_SYSCALL 0x10
+
+#define KT_EV_SWITCH 1
+#define KT_EV_IRQ_IN 2
+#define KT_EV_IRQ_OUT 3
+#define KT_EV_NET_RX 4
+#define KT_EV_NET_TX 5
+#define KT_EV_IDE_RD 6
+#define KT_EV_IDE_RD_DONE 7
+#define KT_EV_IDE_WR 8
+#define KT_EV_IDE_WR_DONE 9
+#define KT_EV_SYSCALL 10
+
+/* Boot stage framework (bootstage.c): critical stages run serially,
+ * deferred stages run once the prompt is live; `bootchart` reports */
+void boot_stage_run(const char *name, void (*fn)(void));
+void boot_stage_defer(const char *name, void (*fn)(void));
+int boot_run_deferred(void);
+void cmd_bootchart(const char *args);
+
+/* Per-IRQ occupancy counters (cpu/idt.c) */
+void cmd_irqstat(const char *args);
+
+extern volatile uint32_t ktrace_mask;
+void ktrace_record(uint8_t cat, uint8_t event, uint32_t arg);
+void ktrace_dump(int count);
+void cmd_ktrace(const char *args);
+
+#define KTRACE(cat, event, arg)                                                \
+  do {                                                                         \
+    if (ktrace_mask & (cat))                                                   \
+      ktrace_record((cat), (event), (arg));                                    \
+  } while (0)
 
 /* ============================================
  * Memory Management
  * ============================================ */
 
 void mm_init(void);
+void mm_init_regions(uint32_t mb_magic, uint32_t *mb_info);
+int mm_get_region(int idx, uint32_t *start, uint32_t *end);
+uint32_t mm_total_ram(void);
+uint32_t mm_reserved_top(void);
+void frame_alloc_init(void);
+void mm_set_sse2(int enable);
 void *kmalloc(size_t size);
 void kfree(void *ptr);
 void mm_status(void);
 void mm_stats(size_t *allocated, size_t *free);
+void cmd_memtop(const char *args);
+
+/* Arena (region) allocator for transient memory */
+typedef struct {
+  uint8_t *base;
+  size_t size;
+  size_t used;
+} arena_t;
+
+int arena_create(arena_t *arena, size_t size);
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_reset(arena_t *arena);
+void arena_destroy(arena_t *arena);
 
 /* String functions */
 void *memset(void *ptr, int value, size_t num);
+void *memset32(void *dst, uint32_t value, size_t count);
 void *memcpy(void *dest, const void *src, size_t num);
 int memcmp(const void *p1, const void *p2, size_t num);
 size_t strlen(const char *str);
@@ -160,6 +276,7 @@ char *strcat(char *dest, const char *src);
 
 int firewall_init(void);
 int firewall_check_packet(void *packet, size_t len);
+int firewall_check_ip(uint32_t src_ip);
 void firewall_block_ip(uint32_t ip);
 void firewall_status(void);
 void firewall_enable(int enable);
@@ -168,7 +285,13 @@ void firewall_enable(int enable);
  * Security - Monitor
  * ============================================ */
 
+/* Binary event ids for secmon_event */
+#define SEC_EV_NONE 0
+#define SEC_EV_MSG 1     /* Payload a: const char * (kernel literal) */
+#define SEC_EV_FW_DROP 2 /* Payload a: source IP */
+
 int secmon_init(void);
+void secmon_event(uint8_t id, uint8_t severity, uint32_t a, uint32_t b);
 void secmon_log(const char *event, int severity);
 void secmon_alert(const char *message);
 void secmon_status(void);
@@ -201,21 +324,62 @@ void cmd_ndns(const char *args);
 
 void cmd_sysinfo(const char *args);
 void cmd_ps(const char *args);
+void cmd_top(const char *args);
 void cmd_uptime(const char *args);
 void cmd_date(const char *args);
 void cmd_whoami(const char *args);
 void cmd_hostname(const char *args);
 void cmd_uname(const char *args);
 void cpu_detect(void);
+int cpu_has_sep(void);
 
 /* ============================================
  * Filesystem
  * ============================================ */
 
+/* I/O scheduler (drivers/iosched.c) */
+typedef void (*io_done_fn)(int status, void *ctx);
+int io_submit(int drive, uint32_t lba, uint8_t count, void *buf, int write,
+              io_done_fn done, void *ctx);
+void io_flush(void);
+
+/* Block cache (fs/bcache.c) */
+int bcache_read(int drive, uint32_t lba, void *buffer);
+int bcache_write(int drive, uint32_t lba, const void *buffer);
+void bcache_sync(void);
+void cmd_bcache(const char *args);
+
 int fs_init(void);
 int fs_write(const char *name, const char *data, size_t len);
 int fs_read(const char *name, char *buf, size_t max);
 
+/* Streaming handles: open a file once, then read/write in chunks */
+#define FS_O_CREATE 1
+int fs_open(const char *name, int flags);
+void fs_close(int fd);
+int fs_fsize(int fd);
+int fs_seek(int fd, uint32_t off);
+int fs_pread(int fd, char *buf, size_t max);
+int fs_pwrite(int fd, const char *buf, size_t len);
+int fs_append(int fd, const char *buf, size_t len);
+
+/* Streaming line engine (textproc.c): feeds a file to fn one line
+ * at a time without materializing the whole file */
+typedef void (*line_fn_t)(const char *line, int len, void *ctx);
+int stream_lines(const char *filename, line_fn_t fn, void *ctx);
+
+/* Directory walk accessors for tab completion */
+int fs_resolve_dir(const char *path);
+int fs_first_child(int dir);
+int fs_next_sibling(int idx);
+const char *fs_node_name(int idx);
+int fs_node_isdir(int idx);
+
+/* Tab completion (complete.c) */
+int shell_complete(char *buf, int *pos, int list);
+int shell_cmd_count(void);
+const char *shell_cmd_name(int idx);
+
 void cmd_ls(const char *args);
 void cmd_cat(const char *args);
 void cmd_touch(const char *args);
@@ -258,12 +422,49 @@ const char *fhs_getcwd(void);
 int fhs_chdir(const char *path);
 void fhs_resolve_path(const char *path, char *resolved, size_t size);
 
+/* Shared variable table (env.c, nash) - open-addressing hash over
+ * caller-owned slots; cap must be a power of two */
+#define VARTAB_NAME 32
+#define VARTAB_VALUE 256
+
+#define VARTAB_EMPTY 0
+#define VARTAB_USED 1
+#define VARTAB_TOMB 2
+
+typedef struct {
+  char name[VARTAB_NAME];
+  char value[VARTAB_VALUE];
+  uint8_t state;
+} vartab_entry_t;
+
+typedef struct {
+  vartab_entry_t *slots;
+  int cap;
+  int count;
+  uint32_t gen; /* Bumped on every mutation */
+} vartab_t;
+
+void vartab_init(vartab_t *t, vartab_entry_t *slots, int cap);
+int vartab_set(vartab_t *t, const char *name, const char *value);
+const char *vartab_get(vartab_t *t, const char *name);
+int vartab_unset(vartab_t *t, const char *name);
+
 /* Extended filesystem functions */
 int fs_mkdir(const char *path);
 int fs_create(const char *path);
 int fs_delete(const char *path);
 int fs_exists(const char *path);
 int fs_isdir(const char *path);
+int fs_stamp(const char *name, uint32_t *modified);
+
+/* Node permission metadata (ramfs.c); decisions are cached, flushed
+ * by fs_perm_flush on chmod/chown and identity changes */
+int fs_access(const char *name, int access_type);
+int fs_get_meta(const char *name, uint16_t *uid, uint16_t *gid,
+                uint16_t *mode);
+int fs_set_mode(const char *name, uint16_t mode);
+int fs_set_owner(const char *name, uint16_t uid, uint16_t gid);
+void fs_perm_flush(void);
 int snprintf(char *str, size_t size, const char *fmt, ...);
 
 /* ============================================
@@ -277,6 +478,11 @@ int user_is_root(void);
 uint16_t user_get_uid(void);
 const char *user_get_username(void);
 int user_add(const char *username, const char *password, int is_admin);
+/* Access types for user_check_permission / fs_access */
+#define PERM_READ 0x04
+#define PERM_WRITE 0x02
+#define PERM_EXEC 0x01
+
 int user_check_permission(uint16_t file_uid, uint16_t file_gid,
                           uint16_t file_mode, int access_type);
 
@@ -306,6 +512,9 @@ void cmd_play(const char *args);
  * ============================================ */
 
 void cmd_date_rtc(const char *args);
+void rtc_init(void);
+void rtc_sync(void);
+uint32_t ktime_wall(void); /* seconds since 2000-01-01, no port I/O */
 void cmd_time(const char *args);
 void cmd_cal(const char *args);
 
@@ -344,6 +553,7 @@ void cmd_unset(const char *args);
 int serial_init(uint16_t base, int baud_divisor);
 void serial_putchar(char c);
 void serial_puts(const char *str);
+void serial_flush(void);
 void klog(const char *msg);
 void cmd_dmesg(const char *args);
 
@@ -354,6 +564,7 @@ void cmd_dmesg(const char *args);
 void history_add(const char *cmd);
 const char *history_prev(void);
 const char *history_next(void);
+const char *history_search(const char *prefix, int nth);
 void cmd_history(const char *args);
 void alias_init(void);
 int alias_set(const char *name, const char *command);
@@ -368,6 +579,7 @@ void cmd_unalias(const char *args);
 uint32_t password_hash(const char *password);
 void audit_init(void);
 void audit_log_cmd(const char *command);
+void audit_sync(void);
 void cmd_audit(const char *args);
 int sudo_check(void);
 void cmd_sudo(const char *args);
@@ -395,6 +607,8 @@ uint8_t gfx_get_pixel(int x, int y);
 void gfx_line(int x0, int y0, int x1, int y1, uint8_t color);
 void gfx_rect(int x, int y, int w, int h, uint8_t color);
 void gfx_fill_rect(int x, int y, int w, int h, uint8_t color);
+void gfx_glyph_row(int x, int y, uint8_t bits, uint8_t color);
+void gfx_wait_vsync(void);
 void gfx_circle(int cx, int cy, int r, uint8_t color);
 void gfx_set_palette(uint8_t index, uint8_t r, uint8_t g, uint8_t b);
 int gfx_is_active(void);
@@ -409,10 +623,12 @@ uint32_t vesa_get_pixel(int x, int y);
 void vesa_line(int x0, int y0, int x1, int y1, uint32_t color);
 void vesa_rect(int x, int y, int w, int h, uint32_t color);
 void vesa_fill_rect(int x, int y, int w, int h, uint32_t color);
+void vesa_blit(int sx, int sy, int dx, int dy, int w, int h);
 void vesa_hline(int x, int y, int len, uint32_t color);
 void vesa_vline(int x, int y, int len, uint32_t color);
 void vesa_draw_char(int x, int y, char c, uint32_t color);
 void vesa_draw_string(int x, int y, const char *str, uint32_t color);
+void vesa_flush(void);
 uint32_t vesa_rgb(uint8_t r, uint8_t g, uint8_t b);
 
 /* Graphics Abstraction Layer (graphics/gfx.c) */
@@ -422,12 +638,15 @@ int gfx_is_vesa(void);
 void gfx_get_screen_size(int *w, int *h);
 void gfx_clear_screen(uint32_t color);
 void gfx_pixel(int x, int y, uint32_t color);
+uint32_t gfx_read_pixel(int x, int y);
 void gfx_draw_line(int x0, int y0, int x1, int y1, uint32_t color);
 void gfx_draw_rect(int x, int y, int w, int h, uint32_t color);
 void gfx_draw_fill_rect(int x, int y, int w, int h, uint32_t color);
+void gfx_blit(int sx, int sy, int dx, int dy, int w, int h);
 void gfx_draw_hline(int x, int y, int len, uint32_t color);
 void gfx_draw_char(int x, int y, char c, uint32_t color);
 void gfx_draw_text(int x, int y, const char *str, uint32_t color);
+void gfx_flush(void);
 int gfx_strlen(const char *s);
 
 /* Login & Desktop (graphics/login.c, graphics/desktop.c) */
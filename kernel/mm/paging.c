@@ -4,7 +4,9 @@
  * Page directory, page tables, and memory protection
  */
 
+#include "../cpu/idt.h"
 #include "../kernel.h"
+#include "../proc/process.h"
 
 /* Page flags */
 #define PAGE_PRESENT 0x001
@@ -13,6 +15,7 @@
 #define PAGE_ACCESSED 0x020
 #define PAGE_DIRTY 0x040
 #define PAGE_SIZE_4MB 0x080
+#define PAGE_COW 0x200 /* available bit: write faults copy this page */
 
 /* Page size */
 #define PAGE_SIZE 4096
@@ -23,97 +26,180 @@
 static uint32_t page_directory[1024] __attribute__((aligned(4096)));
 static uint32_t first_page_table[1024] __attribute__((aligned(4096)));
 
-/* Physical memory bitmap */
-#define PHYS_MEMORY_SIZE (32 * 1024 * 1024) /* 32 MB */
-#define TOTAL_PAGES (PHYS_MEMORY_SIZE / PAGE_SIZE)
-#define BITMAP_SIZE (TOTAL_PAGES / 32)
-
-static uint32_t page_bitmap[BITMAP_SIZE];
+/* Physical memory: buddy allocator. The side arrays are sized for the
+ * most we can track with 16-bit buddy links (just under 256MB); the
+ * actual managed range is set at init from the Multiboot memory map,
+ * so a 512MB box uses everything up to that ceiling instead of the
+ * old fixed 32MB. */
+#define MAX_PAGES 65520 /* < PIDX_NONE so indices stay valid */
+#define TOTAL_PAGES MAX_PAGES
+
+static uint32_t managed_pages = 0;
+static int buddy_ready = 0;
+
+/* Free pages live on per-order free lists (order 0 = 1 page, up to
+ * order 10 = 4MB), so allocation is a pop plus at most MAX_ORDER
+ * splits instead of a scan over the whole bitmap. Metadata is kept
+ * in side arrays because high physical pages are not identity-mapped. */
+#define MAX_ORDER 10
+#define PIDX_NONE 0xFFFF
+
+/* Per-page state: block heads carry a flag plus their order; interior
+ * and reserved pages stay 0. */
+#define PG_FREE 0x80
+#define PG_USED 0x40
+#define PG_ORDER(x) ((x) & 0x0F)
+
+static uint8_t page_info[TOTAL_PAGES];
+static uint16_t buddy_next[TOTAL_PAGES];
+static uint16_t buddy_prev[TOTAL_PAGES];
+static uint16_t free_area[MAX_ORDER + 1];
 static uint32_t free_pages = 0;
 
-/*
- * Set a bit in the bitmap (mark page as used)
- */
-static void bitmap_set(uint32_t page) {
-  page_bitmap[page / 32] |= (1 << (page % 32));
-}
+/* Share counts for copy-on-write pages */
+static uint8_t page_refcount[TOTAL_PAGES];
 
-/*
- * Clear a bit in the bitmap (mark page as free)
- */
-static void bitmap_clear(uint32_t page) {
-  page_bitmap[page / 32] &= ~(1 << (page % 32));
+/* Page directory index covering the process stack region */
+#define VSTACK_PD_INDEX (PROC_VSTACK_BASE >> 22)
+
+static uint32_t *dir_table(uint32_t *dir, uint32_t virt, int create);
+static void page_fault_handler(interrupt_frame_t *frame);
+
+static void area_insert(uint32_t page, int order) {
+  buddy_prev[page] = PIDX_NONE;
+  buddy_next[page] = free_area[order];
+  if (free_area[order] != PIDX_NONE)
+    buddy_prev[free_area[order]] = (uint16_t)page;
+  free_area[order] = (uint16_t)page;
+  page_info[page] = PG_FREE | order;
 }
 
-/*
- * Test a bit in the bitmap
- */
-static int bitmap_test(uint32_t page) {
-  return page_bitmap[page / 32] & (1 << (page % 32));
+static void area_remove(uint32_t page, int order) {
+  if (buddy_prev[page] != PIDX_NONE)
+    buddy_next[buddy_prev[page]] = buddy_next[page];
+  else
+    free_area[order] = buddy_next[page];
+  if (buddy_next[page] != PIDX_NONE)
+    buddy_prev[buddy_next[page]] = buddy_prev[page];
+  page_info[page] = 0;
 }
 
 /*
- * Find first free page
+ * Return a block to the free lists, merging with its buddy at each
+ * order while the buddy is also a free block of the same size.
  */
-static uint32_t find_free_page(void) {
-  for (uint32_t i = 0; i < BITMAP_SIZE; i++) {
-    if (page_bitmap[i] != 0xFFFFFFFF) {
-      for (int j = 0; j < 32; j++) {
-        if (!(page_bitmap[i] & (1 << j))) {
-          return i * 32 + j;
-        }
-      }
-    }
+static void buddy_release(uint32_t page, int order) {
+  while (order < MAX_ORDER) {
+    uint32_t buddy = page ^ (1u << order);
+    if (buddy >= managed_pages ||
+        page_info[buddy] != (uint8_t)(PG_FREE | order))
+      break;
+    area_remove(buddy, order);
+    if (buddy < page)
+      page = buddy;
+    order++;
   }
-  return 0xFFFFFFFF; /* No free pages */
+  area_insert(page, order);
 }
 
 /*
- * Allocate a physical page
+ * Allocate a naturally-aligned block of 2^order pages
  */
-uint32_t page_alloc(void) {
-  uint32_t page = find_free_page();
-  if (page == 0xFFFFFFFF) {
+uint32_t page_alloc_order(int order) {
+  int o;
+  uint32_t page;
+  if (!buddy_ready || order < 0 || order > MAX_ORDER)
     return 0;
+  for (o = order; o <= MAX_ORDER; o++) {
+    if (free_area[o] != PIDX_NONE)
+      break;
   }
+  if (o > MAX_ORDER)
+    return 0;
 
-  bitmap_set(page);
-  free_pages--;
-
+  page = free_area[o];
+  area_remove(page, o);
+  /* Split down, putting the upper halves back on the lists */
+  while (o > order) {
+    o--;
+    area_insert(page + (1u << o), o);
+  }
+  page_info[page] = PG_USED | order;
+  free_pages -= (1u << order);
   return page * PAGE_SIZE;
 }
 
 /*
- * Free a physical page
+ * Allocate a physical page
+ */
+uint32_t page_alloc(void) { return page_alloc_order(0); }
+
+/*
+ * Free a physical page (or the block that was allocated at it)
  */
 void page_free(uint32_t phys_addr) {
   uint32_t page = phys_addr / PAGE_SIZE;
-  if (page < TOTAL_PAGES && bitmap_test(page)) {
-    bitmap_clear(page);
-    free_pages++;
-  }
+  int order;
+  if (page >= managed_pages || !(page_info[page] & PG_USED))
+    return;
+  order = PG_ORDER(page_info[page]);
+  free_pages += (1u << order);
+  buddy_release(page, order);
 }
 
 /*
  * Initialize paging
  */
-void paging_init(void) {
-  /* Initialize bitmap - mark all as free first */
-  memset(page_bitmap, 0, sizeof(page_bitmap));
-  free_pages = TOTAL_PAGES;
-
-  /* Reserve first 1MB (low memory, BIOS, etc.) */
-  for (uint32_t i = 0; i < (1024 * 1024) / PAGE_SIZE; i++) {
-    bitmap_set(i);
-    free_pages--;
-  }
+/*
+ * Build the buddy free lists from the Multiboot memory map (recorded
+ * by mm_init_regions). Everything below the kernel image plus the
+ * initial heap is simply never released. Called from mm_init so the
+ * heap can grow even when paging itself stays off; paging_init calls
+ * it again harmlessly.
+ */
+void frame_alloc_init(void) {
+  if (buddy_ready)
+    return;
 
-  /* Reserve kernel memory (1MB - 4MB) */
-  for (uint32_t i = 256; i < 1024; i++) {
-    bitmap_set(i);
-    free_pages--;
+  memset(page_info, 0, sizeof(page_info));
+  for (int i = 0; i <= MAX_ORDER; i++)
+    free_area[i] = PIDX_NONE;
+  free_pages = 0;
+
+  uint32_t floor_page = mm_reserved_top() / PAGE_SIZE;
+  uint32_t start, end;
+  managed_pages = 0;
+  for (int r = 0; mm_get_region(r, &start, &end) == 0; r++) {
+    uint32_t last = end / PAGE_SIZE;
+    if (last > MAX_PAGES)
+      last = MAX_PAGES;
+    if (last > managed_pages)
+      managed_pages = last;
+  }
+  if (managed_pages <= floor_page)
+    managed_pages = floor_page; /* Nothing above the kernel: no pages */
+  buddy_ready = 1;
+
+  for (int r = 0; mm_get_region(r, &start, &end) == 0; r++) {
+    uint32_t first = (start + PAGE_SIZE - 1) / PAGE_SIZE;
+    uint32_t last = end / PAGE_SIZE;
+    if (first < floor_page)
+      first = floor_page;
+    if (last > managed_pages)
+      last = managed_pages;
+    for (uint32_t i = first; i < last; i++) {
+      free_pages++;
+      buddy_release(i, 0);
+    }
   }
 
+  kprintf("  [OK] Page allocator (%d MB managed)\n",
+          (int)(free_pages >> 8));
+}
+
+void paging_init(void) {
+  frame_alloc_init();
+
   /* Clear page directory */
   memset(page_directory, 0, sizeof(page_directory));
 
@@ -125,6 +211,19 @@ void paging_init(void) {
   /* Set first entry in page directory */
   page_directory[0] = ((uint32_t)first_page_table) | PAGE_PRESENT | PAGE_WRITE;
 
+  /* Identity map the rest of managed RAM with 4MB pages so memory the
+   * buddy allocator hands out (heap growth, page tables) is reachable
+   * without demand faults. Needs CR4.PSE. */
+  uint32_t top_dir = (managed_pages + 1023) >> 10;
+  for (uint32_t i = 1; i < top_dir && i < 1024; i++) {
+    page_directory[i] =
+        (i << 22) | PAGE_PRESENT | PAGE_WRITE | PAGE_SIZE_4MB;
+  }
+  uint32_t cr4;
+  asm volatile("mov %%cr4, %0" : "=r"(cr4));
+  cr4 |= 0x10; /* PSE */
+  asm volatile("mov %0, %%cr4" : : "r"(cr4));
+
   /* Load page directory into CR3 */
   asm volatile("mov %0, %%cr3" : : "r"(page_directory));
 
@@ -134,35 +233,160 @@ void paging_init(void) {
   cr0 |= 0x80000000; /* Set PG bit */
   asm volatile("mov %0, %%cr0" : : "r"(cr0));
 
+  /* Preallocate the page table for the shared process-stack region so
+   * every directory can alias it, and take over page faults for
+   * demand paging and copy-on-write */
+  dir_table(page_directory, PROC_VSTACK_BASE, 1);
+  isr_register_handler(ISR_PAGE_FAULT, page_fault_handler);
+
   kprintf("  [OK] Paging (%d KB free)\n", (free_pages * 4));
 }
 
 /*
- * Map a virtual address to physical address
+ * Look up (optionally creating) the page table covering virt in an
+ * arbitrary directory
  */
-void page_map(uint32_t virt, uint32_t phys, uint32_t flags) {
+static uint32_t *dir_table(uint32_t *dir, uint32_t virt, int create) {
   uint32_t pd_index = virt >> 22;
-  uint32_t pt_index = (virt >> 12) & 0x3FF;
 
-  /* Check if page table exists */
-  if (!(page_directory[pd_index] & PAGE_PRESENT)) {
-    /* Allocate new page table */
+  if (!(dir[pd_index] & PAGE_PRESENT)) {
+    if (!create)
+      return NULL;
     uint32_t pt_phys = page_alloc();
     if (!pt_phys)
-      return;
-
+      return NULL;
     memset((void *)pt_phys, 0, PAGE_SIZE);
-    page_directory[pd_index] = pt_phys | PAGE_PRESENT | PAGE_WRITE | PAGE_USER;
+    dir[pd_index] = pt_phys | PAGE_PRESENT | PAGE_WRITE | PAGE_USER;
   }
+  return (uint32_t *)(dir[pd_index] & 0xFFFFF000);
+}
 
-  /* Get page table */
-  uint32_t *pt = (uint32_t *)(page_directory[pd_index] & 0xFFFFF000);
+/*
+ * Set a page table entry in an arbitrary directory
+ */
+static void dir_map(uint32_t *dir, uint32_t virt, uint32_t phys,
+                    uint32_t flags) {
+  uint32_t *pt = dir_table(dir, virt, 1);
+  if (!pt)
+    return;
+  pt[(virt >> 12) & 0x3FF] =
+      (phys & 0xFFFFF000) | (flags & 0xFFF) | PAGE_PRESENT;
+  asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+}
 
-  /* Set page table entry */
-  pt[pt_index] = (phys & 0xFFFFF000) | (flags & 0xFFF) | PAGE_PRESENT;
+/*
+ * Create a fresh process page directory. The kernel identity map and
+ * the shared process-stack region are aliased, everything else starts
+ * empty and faults in on demand.
+ */
+uint32_t paging_new_directory(void) {
+  uint32_t dir_phys = page_alloc();
+  if (!dir_phys)
+    return 0;
+  uint32_t *dir = (uint32_t *)dir_phys;
+  memset(dir, 0, PAGE_SIZE);
+  dir[0] = page_directory[0];
+  dir[VSTACK_PD_INDEX] = page_directory[VSTACK_PD_INDEX];
+  return dir_phys;
+}
 
-  /* Invalidate TLB entry */
-  asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+/*
+ * Clone a directory for fork: private mappings are shared physically
+ * and marked copy-on-write in both directories, so nothing is copied
+ * until one side writes.
+ */
+uint32_t paging_clone_directory(uint32_t src_phys) {
+  uint32_t *src = src_phys ? (uint32_t *)src_phys : page_directory;
+  uint32_t dst_phys = paging_new_directory();
+  if (!dst_phys)
+    return 0;
+  uint32_t *dst = (uint32_t *)dst_phys;
+
+  for (uint32_t pd = 1; pd < TABLES_PER_DIR; pd++) {
+    if (pd == VSTACK_PD_INDEX || !(src[pd] & PAGE_PRESENT))
+      continue;
+    uint32_t *spt = (uint32_t *)(src[pd] & 0xFFFFF000);
+    for (uint32_t pt = 0; pt < PAGES_PER_TABLE; pt++) {
+      if (!(spt[pt] & PAGE_PRESENT))
+        continue;
+      uint32_t virt = (pd << 22) | (pt << 12);
+      uint32_t page = (spt[pt] & 0xFFFFF000) / PAGE_SIZE;
+      /* Downgrade the source to read-only + COW and share the frame */
+      spt[pt] = (spt[pt] & ~(uint32_t)PAGE_WRITE) | PAGE_COW;
+      if (page_refcount[page] == 0)
+        page_refcount[page] = 1;
+      page_refcount[page]++;
+      dir_map(dst, virt, page * PAGE_SIZE, spt[pt] & 0xFFF);
+    }
+  }
+  /* Source entries changed; flush its TLB mappings */
+  uint32_t cr3;
+  asm volatile("mov %%cr3, %0" : "=r"(cr3));
+  asm volatile("mov %0, %%cr3" : : "r"(cr3));
+  return dst_phys;
+}
+
+/*
+ * Page fault handler: services demand-paged process stacks and
+ * copy-on-write breaks; anything else is fatal.
+ */
+static void page_fault_handler(interrupt_frame_t *frame) {
+  uint32_t addr, cr3;
+  asm volatile("mov %%cr2, %0" : "=r"(addr));
+  asm volatile("mov %%cr3, %0" : "=r"(cr3));
+  uint32_t *dir =
+      (cr3 && cr3 != (uint32_t)page_directory) ? (uint32_t *)cr3
+                                               : page_directory;
+
+  /* Copy-on-write: write to a present page marked PAGE_COW */
+  if (frame->err_code & 0x2) {
+    uint32_t *pt = dir_table(dir, addr, 0);
+    if (pt) {
+      uint32_t idx = (addr >> 12) & 0x3FF;
+      uint32_t pte = pt[idx];
+      if ((pte & PAGE_PRESENT) && (pte & PAGE_COW)) {
+        uint32_t page = (pte & 0xFFFFF000) / PAGE_SIZE;
+        if (page_refcount[page] > 1) {
+          uint32_t copy = page_alloc();
+          if (!copy)
+            kernel_panic("Copy-on-write: out of memory");
+          memcpy((void *)copy, (void *)(pte & 0xFFFFF000), PAGE_SIZE);
+          page_refcount[page]--;
+          pt[idx] = copy | ((pte & 0xFFF) & ~(uint32_t)PAGE_COW) | PAGE_WRITE;
+        } else {
+          pt[idx] = (pte & ~(uint32_t)PAGE_COW) | PAGE_WRITE;
+        }
+        asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
+        return;
+      }
+    }
+  }
+
+  /* Demand-paged process stacks: fault in a zeroed page, but leave the
+   * lowest page of each slot unmapped as an overflow guard */
+  if (addr >= PROC_VSTACK_BASE &&
+      addr < PROC_VSTACK_BASE + MAX_PROCESSES * PROC_VSTACK_SLOT) {
+    if ((addr & (PROC_VSTACK_SLOT - 1)) >= PAGE_SIZE) {
+      uint32_t phys = page_alloc();
+      if (phys) {
+        memset((void *)phys, 0, PAGE_SIZE);
+        dir_map(dir, addr & 0xFFFFF000, phys, PAGE_WRITE);
+        return;
+      }
+    }
+    kernel_panic("Process stack overflow");
+  }
+
+  kprintf("Page fault at 0x%x (err 0x%x, eip 0x%x)\n", addr, frame->err_code,
+          frame->eip);
+  kernel_panic("Unhandled page fault");
+}
+
+/*
+ * Map a virtual address to physical address
+ */
+void page_map(uint32_t virt, uint32_t phys, uint32_t flags) {
+  dir_map(page_directory, virt, phys, flags);
 }
 
 /*
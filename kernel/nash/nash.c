@@ -54,46 +54,24 @@
 extern void shell_execute_simple(const char *cmd);
 extern int fs_read(const char *name, char *buf, size_t max);
 
-/* Nash state */
-#define MAX_VARS 32
-#define MAX_VAR_NAME 32
-#define MAX_VAR_VALUE 256
+/* Nash state: variables live in the shared hashed table (vartab.c),
+ * so lookups during expansion are O(1) instead of a table scan */
+#define MAX_VAR_NAME VARTAB_NAME
+#define MAX_VAR_VALUE VARTAB_VALUE
 #define MAX_SCRIPT_SIZE 8192
+#define NASH_VAR_SLOTS 64 /* Power of two; holds up to 32 variables */
 
-typedef struct {
-  char name[MAX_VAR_NAME];
-  char value[MAX_VAR_VALUE];
-} nash_var_t;
-
-static nash_var_t nash_vars[MAX_VARS];
+static vartab_entry_t nash_var_slots[NASH_VAR_SLOTS];
+static vartab_t nash_var_tab;
 static int nash_last_result = 0;
 
-/*
- * Set a Nash variable
- */
 static void nash_set_var(const char *name, const char *value) {
-  for (int i = 0; i < MAX_VARS; i++) {
-    if (nash_vars[i].name[0] && strcmp(nash_vars[i].name, name) == 0) {
-      strncpy(nash_vars[i].value, value, MAX_VAR_VALUE - 1);
-      return;
-    }
-  }
-  for (int i = 0; i < MAX_VARS; i++) {
-    if (nash_vars[i].name[0] == '\0') {
-      strncpy(nash_vars[i].name, name, MAX_VAR_NAME - 1);
-      strncpy(nash_vars[i].value, value, MAX_VAR_VALUE - 1);
-      return;
-    }
-  }
+  vartab_set(&nash_var_tab, name, value);
 }
 
 static const char *nash_get_var(const char *name) {
-  for (int i = 0; i < MAX_VARS; i++) {
-    if (nash_vars[i].name[0] && strcmp(nash_vars[i].name, name) == 0) {
-      return nash_vars[i].value;
-    }
-  }
-  return "";
+  const char *val = vartab_get(&nash_var_tab, name);
+  return val ? val : "";
 }
 
 /*
@@ -147,21 +125,108 @@ static int starts_with(const char *line, const char *keyword) {
 }
 
 /*
- * Parse and execute Nash script
+ * Compiled form: a script is parsed once into a flat instruction
+ * array with jump targets resolved, then executed from that. Loop
+ * bodies run without touching the parser again, and compiled
+ * programs are cached per ramfs node so a repeat run of an unchanged
+ * script skips parsing entirely.
+ */
+#define NASH_MAX_INSTR 256
+#define NASH_MAX_DEPTH 16
+
+enum { N_RUN, N_SET, N_PRINT, N_SHOW, N_WHEN, N_JMP, N_REPEAT, N_LOOPEND };
+enum { CMP_NONE, CMP_EQ, CMP_NE, CMP_GT, CMP_LT };
+
+typedef struct {
+  uint8_t op;
+  uint8_t cmp;    /* Comparison for N_WHEN */
+  uint8_t lit;    /* Bit 0/1: operand a/b contains no @vars */
+  int16_t target; /* Jump target (meaning depends on op) */
+  int count;      /* Iterations for N_REPEAT */
+  const char *a;  /* First operand (template, expanded at runtime) */
+  const char *b;  /* Second operand */
+} nash_instr_t;
+
+typedef struct {
+  nash_instr_t *code;
+  int count;
+} nash_prog_t;
+
+/* Copy a string fragment into the program's arena */
+static const char *nash_pool(arena_t *arena, const char *s, int len) {
+  char *p = (char *)arena_alloc(arena, (size_t)len + 1);
+  if (!p)
+    return NULL;
+  memcpy(p, s, len);
+  p[len] = '\0';
+  return p;
+}
+
+static nash_instr_t *nash_emit(nash_prog_t *prog, int op) {
+  if (prog->count >= NASH_MAX_INSTR)
+    return NULL;
+  nash_instr_t *in = &prog->code[prog->count++];
+  memset(in, 0, sizeof(*in));
+  in->op = (uint8_t)op;
+  return in;
+}
+
+/* Mark operands containing no @vars, so execution can use the
+ * template directly instead of expanding it every pass */
+static void nash_mark_literals(nash_instr_t *in) {
+  in->lit = 0;
+  if (in->a) {
+    const char *p = in->a;
+    while (*p && *p != '@')
+      p++;
+    if (*p == '\0')
+      in->lit |= 1;
+  }
+  if (in->b) {
+    const char *p = in->b;
+    while (*p && *p != '@')
+      p++;
+    if (*p == '\0')
+      in->lit |= 2;
+  }
+}
+
+/* Simple decimal parse (mirrors the old inline comparisons) */
+static int nash_num(const char *s) {
+  int n = 0;
+  while (*s >= '0' && *s <= '9')
+    n = n * 10 + (*s++ - '0');
+  return n;
+}
+
+/*
+ * Compile a script into prog, pooling operand strings in arena.
+ * Returns 0 on success, -1 when the script exceeds the instruction
+ * or nesting limits (or the arena runs dry).
  */
-static void nash_execute_script(const char *script) {
+static int nash_compile(const char *script, nash_prog_t *prog,
+                        arena_t *arena) {
+  /* Open-block stack for jump patching */
+  enum { BLK_WHEN, BLK_ELSE, BLK_REPEAT };
+  struct {
+    int type;
+    int idx;
+  } blocks[NASH_MAX_DEPTH];
+  int depth = 0;
+
   char line[512];
   const char *p = script;
-  int in_when = 0, skip_block = 0;
-  int repeat_count = 0;
-  const char *repeat_start = NULL;
+
+  prog->code =
+      (nash_instr_t *)arena_alloc(arena, NASH_MAX_INSTR * sizeof(nash_instr_t));
+  prog->count = 0;
+  if (!prog->code)
+    return -1;
 
   while (*p) {
-    /* Skip leading whitespace */
     while (*p == ' ' || *p == '\t')
       p++;
 
-    /* Get a line */
     int i = 0;
     while (*p && *p != '\n' && i < 511) {
       line[i++] = *p++;
@@ -179,202 +244,326 @@ static void nash_execute_script(const char *script) {
     if (l[0] == ':' && l[1] == ':')
       continue;
 
-    /* Handle: end */
+    /* end - close the innermost block */
     if (starts_with(l, "end")) {
-      if (repeat_count > 0 && repeat_start) {
-        repeat_count--;
-        if (repeat_count > 0) {
-          p = repeat_start;
-        } else {
-          repeat_start = NULL;
-        }
+      if (depth == 0)
+        continue; /* Stray end, ignore like the old parser */
+      depth--;
+      int idx = blocks[depth].idx;
+      if (blocks[depth].type == BLK_REPEAT) {
+        nash_instr_t *le = nash_emit(prog, N_LOOPEND);
+        if (!le)
+          return -1;
+        le->target = (int16_t)idx;
+        prog->code[idx].target = (int16_t)prog->count; /* Skip when n==0 */
+      } else {
+        /* BLK_WHEN: false branch lands here; BLK_ELSE: the jump over
+         * the otherwise-block lands here */
+        prog->code[idx].target = (int16_t)prog->count;
       }
-      in_when = 0;
-      skip_block = 0;
       continue;
     }
 
-    /* Handle: otherwise */
+    /* otherwise - flip to the else branch */
     if (starts_with(l, "otherwise")) {
-      if (in_when)
-        skip_block = !skip_block;
+      if (depth == 0 || blocks[depth - 1].type != BLK_WHEN)
+        continue;
+      nash_instr_t *jmp = nash_emit(prog, N_JMP);
+      if (!jmp)
+        return -1;
+      int when_idx = blocks[depth - 1].idx;
+      prog->code[when_idx].target = (int16_t)prog->count;
+      blocks[depth - 1].type = BLK_ELSE;
+      blocks[depth - 1].idx = prog->count - 1;
       continue;
     }
 
-    if (skip_block)
-      continue;
-
-    /* Handle: @var = "value" or @var = value */
+    /* @var = "value" or @var = value */
     if (*l == '@') {
       const char *v = l + 1;
-      char varname[MAX_VAR_NAME];
-      int j = 0;
-      while (*v && *v != ' ' && *v != '=' && j < MAX_VAR_NAME - 1) {
-        varname[j++] = *v++;
-      }
-      varname[j] = '\0';
-
-      v = skip_ws(v);
-      if (*v == '=') {
+      const char *name = v;
+      while (*v && *v != ' ' && *v != '=')
         v++;
-        v = skip_ws(v);
+      int name_len = v - name;
 
-        char value[MAX_VAR_VALUE];
-        j = 0;
-        if (*v == '"') {
+      v = skip_ws(v);
+      if (*v != '=')
+        continue;
+      v = skip_ws(v + 1);
+
+      const char *val = v;
+      int val_len;
+      if (*v == '"') {
+        val = ++v;
+        while (*v && *v != '"')
+          v++;
+        val_len = v - val;
+      } else {
+        while (*v && *v != ' ')
           v++;
-          while (*v && *v != '"' && j < MAX_VAR_VALUE - 1) {
-            value[j++] = *v++;
-          }
-        } else {
-          while (*v && *v != ' ' && *v != '\n' && j < MAX_VAR_VALUE - 1) {
-            value[j++] = *v++;
-          }
-        }
-        value[j] = '\0';
-
-        char expanded[MAX_VAR_VALUE];
-        nash_expand(value, expanded, MAX_VAR_VALUE);
-        nash_set_var(varname, expanded);
+        val_len = v - val;
       }
+
+      nash_instr_t *in = nash_emit(prog, N_SET);
+      if (!in)
+        return -1;
+      in->a = nash_pool(arena, name, name_len);
+      in->b = nash_pool(arena, val, val_len);
+      if (!in->a || !in->b)
+        return -1;
+      nash_mark_literals(in);
       continue;
     }
 
-    /* Handle: print "text" or print @var */
+    /* print "text" or print @var */
     if (starts_with(l, "print")) {
       const char *msg = skip_ws(l + 5);
-      char expanded[512];
-
+      const char *text = msg;
+      int len;
       if (*msg == '"') {
-        msg++;
-        char text[256];
-        int j = 0;
-        while (*msg && *msg != '"' && j < 255) {
-          text[j++] = *msg++;
-        }
-        text[j] = '\0';
-        nash_expand(text, expanded, 512);
+        text = ++msg;
+        while (*msg && *msg != '"')
+          msg++;
+        len = msg - text;
       } else {
-        nash_expand(msg, expanded, 512);
+        len = strlen(text);
       }
-
-      kprintf("%s\n", expanded);
+      nash_instr_t *in = nash_emit(prog, N_PRINT);
+      if (!in || !(in->a = nash_pool(arena, text, len)))
+        return -1;
+      nash_mark_literals(in);
       continue;
     }
 
-    /* Handle: show @var */
+    /* show @var */
     if (starts_with(l, "show")) {
       const char *var = skip_ws(l + 4);
-      if (*var == '@') {
+      if (*var != '@')
+        continue;
+      var++;
+      const char *name = var;
+      while (*var && *var != ' ')
         var++;
-        char varname[MAX_VAR_NAME];
-        int j = 0;
-        while (*var && *var != ' ' && j < MAX_VAR_NAME - 1) {
-          varname[j++] = *var++;
-        }
-        varname[j] = '\0';
-        kprintf("%s = %s\n", varname, nash_get_var(varname));
-      }
+      nash_instr_t *in = nash_emit(prog, N_SHOW);
+      if (!in || !(in->a = nash_pool(arena, name, var - name)))
+        return -1;
       continue;
     }
 
-    /* Handle: when <cond> do */
+    /* when <left> <op> <right> do */
     if (starts_with(l, "when")) {
-      in_when = 1;
       const char *cond = skip_ws(l + 4);
 
-      /* Parse condition: @a eq @b, @a ne @b, etc */
-      char left[256], right[256], op[8];
-      int j = 0;
-
-      /* Get left operand */
-      while (*cond && *cond != ' ' && j < 255)
-        left[j++] = *cond++;
-      left[j] = '\0';
-
+      const char *left = cond;
+      while (*cond && *cond != ' ')
+        cond++;
+      int left_len = cond - left;
       cond = skip_ws(cond);
 
-      /* Get operator */
-      j = 0;
-      while (*cond && *cond != ' ' && j < 7)
-        op[j++] = *cond++;
-      op[j] = '\0';
-
+      const char *op = cond;
+      while (*cond && *cond != ' ')
+        cond++;
+      int op_len = cond - op;
       cond = skip_ws(cond);
 
-      /* Get right operand */
-      j = 0;
-      while (*cond && *cond != ' ' && strcmp(cond, "do") != 0 && j < 255) {
-        right[j++] = *cond++;
-      }
-      right[j] = '\0';
+      const char *right = cond;
+      while (*cond && *cond != ' ')
+        cond++;
+      int right_len = cond - right;
+
+      int cmp = CMP_NONE;
+      if (op_len == 2 && op[0] == 'e' && op[1] == 'q')
+        cmp = CMP_EQ;
+      else if (op_len == 2 && op[0] == 'n' && op[1] == 'e')
+        cmp = CMP_NE;
+      else if (op_len == 2 && op[0] == 'g' && op[1] == 't')
+        cmp = CMP_GT;
+      else if (op_len == 2 && op[0] == 'l' && op[1] == 't')
+        cmp = CMP_LT;
+
+      if (depth >= NASH_MAX_DEPTH)
+        return -1;
+      nash_instr_t *in = nash_emit(prog, N_WHEN);
+      if (!in)
+        return -1;
+      in->cmp = (uint8_t)cmp;
+      in->a = nash_pool(arena, left, left_len);
+      in->b = nash_pool(arena, right, right_len);
+      if (!in->a || !in->b)
+        return -1;
+      nash_mark_literals(in);
+      blocks[depth].type = BLK_WHEN;
+      blocks[depth].idx = prog->count - 1;
+      depth++;
+      continue;
+    }
 
-      /* Expand variables */
-      char el[256], er[256];
-      nash_expand(left, el, 256);
-      nash_expand(right, er, 256);
+    /* repeat <n> times */
+    if (starts_with(l, "repeat")) {
+      if (depth >= NASH_MAX_DEPTH)
+        return -1;
+      nash_instr_t *in = nash_emit(prog, N_REPEAT);
+      if (!in)
+        return -1;
+      in->count = nash_num(skip_ws(l + 6));
+      blocks[depth].type = BLK_REPEAT;
+      blocks[depth].idx = prog->count - 1;
+      depth++;
+      continue;
+    }
 
-      /* Evaluate */
-      int result = 0;
-      if (strcmp(op, "eq") == 0) {
-        result = (strcmp(el, er) == 0);
-      } else if (strcmp(op, "ne") == 0) {
-        result = (strcmp(el, er) != 0);
-      } else if (strcmp(op, "gt") == 0) {
-        /* Simple numeric comparison */
-        int a = 0, b = 0;
-        for (const char *x = el; *x >= '0' && *x <= '9'; x++)
-          a = a * 10 + (*x - '0');
-        for (const char *x = er; *x >= '0' && *x <= '9'; x++)
-          b = b * 10 + (*x - '0');
-        result = (a > b);
-      } else if (strcmp(op, "lt") == 0) {
-        int a = 0, b = 0;
-        for (const char *x = el; *x >= '0' && *x <= '9'; x++)
-          a = a * 10 + (*x - '0');
-        for (const char *x = er; *x >= '0' && *x <= '9'; x++)
-          b = b * 10 + (*x - '0');
-        result = (a < b);
-      }
+    /* run <command>, or a bare shell command */
+    {
+      const char *cmd = starts_with(l, "run") ? skip_ws(l + 3) : l;
+      nash_instr_t *in = nash_emit(prog, N_RUN);
+      if (!in || !(in->a = nash_pool(arena, cmd, strlen(cmd))))
+        return -1;
+      nash_mark_literals(in);
+    }
+  }
 
-      skip_block = !result;
-      continue;
+  /* Unterminated blocks fall off the end of the program */
+  while (depth > 0) {
+    depth--;
+    int idx = blocks[depth].idx;
+    if (blocks[depth].type == BLK_REPEAT) {
+      nash_instr_t *le = nash_emit(prog, N_LOOPEND);
+      if (!le)
+        return -1;
+      le->target = (int16_t)idx;
     }
+    prog->code[idx].target = (int16_t)prog->count;
+  }
 
-    /* Handle: repeat <n> times */
-    if (starts_with(l, "repeat")) {
-      const char *n = skip_ws(l + 6);
-      char num[16];
-      int j = 0;
-      while (*n >= '0' && *n <= '9' && j < 15) {
-        num[j++] = *n++;
-      }
-      num[j] = '\0';
+  return 0;
+}
 
-      repeat_count = 0;
-      for (j = 0; num[j]; j++) {
-        repeat_count = repeat_count * 10 + (num[j] - '0');
+/*
+ * Execute a compiled program
+ */
+static void nash_run_prog(const nash_prog_t *prog) {
+  int loop_stack[NASH_MAX_DEPTH];
+  int lsp = 0;
+  int pc = 0;
+
+  while (pc < prog->count) {
+    const nash_instr_t *in = &prog->code[pc];
+
+    switch (in->op) {
+    case N_SET: {
+      char expanded[MAX_VAR_VALUE];
+      const char *val = in->b;
+      if (!(in->lit & 2)) {
+        nash_expand(in->b, expanded, MAX_VAR_VALUE);
+        val = expanded;
       }
-      repeat_start = p;
-      continue;
+      nash_set_var(in->a, val);
+      pc++;
+      break;
     }
-
-    /* Handle: run <command> (execute shell command) */
-    if (starts_with(l, "run")) {
-      const char *cmd = skip_ws(l + 3);
+    case N_PRINT: {
       char expanded[512];
-      nash_expand(cmd, expanded, 512);
-      shell_execute_simple(expanded);
-      continue;
+      const char *text = in->a;
+      if (!(in->lit & 1)) {
+        nash_expand(in->a, expanded, 512);
+        text = expanded;
+      }
+      kprintf("%s\n", text);
+      pc++;
+      break;
+    }
+    case N_SHOW:
+      kprintf("%s = %s\n", in->a, nash_get_var(in->a));
+      pc++;
+      break;
+    case N_RUN: {
+      char expanded[512];
+      const char *cmd = in->a;
+      if (!(in->lit & 1)) {
+        nash_expand(in->a, expanded, 512);
+        cmd = expanded;
+      }
+      shell_execute_simple(cmd);
+      pc++;
+      break;
     }
+    case N_WHEN: {
+      char el[256], er[256];
+      const char *left = in->a;
+      const char *right = in->b;
+      if (!(in->lit & 1)) {
+        nash_expand(in->a, el, 256);
+        left = el;
+      }
+      if (!(in->lit & 2)) {
+        nash_expand(in->b, er, 256);
+        right = er;
+      }
 
-    /* Default: treat as shell command */
-    char expanded[512];
-    nash_expand(l, expanded, 512);
-    shell_execute_simple(expanded);
+      int result = 0;
+      switch (in->cmp) {
+      case CMP_EQ:
+        result = (strcmp(left, right) == 0);
+        break;
+      case CMP_NE:
+        result = (strcmp(left, right) != 0);
+        break;
+      case CMP_GT:
+        result = (nash_num(left) > nash_num(right));
+        break;
+      case CMP_LT:
+        result = (nash_num(left) < nash_num(right));
+        break;
+      }
+      pc = result ? pc + 1 : in->target;
+      break;
+    }
+    case N_JMP:
+      pc = in->target;
+      break;
+    case N_REPEAT:
+      if (in->count <= 0 || lsp >= NASH_MAX_DEPTH) {
+        pc = in->target;
+      } else {
+        loop_stack[lsp++] = in->count;
+        pc++;
+      }
+      break;
+    case N_LOOPEND:
+      if (lsp > 0 && --loop_stack[lsp - 1] > 0) {
+        pc = in->target + 1;
+      } else {
+        if (lsp > 0)
+          lsp--;
+        pc++;
+      }
+      break;
+    default:
+      pc++;
+      break;
+    }
   }
 }
 
+/*
+ * Compile cache: one slot per recently run script, keyed by ramfs
+ * node and modified stamp. Each slot owns the arena its instructions
+ * and strings live in, reused (reset) when the script changes.
+ */
+#define NASH_CACHE_SLOTS 4
+#define NASH_SLOT_ARENA (NASH_MAX_INSTR * sizeof(nash_instr_t) + MAX_SCRIPT_SIZE)
+
+typedef struct {
+  int node; /* -1 = free */
+  uint32_t stamp;
+  arena_t arena;
+  nash_prog_t prog;
+} nash_cache_t;
+
+static nash_cache_t nash_cache[NASH_CACHE_SLOTS];
+static int nash_cache_next = 0;
+static int nash_cache_init_done = 0;
+
 /*
  * cmd_nash - Execute a .nsh script
  */
@@ -410,34 +599,77 @@ void cmd_nash(const char *args) {
     return;
   }
 
-  /* Read script */
-  char script[MAX_SCRIPT_SIZE];
-  int len = fs_read(args, script, MAX_SCRIPT_SIZE - 1);
+  if (!nash_cache_init_done) {
+    for (int i = 0; i < NASH_CACHE_SLOTS; i++)
+      nash_cache[i].node = -1;
+    nash_cache_init_done = 1;
+  }
 
-  if (len < 0) {
+  uint32_t stamp = 0;
+  int node = fs_stamp(args, &stamp);
+  if (node < 0) {
     kprintf("nash: cannot read '%s'\n", args);
     return;
   }
 
-  script[len] = '\0';
+  /* Cached and unchanged? Run the compiled program straight away */
+  nash_cache_t *slot = NULL;
+  for (int i = 0; i < NASH_CACHE_SLOTS; i++) {
+    if (nash_cache[i].node == node) {
+      slot = &nash_cache[i];
+      break;
+    }
+  }
+
+  if (!slot || slot->stamp != stamp) {
+    /* (Re)compile into a slot arena; script source only needs to
+     * live for the duration of the compile */
+    static char source[MAX_SCRIPT_SIZE];
+    int len = fs_read(args, source, MAX_SCRIPT_SIZE - 1);
+    if (len < 0) {
+      kprintf("nash: cannot read '%s'\n", args);
+      return;
+    }
+    source[len] = '\0';
+
+    if (!slot) {
+      slot = &nash_cache[nash_cache_next];
+      nash_cache_next = (nash_cache_next + 1) % NASH_CACHE_SLOTS;
+    }
+    if (!slot->arena.base &&
+        arena_create(&slot->arena, NASH_SLOT_ARENA) < 0) {
+      kprintf("nash: out of memory\n");
+      return;
+    }
+    arena_reset(&slot->arena);
+    slot->node = -1;
+
+    if (nash_compile(source, &slot->prog, &slot->arena) < 0) {
+      kprintf("nash: script too large or deeply nested\n");
+      return;
+    }
+    slot->node = node;
+    slot->stamp = stamp;
+  }
 
   /* Clear state */
-  memset(nash_vars, 0, sizeof(nash_vars));
+  vartab_init(&nash_var_tab, nash_var_slots, NASH_VAR_SLOTS);
   nash_last_result = 0;
 
   /* Set defaults */
   nash_set_var("shell", "nash");
   nash_set_var("version", "2.0");
 
-  nash_execute_script(script);
+  nash_run_prog(&slot->prog);
 }
 
 void cmd_nash_vars(const char *args) {
   (void)args;
   kprintf("\nNash Variables:\n");
-  for (int i = 0; i < MAX_VARS; i++) {
-    if (nash_vars[i].name[0]) {
-      kprintf("  @%s = \"%s\"\n", nash_vars[i].name, nash_vars[i].value);
+  for (int i = 0; i < NASH_VAR_SLOTS; i++) {
+    if (nash_var_slots[i].state == VARTAB_USED) {
+      kprintf("  @%s = \"%s\"\n", nash_var_slots[i].name,
+              nash_var_slots[i].value);
     }
   }
   kprintf("\n");
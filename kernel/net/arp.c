@@ -7,19 +7,37 @@
 #include "../kernel.h"
 #include "network.h"
 
-/* ARP cache */
-#define ARP_CACHE_SIZE 16
-#define ARP_TIMEOUT 300 /* 5 minutes in seconds */
+/* ARP cache - hash-indexed by IP with linear probing */
+#define ARP_CACHE_SIZE 32 /* Power of two */
+#define ARP_PROBES 4
+#define ARP_TIMEOUT_TICKS (300 * 1000) /* 5 minutes */
+#define ARP_RETRY_TICKS 1000 /* Coalesce requests inside this window */
 
 typedef struct {
   uint32_t ip;
   uint8_t mac[6];
-  uint32_t timestamp;
   uint8_t valid;
+  uint8_t pending; /* Request sent, awaiting reply */
+  uint32_t timestamp;
+  uint32_t request_tick;
 } arp_entry_t;
 
 static arp_entry_t arp_cache[ARP_CACHE_SIZE];
 
+/* Frames parked while their next hop resolves; flushed on reply */
+#define ARP_PENDING 8
+
+typedef struct {
+  uint32_t ip; /* Next hop being resolved */
+  uint16_t len;
+  uint8_t in_use;
+  uint8_t frame[PBUF_MAX]; /* Ethernet header space + IP packet */
+} arp_pending_t;
+
+static arp_pending_t arp_pending[ARP_PENDING];
+
+static inline int arp_hash(uint32_t ip) { return (ip * 2654435761u) >> 27; }
+
 /* Our network config */
 static uint32_t our_ip = 0x0A000001; /* 10.0.0.1 */
 static uint8_t our_mac[6] = {0x52, 0x54, 0x00, 0x12, 0x34, 0x56};
@@ -29,7 +47,43 @@ static uint32_t netmask = 0xFFFFFF00;    /* 255.255.255.0 */
 /*
  * Initialize ARP
  */
-void arp_init(void) { memset(arp_cache, 0, sizeof(arp_cache)); }
+void arp_init(void) {
+  memset(arp_cache, 0, sizeof(arp_cache));
+  memset(arp_pending, 0, sizeof(arp_pending));
+}
+
+/*
+ * Find the cache entry for an IP, or NULL
+ */
+static arp_entry_t *arp_find(uint32_t ip) {
+  int h = arp_hash(ip);
+  for (int i = 0; i < ARP_PROBES; i++) {
+    arp_entry_t *e = &arp_cache[(h + i) & (ARP_CACHE_SIZE - 1)];
+    if ((e->valid || e->pending) && e->ip == ip)
+      return e;
+  }
+  return NULL;
+}
+
+/*
+ * Pick the slot an IP should occupy: its existing entry, a free one,
+ * or the oldest in its probe window
+ */
+static arp_entry_t *arp_slot(uint32_t ip) {
+  int h = arp_hash(ip);
+  arp_entry_t *victim = NULL;
+
+  for (int i = 0; i < ARP_PROBES; i++) {
+    arp_entry_t *e = &arp_cache[(h + i) & (ARP_CACHE_SIZE - 1)];
+    if ((e->valid || e->pending) && e->ip == ip)
+      return e;
+    if (!e->valid && !e->pending)
+      return e;
+    if (!victim || e->timestamp < victim->timestamp)
+      victim = e;
+  }
+  return victim;
+}
 
 /*
  * Set network configuration
@@ -45,50 +99,53 @@ void net_set_mac(const uint8_t *mac) { memcpy(our_mac, mac, 6); }
 void net_get_mac(uint8_t *mac) { memcpy(mac, our_mac, 6); }
 
 /*
- * Look up MAC address in ARP cache
+ * Look up MAC address in ARP cache (expired entries miss)
  */
 int arp_lookup(uint32_t ip, uint8_t *mac) {
-  for (int i = 0; i < ARP_CACHE_SIZE; i++) {
-    if (arp_cache[i].valid && arp_cache[i].ip == ip) {
-      memcpy(mac, arp_cache[i].mac, 6);
-      return 0;
-    }
+  arp_entry_t *e = arp_find(ip);
+  if (!e || !e->valid)
+    return -1;
+
+  if (timer_get_ticks() - e->timestamp > ARP_TIMEOUT_TICKS) {
+    e->valid = 0; /* Expired - force re-resolution */
+    return -1;
   }
-  return -1; /* Not found */
+
+  memcpy(mac, e->mac, 6);
+  return 0;
 }
 
 /*
- * Add entry to ARP cache
+ * Send any frames parked waiting for this IP to resolve
  */
-void arp_add(uint32_t ip, const uint8_t *mac) {
-  /* Check if already exists */
-  for (int i = 0; i < ARP_CACHE_SIZE; i++) {
-    if (arp_cache[i].valid && arp_cache[i].ip == ip) {
-      memcpy(arp_cache[i].mac, mac, 6);
-      arp_cache[i].timestamp = timer_get_ticks();
-      return;
-    }
+static void arp_flush_pending(uint32_t ip, const uint8_t *mac) {
+  for (int i = 0; i < ARP_PENDING; i++) {
+    arp_pending_t *pe = &arp_pending[i];
+    if (!pe->in_use || pe->ip != ip)
+      continue;
+
+    memcpy(pe->frame, mac, 6);
+    memcpy(pe->frame + 6, our_mac, 6);
+    pe->frame[12] = 0x08;
+    pe->frame[13] = 0x00;
+    net_send(pe->frame, pe->len);
+    pe->in_use = 0;
   }
+}
 
-  /* Find empty or oldest slot */
-  int oldest = 0;
-  uint32_t oldest_time = 0xFFFFFFFF;
+/*
+ * Add entry to ARP cache
+ */
+void arp_add(uint32_t ip, const uint8_t *mac) {
+  arp_entry_t *e = arp_slot(ip);
 
-  for (int i = 0; i < ARP_CACHE_SIZE; i++) {
-    if (!arp_cache[i].valid) {
-      oldest = i;
-      break;
-    }
-    if (arp_cache[i].timestamp < oldest_time) {
-      oldest_time = arp_cache[i].timestamp;
-      oldest = i;
-    }
-  }
+  e->ip = ip;
+  memcpy(e->mac, mac, 6);
+  e->timestamp = timer_get_ticks();
+  e->valid = 1;
+  e->pending = 0;
 
-  arp_cache[oldest].ip = ip;
-  memcpy(arp_cache[oldest].mac, mac, 6);
-  arp_cache[oldest].timestamp = timer_get_ticks();
-  arp_cache[oldest].valid = 1;
+  arp_flush_pending(ip, mac);
 }
 
 /*
@@ -130,6 +187,62 @@ void arp_request(uint32_t target_ip) {
   net_send(packet, 42);
 }
 
+/*
+ * Encapsulate and transmit an IP packet, resolving the next hop.
+ * On a cache hit the frame goes straight out. On a miss the frame is
+ * parked on the pending queue and an ARP request goes out instead -
+ * the reply flushes the queue, so the caller never busy-waits.
+ * Duplicate requests within the retry window are coalesced.
+ */
+int arp_output(pbuf_t *p, uint32_t dest_ip) {
+  uint32_t next_hop = dest_ip;
+  if ((dest_ip & netmask) != (our_ip & netmask)) {
+    next_hop = gateway_ip; /* Off-subnet - route via gateway */
+  }
+
+  uint8_t mac[6];
+  if (arp_lookup(next_hop, mac) == 0) {
+    uint8_t *eth = pbuf_push(p, 14);
+    if (!eth)
+      return -1;
+    memcpy(eth, mac, 6);
+    memcpy(eth + 6, our_mac, 6);
+    eth[12] = 0x08;
+    eth[13] = 0x00;
+    return net_send(p->data, p->len);
+  }
+
+  /* Cold cache - park the frame with ethernet header space reserved */
+  int parked = 0;
+  for (int i = 0; i < ARP_PENDING; i++) {
+    arp_pending_t *pe = &arp_pending[i];
+    if (pe->in_use)
+      continue;
+    if (p->len + 14 > PBUF_MAX)
+      return -1;
+    pe->ip = next_hop;
+    pe->len = p->len + 14;
+    memcpy(pe->frame + 14, p->data, p->len);
+    pe->in_use = 1;
+    parked = 1;
+    break;
+  }
+
+  /* Coalesce: only one outstanding request per IP per window */
+  arp_entry_t *e = arp_slot(next_hop);
+  uint32_t now = timer_get_ticks();
+  if (!e->pending || e->ip != next_hop ||
+      now - e->request_tick > ARP_RETRY_TICKS) {
+    e->ip = next_hop;
+    e->valid = 0;
+    e->pending = 1;
+    e->request_tick = now;
+    arp_request(next_hop);
+  }
+
+  return parked ? 0 : -1;
+}
+
 /*
  * Handle incoming ARP packet
  */
@@ -20,6 +20,128 @@ void dns_set_server(uint32_t ip) { dns_server = ip; }
 
 uint32_t dns_get_server(void) { return dns_server; }
 
+/* ============================================
+ * DNS Cache
+ * ============================================
+ * Hash table keyed by name (case-insensitive). Positive entries live
+ * for the record's TTL; NXDOMAIN and empty answers are cached
+ * negatively so repeat failures don't hit the network either.
+ */
+
+#define DNS_CACHE_SIZE 32 /* Power of two */
+#define DNS_CACHE_PROBES 4
+#define DNS_NAME_MAX 64
+#define DNS_NEG_TTL 60       /* Seconds to remember a failure */
+#define DNS_MAX_TTL 86400    /* Clamp absurd TTLs to a day */
+
+typedef struct {
+  char name[DNS_NAME_MAX];
+  uint32_t ip;
+  uint32_t expiry; /* Tick at which the entry dies */
+  uint8_t negative;
+  uint8_t valid;
+} dns_cache_entry_t;
+
+static dns_cache_entry_t dns_cache[DNS_CACHE_SIZE];
+static uint32_t dns_hits = 0;
+static uint32_t dns_neg_hits = 0;
+static uint32_t dns_misses = 0;
+
+static char dns_lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+static uint32_t dns_hash(const char *name) {
+  uint32_t h = 5381;
+  while (*name)
+    h = h * 33 + (uint8_t)dns_lower(*name++);
+  return h;
+}
+
+static int dns_name_eq(const char *a, const char *b) {
+  while (*a && dns_lower(*a) == dns_lower(*b)) {
+    a++;
+    b++;
+  }
+  return dns_lower(*a) == dns_lower(*b);
+}
+
+static dns_cache_entry_t *dns_cache_find(const char *name) {
+  uint32_t h = dns_hash(name);
+  uint32_t now = timer_get_ticks();
+
+  for (int i = 0; i < DNS_CACHE_PROBES; i++) {
+    dns_cache_entry_t *e = &dns_cache[(h + i) & (DNS_CACHE_SIZE - 1)];
+    if (!e->valid || !dns_name_eq(e->name, name))
+      continue;
+    if ((int32_t)(e->expiry - now) <= 0) {
+      e->valid = 0; /* TTL expired */
+      return NULL;
+    }
+    return e;
+  }
+  return NULL;
+}
+
+static void dns_cache_insert(const char *name, uint32_t ip, uint32_t ttl_sec,
+                             int negative) {
+  uint32_t h = dns_hash(name);
+  dns_cache_entry_t *victim = NULL;
+
+  if (ttl_sec == 0 || ttl_sec > DNS_MAX_TTL)
+    ttl_sec = negative ? DNS_NEG_TTL : DNS_MAX_TTL;
+
+  for (int i = 0; i < DNS_CACHE_PROBES; i++) {
+    dns_cache_entry_t *e = &dns_cache[(h + i) & (DNS_CACHE_SIZE - 1)];
+    if (e->valid && dns_name_eq(e->name, name)) {
+      victim = e;
+      break;
+    }
+    if (!e->valid) {
+      victim = e;
+      break;
+    }
+    if (!victim || e->expiry < victim->expiry)
+      victim = e; /* Evict whatever dies soonest */
+  }
+
+  strncpy(victim->name, name, DNS_NAME_MAX - 1);
+  victim->name[DNS_NAME_MAX - 1] = '\0';
+  victim->ip = ip;
+  victim->expiry = timer_get_ticks() + ttl_sec * 1000;
+  victim->negative = negative;
+  victim->valid = 1;
+}
+
+static void dns_cache_stats(void) {
+  uint32_t now = timer_get_ticks();
+  int live = 0;
+
+  kprintf("\n=== DNS Cache ===\n");
+  for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+    dns_cache_entry_t *e = &dns_cache[i];
+    if (!e->valid || (int32_t)(e->expiry - now) <= 0)
+      continue;
+    live++;
+    if (e->negative) {
+      kprintf("%s -> NXDOMAIN (ttl %ds)\n", e->name,
+              (e->expiry - now) / 1000);
+    } else {
+      kprintf("%s -> %d.%d.%d.%d (ttl %ds)\n", e->name, (e->ip >> 24) & 0xFF,
+              (e->ip >> 16) & 0xFF, (e->ip >> 8) & 0xFF, e->ip & 0xFF,
+              (e->expiry - now) / 1000);
+    }
+  }
+  if (live == 0)
+    kprintf("(empty)\n");
+
+  uint32_t total = dns_hits + dns_neg_hits + dns_misses;
+  kprintf("\nhits=%d neg=%d misses=%d", dns_hits, dns_neg_hits, dns_misses);
+  if (total > 0)
+    kprintf(" (%d%% served from cache)", (dns_hits + dns_neg_hits) * 100 / total);
+  kprintf("\n");
+}
+
 /*
  * Encode domain name for DNS query
  */
@@ -57,6 +179,19 @@ int dns_lookup(const char *hostname, uint32_t *ip) {
   uint8_t query[512];
   uint8_t response[512];
 
+  /* Serve repeat lookups from the cache */
+  dns_cache_entry_t *ce = dns_cache_find(hostname);
+  if (ce) {
+    if (ce->negative) {
+      dns_neg_hits++;
+      return -6;
+    }
+    dns_hits++;
+    *ip = ce->ip;
+    return 0;
+  }
+  dns_misses++;
+
   /* Build DNS query */
   static uint16_t dns_id = 1;
   uint16_t id = dns_id++;
@@ -120,9 +255,16 @@ int dns_lookup(const char *hostname, uint32_t *ip) {
     return -5; /* Not a response */
   }
 
+  if ((flags & 0x000F) == 3) {
+    /* NXDOMAIN - cache the failure */
+    dns_cache_insert(hostname, 0, DNS_NEG_TTL, 1);
+    return -6;
+  }
+
   /* Get answer count */
   uint16_t ancount = (response[6] << 8) | response[7];
   if (ancount == 0) {
+    dns_cache_insert(hostname, 0, DNS_NEG_TTL, 1);
     return -6; /* No answers */
   }
 
@@ -154,7 +296,11 @@ int dns_lookup(const char *hostname, uint32_t *ip) {
     uint16_t rtype = (response[pos] << 8) | response[pos + 1];
     pos += 2;
     pos += 2; /* Skip class */
-    pos += 4; /* Skip TTL */
+
+    uint32_t ttl = ((uint32_t)response[pos] << 24) |
+                   ((uint32_t)response[pos + 1] << 16) |
+                   ((uint32_t)response[pos + 2] << 8) | response[pos + 3];
+    pos += 4;
 
     uint16_t rdlen = (response[pos] << 8) | response[pos + 1];
     pos += 2;
@@ -163,6 +309,7 @@ int dns_lookup(const char *hostname, uint32_t *ip) {
       *ip = ((uint32_t)response[pos] << 24) |
             ((uint32_t)response[pos + 1] << 16) |
             ((uint32_t)response[pos + 2] << 8) | response[pos + 3];
+      dns_cache_insert(hostname, *ip, ttl, 0);
       return 0;
     }
 
@@ -181,6 +328,12 @@ void cmd_dns_real(const char *args) {
             (dns_server >> 16) & 0xFF, (dns_server >> 8) & 0xFF,
             dns_server & 0xFF);
     kprintf("Usage: dns <hostname>\n");
+    kprintf("       dns -stats\n");
+    return;
+  }
+
+  if (strcmp(args, "-stats") == 0) {
+    dns_cache_stats();
     return;
   }
 
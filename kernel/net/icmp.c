@@ -16,82 +16,16 @@ static volatile int ping_received = 0;
 static volatile uint32_t ping_rtt = 0;
 static volatile uint16_t ping_seq = 0;
 
-/*
- * Calculate IP checksum
- */
-static uint16_t ip_checksum(const uint8_t *data, size_t len) {
-  uint32_t sum = 0;
-
-  for (size_t i = 0; i < len - 1; i += 2) {
-    sum += (data[i] << 8) | data[i + 1];
-  }
-
-  if (len & 1) {
-    sum += data[len - 1] << 8;
-  }
-
-  while (sum >> 16) {
-    sum = (sum & 0xFFFF) + (sum >> 16);
-  }
-
-  return ~sum;
-}
-
 /*
  * Send ICMP echo request (ping)
  */
 int icmp_ping(uint32_t dest_ip, uint16_t seq, uint32_t *rtt) {
-  uint8_t packet[74]; /* Ethernet(14) + IP(20) + ICMP(8) + Data(32) */
-  uint8_t dest_mac[6];
-
-  /* Resolve MAC address */
-  if (arp_resolve(dest_ip, dest_mac, 1000) != 0) {
-    return -1; /* ARP failed */
-  }
-
-  /* Get our MAC */
-  uint8_t our_mac[6];
-  net_get_mac(our_mac);
-  uint32_t our_ip = net_get_ip();
-
-  /* Ethernet header */
-  memcpy(packet, dest_mac, 6);
-  memcpy(packet + 6, our_mac, 6);
-  packet[12] = 0x08;
-  packet[13] = 0x00; /* IPv4 */
+  /* Build the ICMP message in a pbuf; the IP layer prepends its
+   * headers in place */
+  pbuf_t p;
+  pbuf_init(&p);
 
-  /* IP header */
-  uint8_t *ip = packet + 14;
-  ip[0] = 0x45; /* Version 4, IHL 5 */
-  ip[1] = 0x00; /* DSCP/ECN */
-  ip[2] = 0x00;
-  ip[3] = 60; /* Total length */
-  ip[4] = 0x00;
-  ip[5] = seq & 0xFF; /* Identification */
-  ip[6] = 0x00;
-  ip[7] = 0x00; /* Flags/Fragment */
-  ip[8] = 64;   /* TTL */
-  ip[9] = 1;    /* Protocol: ICMP */
-  ip[10] = 0x00;
-  ip[11] = 0x00; /* Checksum (calculated below) */
-
-  ip[12] = (our_ip >> 24) & 0xFF; /* Source IP */
-  ip[13] = (our_ip >> 16) & 0xFF;
-  ip[14] = (our_ip >> 8) & 0xFF;
-  ip[15] = our_ip & 0xFF;
-
-  ip[16] = (dest_ip >> 24) & 0xFF; /* Dest IP */
-  ip[17] = (dest_ip >> 16) & 0xFF;
-  ip[18] = (dest_ip >> 8) & 0xFF;
-  ip[19] = dest_ip & 0xFF;
-
-  /* IP checksum */
-  uint16_t ip_csum = ip_checksum(ip, 20);
-  ip[10] = (ip_csum >> 8) & 0xFF;
-  ip[11] = ip_csum & 0xFF;
-
-  /* ICMP header */
-  uint8_t *icmp = packet + 34;
+  uint8_t *icmp = pbuf_put(&p, 40); /* ICMP(8) + Data(32) */
   icmp[0] = ICMP_ECHO_REQUEST; /* Type */
   icmp[1] = 0;                 /* Code */
   icmp[2] = 0;
@@ -109,7 +43,7 @@ int icmp_ping(uint32_t dest_ip, uint16_t seq, uint32_t *rtt) {
   }
 
   /* ICMP checksum */
-  uint16_t icmp_csum = ip_checksum(icmp, 40);
+  uint16_t icmp_csum = net_checksum(icmp, 40);
   icmp[2] = (icmp_csum >> 8) & 0xFF;
   icmp[3] = icmp_csum & 0xFF;
 
@@ -117,7 +51,9 @@ int icmp_ping(uint32_t dest_ip, uint16_t seq, uint32_t *rtt) {
   ping_received = 0;
   ping_seq = seq;
 
-  net_send(packet, 74);
+  if (ip_send_pbuf(&p, dest_ip, 1) != 0) {
+    return -1; /* ARP failed */
+  }
 
   /* Wait for reply */
   uint32_t start = timer_get_ticks();
@@ -168,70 +104,23 @@ void icmp_handle(const uint8_t *packet, size_t len, uint32_t src_ip) {
  * Send ICMP echo reply
  */
 void icmp_send_reply(uint32_t dest_ip, const uint8_t *request, size_t req_len) {
-  size_t total_len = 14 + 20 + req_len;
-  if (total_len > 1500)
-    return;
-
-  uint8_t packet[1500];
-  uint8_t dest_mac[6];
-
-  /* Resolve MAC */
-  if (arp_resolve(dest_ip, dest_mac, 500) != 0) {
+  if (req_len > PBUF_MAX - PBUF_HEADROOM)
     return;
-  }
-
-  uint8_t our_mac[6];
-  net_get_mac(our_mac);
-  uint32_t our_ip = net_get_ip();
-
-  /* Ethernet header */
-  memcpy(packet, dest_mac, 6);
-  memcpy(packet + 6, our_mac, 6);
-  packet[12] = 0x08;
-  packet[13] = 0x00;
-
-  /* IP header */
-  uint8_t *ip = packet + 14;
-  ip[0] = 0x45;
-  ip[1] = 0x00;
-  uint16_t ip_len = 20 + req_len;
-  ip[2] = (ip_len >> 8) & 0xFF;
-  ip[3] = ip_len & 0xFF;
-  ip[4] = 0x00;
-  ip[5] = 0x00;
-  ip[6] = 0x00;
-  ip[7] = 0x00;
-  ip[8] = 64;
-  ip[9] = 1; /* ICMP */
-  ip[10] = 0;
-  ip[11] = 0;
-
-  ip[12] = (our_ip >> 24) & 0xFF;
-  ip[13] = (our_ip >> 16) & 0xFF;
-  ip[14] = (our_ip >> 8) & 0xFF;
-  ip[15] = our_ip & 0xFF;
-
-  ip[16] = (dest_ip >> 24) & 0xFF;
-  ip[17] = (dest_ip >> 16) & 0xFF;
-  ip[18] = (dest_ip >> 8) & 0xFF;
-  ip[19] = dest_ip & 0xFF;
-
-  uint16_t csum = ip_checksum(ip, 20);
-  ip[10] = (csum >> 8) & 0xFF;
-  ip[11] = csum & 0xFF;
 
   /* ICMP reply - copy request but change type */
-  uint8_t *icmp = packet + 34;
+  pbuf_t p;
+  pbuf_init(&p);
+  uint8_t *icmp = pbuf_put(&p, req_len);
   memcpy(icmp, request, req_len);
   icmp[0] = ICMP_ECHO_REPLY;
   icmp[2] = 0;
   icmp[3] = 0; /* Clear checksum */
 
-  csum = ip_checksum(icmp, req_len);
+  uint16_t csum = net_checksum(icmp, req_len);
   icmp[2] = (csum >> 8) & 0xFF;
   icmp[3] = csum & 0xFF;
 
-  net_send(packet, total_len);
+  ip_send_pbuf(&p, dest_ip, 1);
 }
 
 /*
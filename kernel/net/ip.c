@@ -40,6 +40,12 @@ void ip_handle(const uint8_t *packet, size_t len) {
     return; /* Not for us */
   }
 
+  /* Firewall: drop traffic from blocked sources */
+  if (!firewall_check_ip(src_ip)) {
+    secmon_event(SEC_EV_FW_DROP, 1, src_ip, 0);
+    return;
+  }
+
   const uint8_t *payload = packet + header_len;
   size_t payload_len = len - header_len;
 
@@ -50,42 +56,27 @@ void ip_handle(const uint8_t *packet, size_t len) {
   case 17: /* UDP */
     udp_handle(payload, payload_len, src_ip);
     break;
-  case 6: /* TCP - not implemented */
+  case 6: /* TCP */
+    tcp_handle(payload, payload_len, src_ip);
     break;
   }
 }
 
 /*
- * Send IP packet
+ * Send an IP packet from a pbuf. The payload is already in place;
+ * the IP and ethernet headers are prepended in the pbuf's headroom,
+ * so no copy is made on the way down.
  */
-int ip_send(uint32_t dest_ip, uint8_t protocol, const uint8_t *data,
-            size_t len) {
-  if (len > 1480)
-    return -1; /* Too large */
-
-  uint8_t packet[1514];
-  uint8_t dest_mac[6];
-
-  /* Resolve destination MAC */
-  if (arp_resolve(dest_ip, dest_mac, 1000) != 0) {
-    return -1;
-  }
-
-  uint8_t our_mac[6];
-  net_get_mac(our_mac);
+int ip_send_pbuf(pbuf_t *p, uint32_t dest_ip, uint8_t protocol) {
   uint32_t our_ip = net_get_ip();
 
   static uint16_t ip_id = 0;
 
-  /* Ethernet header */
-  memcpy(packet, dest_mac, 6);
-  memcpy(packet + 6, our_mac, 6);
-  packet[12] = 0x08;
-  packet[13] = 0x00;
-
   /* IP header */
-  uint8_t *ip = packet + 14;
-  uint16_t total_len = 20 + len;
+  uint16_t total_len = 20 + p->len;
+  uint8_t *ip = pbuf_push(p, 20);
+  if (!ip)
+    return -1;
 
   ip[0] = 0x45;
   ip[1] = 0x00;
@@ -112,19 +103,25 @@ int ip_send(uint32_t dest_ip, uint8_t protocol, const uint8_t *data,
   ip[19] = dest_ip & 0xFF;
 
   /* Calculate checksum */
-  uint32_t sum = 0;
-  for (int i = 0; i < 20; i += 2) {
-    sum += (ip[i] << 8) | ip[i + 1];
-  }
-  while (sum >> 16) {
-    sum = (sum & 0xFFFF) + (sum >> 16);
-  }
-  uint16_t csum = ~sum;
+  uint16_t csum = net_checksum(ip, 20);
   ip[10] = (csum >> 8) & 0xFF;
   ip[11] = csum & 0xFF;
 
-  /* Copy payload */
-  memcpy(packet + 34, data, len);
+  /* Resolve the next hop and transmit (or park until it resolves) */
+  return arp_output(p, dest_ip);
+}
+
+/*
+ * Send IP packet from a flat buffer (compatibility wrapper: copies
+ * the payload into a pbuf once, then takes the zero-copy path)
+ */
+int ip_send(uint32_t dest_ip, uint8_t protocol, const uint8_t *data,
+            size_t len) {
+  if (len > PBUF_MAX - PBUF_HEADROOM)
+    return -1; /* Larger than the pbuf payload capacity */
 
-  return net_send(packet, 14 + 20 + len);
+  pbuf_t p;
+  pbuf_init(&p);
+  memcpy(pbuf_put(&p, len), data, len);
+  return ip_send_pbuf(&p, dest_ip, protocol);
 }
@@ -4,7 +4,9 @@
  * Real driver for NE2000-compatible NICs (QEMU compatible)
  */
 
+#include "../cpu/idt.h"
 #include "../kernel.h"
+#include "../proc/process.h"
 #include "network.h"
 
 /* NE2000 I/O Base (default ISA) */
@@ -46,15 +48,68 @@
 #define NE_CMD_PAGE1 0x40
 #define NE_CMD_PAGE2 0x80
 
-/* Receive buffer layout */
-#define NE_RX_START 0x46
+/* Buffer layout: two transmit page regions ping-pong - while one
+ * transmits, the next frame is remote-DMA-loaded into the other -
+ * and the rest of the 16KB window is the receive ring */
+#define NE_TX_PAGE_A 0x40
+#define NE_TX_PAGE_B 0x46
+#define NE_RX_START 0x4C
 #define NE_RX_STOP 0x80
-#define NE_TX_START 0x40
+#define NE_TX_START NE_TX_PAGE_A
 
 static uint16_t ne_base = NE2000_BASE;
 static int ne_initialized = 0;
 static uint8_t current_mac[6];
 
+/* Preallocated receive ring: the IRQ handler copies frames out of the
+ * NIC here and defers protocol processing to the work queue, so
+ * packets no longer sit in the NIC until someone calls net_poll. */
+#define NE_RX_RING 16
+
+typedef struct {
+  uint8_t data[1514];
+  uint16_t len;
+} ne_rx_slot_t;
+
+static ne_rx_slot_t rx_ring[NE_RX_RING];
+static volatile uint32_t rx_head = 0; /* next slot to process */
+static volatile uint32_t rx_tail = 0; /* next slot to fill */
+static uint32_t rx_dropped = 0;
+
+/* Software transmit queue: net_send enqueues and returns; the
+ * TX-complete interrupt advances the queue */
+#define NE_TX_QUEUE 8
+
+typedef struct {
+  uint8_t data[1514];
+  uint16_t len;
+} ne_tx_frame_t;
+
+static ne_tx_frame_t tx_queue[NE_TX_QUEUE];
+static volatile uint32_t tx_qhead = 0; /* next frame to load */
+static volatile uint32_t tx_qtail = 0; /* next slot to fill */
+static volatile int tx_hw_busy = 0;    /* transmitter running */
+static volatile int tx_cur = -1;       /* NIC slot transmitting */
+static volatile int tx_loaded = -1;    /* NIC slot preloaded */
+static volatile uint16_t tx_loaded_len = 0;
+
+static const uint8_t tx_slot_page[2] = {NE_TX_PAGE_A, NE_TX_PAGE_B};
+
+static void ne2000_irq(interrupt_frame_t *frame);
+
+/* The TX state machine is touched from both process context and the
+ * IRQ handler; bracket it with the usual flag save */
+static inline uint32_t ne_irq_save(void) {
+  uint32_t flags;
+  asm volatile("pushf; pop %0; cli" : "=r"(flags));
+  return flags;
+}
+
+static inline void ne_irq_restore(uint32_t flags) {
+  if (flags & 0x200)
+    asm volatile("sti");
+}
+
 /* Word output for NE2000 */
 static inline void outw(uint16_t port, uint16_t val) {
   asm volatile("outw %0, %1" : : "a"(val), "Nd"(port));
@@ -110,8 +165,11 @@ int net_init(void) {
   /* Clear ISR */
   ne_write(NE_ISR, 0xFF);
 
-  /* Set IMR */
-  ne_write(NE_IMR, 0x00); /* No interrupts for now */
+  /* Unmask packet-received and transmit-complete interrupts; the
+   * handler drains the NIC into the receive ring and advances the TX
+   * queue (ISA NE2000 default is IRQ9) */
+  ne_write(NE_IMR, 0x0B);
+  isr_register_handler(IRQ9, ne2000_irq);
 
   /* Switch to page 1 to set MAC and current page */
   ne_write(NE_CMD, NE_CMD_STOP | NE_CMD_NODMA | NE_CMD_PAGE1);
@@ -163,6 +221,7 @@ int net_init(void) {
   /* Initialize protocols */
   arp_init();
   udp_init();
+  tcp_init();
 
   kprintf("  [OK] NE2000 Network (MAC: %02x:%02x:%02x:%02x:%02x:%02x)\n",
           current_mac[0], current_mac[1], current_mac[2], current_mac[3],
@@ -172,34 +231,19 @@ int net_init(void) {
 }
 
 /*
- * Send packet
+ * Remote-DMA a frame into one of the NIC transmit page regions.
+ * The remote DMA engine is independent of the transmitter, so this
+ * runs while the other slot is on the wire.
  */
-int net_send(const uint8_t *packet, size_t len) {
-  if (!ne_initialized)
-    return -1;
-  if (len < 14 || len > 1514)
-    return -1;
-
-  /* Pad to minimum */
-  if (len < 60)
-    len = 60;
-
-  /* Wait for any pending transmit */
-  int timeout = 1000;
-  while ((ne_read(NE_CMD) & NE_CMD_TRANS) && timeout-- > 0)
-    ;
-
-  /* Set up DMA for write */
+static void ne_tx_load(int slot, const uint8_t *packet, size_t len) {
   ne_write(NE_ISR, 0x40); /* Clear remote DMA complete */
   ne_write(NE_RBCR0, len & 0xFF);
   ne_write(NE_RBCR1, (len >> 8) & 0xFF);
   ne_write(NE_RSAR0, 0);
-  ne_write(NE_RSAR1, NE_TX_START);
+  ne_write(NE_RSAR1, tx_slot_page[slot]);
 
-  /* Start remote write */
   ne_write(NE_CMD, NE_CMD_START | NE_CMD_RWRITE | NE_CMD_PAGE0);
 
-  /* Write data */
   for (size_t i = 0; i < len; i += 2) {
     uint16_t word = packet[i];
     if (i + 1 < len)
@@ -207,45 +251,166 @@ int net_send(const uint8_t *packet, size_t len) {
     outw(ne_base + NE_DATA, word);
   }
 
-  /* Wait for completion */
-  timeout = 1000;
+  int timeout = 1000;
   while ((ne_read(NE_ISR) & 0x40) == 0 && timeout-- > 0)
     ;
+}
 
-  /* Set transmit parameters */
-  ne_write(NE_TPSR, NE_TX_START);
+/* Fire the transmitter on a loaded slot */
+static void ne_tx_fire(int slot, uint16_t len) {
+  ne_write(NE_TPSR, tx_slot_page[slot]);
   ne_write(NE_TBCR0, len & 0xFF);
   ne_write(NE_TBCR1, (len >> 8) & 0xFF);
-
-  /* Start transmit */
   ne_write(NE_CMD, NE_CMD_START | NE_CMD_TRANS | NE_CMD_NODMA | NE_CMD_PAGE0);
+}
 
-  return 0;
+/*
+ * Advance the transmit pipeline: start a preloaded slot if the
+ * transmitter is idle, then preload the next queued frame into the
+ * free slot. Interrupts must be off.
+ */
+static void ne_tx_kick(void) {
+  for (;;) {
+    if (tx_loaded < 0 && tx_qhead != tx_qtail) {
+      int slot = (tx_cur == 0) ? 1 : 0;
+      ne_tx_frame_t *f = &tx_queue[tx_qhead];
+      ne_tx_load(slot, f->data, f->len);
+      tx_loaded = slot;
+      tx_loaded_len = f->len;
+      tx_qhead = (tx_qhead + 1) % NE_TX_QUEUE;
+    }
+
+    if (!tx_hw_busy && tx_loaded >= 0) {
+      ne_tx_fire(tx_loaded, tx_loaded_len);
+      tx_cur = tx_loaded;
+      tx_loaded = -1;
+      tx_hw_busy = 1;
+      continue; /* Pipeline: preload the next frame behind it */
+    }
+    break;
+  }
 }
 
 /*
- * Poll for incoming packets
+ * Queue a packet for transmit and return immediately. The
+ * TX-complete interrupt keeps the pipeline moving.
  */
-void net_poll(void) {
+int net_send(const uint8_t *packet, size_t len) {
   if (!ne_initialized)
-    return;
+    return -1;
+  if (len < 14 || len > 1514)
+    return -1;
+
+  uint32_t flags = ne_irq_save();
 
-  uint8_t buffer[1514];
-  int len;
+  uint32_t next = (tx_qtail + 1) % NE_TX_QUEUE;
+  if (next == tx_qhead) {
+    ne_irq_restore(flags);
+    return -1; /* Queue full */
+  }
 
-  while ((len = net_receive(buffer, sizeof(buffer))) > 0) {
-    if (len < 14)
-      continue;
+  ne_tx_frame_t *f = &tx_queue[tx_qtail];
+  memcpy(f->data, packet, len);
+  if (len < 60) {
+    memset(f->data + len, 0, 60 - len); /* Pad to minimum */
+    len = 60;
+  }
+  f->len = (uint16_t)len;
+  tx_qtail = next;
+  KTRACE(KTRACE_NET, KT_EV_NET_TX, len);
 
-    /* Parse Ethernet header */
-    uint16_t ethertype = (buffer[12] << 8) | buffer[13];
+  ne_tx_kick();
+  ne_irq_restore(flags);
+  return 0;
+}
 
-    if (ethertype == ETHERTYPE_ARP) {
-      arp_handle(buffer + 14, len - 14);
-    } else if (ethertype == ETHERTYPE_IP) {
-      ip_handle(buffer + 14, len - 14);
+/*
+ * Pull every pending frame out of the NIC into the receive ring.
+ * Called from the RX interrupt and as a polled fallback.
+ */
+static void ne_rx_drain(void) {
+  for (;;) {
+    uint32_t next = (rx_tail + 1) % NE_RX_RING;
+    if (next == rx_head) {
+      rx_dropped++;
+      return; /* ring full; frame stays in the NIC for now */
     }
+    int len = net_receive(rx_ring[rx_tail].data, sizeof(rx_ring[0].data));
+    if (len <= 0)
+      return;
+    rx_ring[rx_tail].len = (uint16_t)len;
+    rx_tail = next;
+    KTRACE(KTRACE_NET, KT_EV_NET_RX, (uint32_t)len);
+  }
+}
+
+/*
+ * Run queued frames through the protocol stack (process context)
+ */
+static void net_rx_process(void) {
+  while (rx_head != rx_tail) {
+    ne_rx_slot_t *slot = &rx_ring[rx_head];
+    if (slot->len >= 14) {
+      uint16_t ethertype = (slot->data[12] << 8) | slot->data[13];
+      if (ethertype == ETHERTYPE_ARP) {
+        arp_handle(slot->data + 14, slot->len - 14);
+      } else if (ethertype == ETHERTYPE_IP) {
+        ip_handle(slot->data + 14, slot->len - 14);
+      }
+    }
+    rx_head = (rx_head + 1) % NE_RX_RING;
+  }
+}
+
+static void net_rx_work(void *arg) {
+  (void)arg;
+  net_rx_process();
+}
+
+/*
+ * RX interrupt: copy frames into the ring and hand protocol work to
+ * the kernel worker; nothing above the driver runs at IRQ time
+ */
+static void ne2000_irq(interrupt_frame_t *frame) {
+  (void)frame;
+  uint8_t isr = ne_read(NE_ISR);
+
+  if (isr & 0x0A) {
+    /* TX complete (or error) - free the slot and advance the queue */
+    ne_write(NE_ISR, isr & 0x0A);
+    tx_hw_busy = 0;
+    ne_tx_kick();
   }
+
+  if (isr & 0x01) {
+    ne_rx_drain();
+    work_enqueue(net_rx_work, NULL);
+  }
+  /* Ack everything we saw (PRX is also cleared per-frame in
+   * net_receive; overflow bits just get cleared here) */
+  ne_write(NE_ISR, isr & ~0x0B);
+}
+
+/*
+ * Poll for incoming packets (fallback when IRQs are not enabled)
+ */
+void net_poll(void) {
+  if (!ne_initialized)
+    return;
+
+  /* TX fallback for a missed interrupt: if the transmitter has gone
+   * idle with work still queued, advance the pipeline by hand */
+  uint32_t flags = ne_irq_save();
+  if (tx_hw_busy && !(ne_read(NE_CMD) & NE_CMD_TRANS)) {
+    ne_write(NE_ISR, 0x0A);
+    tx_hw_busy = 0;
+  }
+  ne_tx_kick();
+  ne_irq_restore(flags);
+
+  ne_rx_drain();
+  net_rx_process();
+  tcp_timer();
 }
 
 /*
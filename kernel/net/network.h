@@ -7,8 +7,122 @@
 #ifndef _NETWORK_H
 #define _NETWORK_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+/* ============================================
+ * Packet Buffers (pbuf)
+ * ============================================
+ * One contiguous frame buffer with headroom reserved at the front:
+ * a transport protocol writes its payload once, then each layer on
+ * the way down prepends its header in place with pbuf_push. No
+ * per-layer copies.
+ */
+
+#define PBUF_MAX 1514
+#define PBUF_HEADROOM 64 /* eth(14) + ip(20) + tcp(20) + options */
+
+typedef struct {
+  uint8_t buf[PBUF_MAX];
+  uint8_t *data; /* first valid byte */
+  uint16_t len;  /* valid bytes from data */
+} pbuf_t;
+
+static inline void pbuf_init(pbuf_t *p) {
+  p->data = p->buf + PBUF_HEADROOM;
+  p->len = 0;
+}
+
+/* Prepend n bytes; returns pointer to the new front, NULL if no
+ * headroom remains */
+static inline uint8_t *pbuf_push(pbuf_t *p, size_t n) {
+  if ((size_t)(p->data - p->buf) < n)
+    return NULL;
+  p->data -= n;
+  p->len += n;
+  return p->data;
+}
+
+/* Append n bytes at the tail; returns pointer to write them at */
+static inline uint8_t *pbuf_put(pbuf_t *p, size_t n) {
+  if ((size_t)(p->data - p->buf) + p->len + n > PBUF_MAX)
+    return NULL;
+  uint8_t *tail = p->data + p->len;
+  p->len += n;
+  return tail;
+}
+
+/* ============================================
+ * Internet Checksum
+ * ============================================
+ * One shared one's-complement checksum for IP, ICMP, TCP and UDP.
+ * Accumulates 32 bits per step over dwords (unrolled), folds once at
+ * the end and does a single byte swap - the one's-complement sum is
+ * endian-agnostic, so summing native little-endian words and swapping
+ * the folded result equals the network-order sum.
+ */
+
+static inline uint16_t net_swap16(uint16_t v) {
+  return (uint16_t)((v << 8) | (v >> 8));
+}
+
+/* Running sum over a buffer; pass the previous sum to chain regions */
+static inline uint32_t net_checksum_partial(const void *buf, size_t len,
+                                            uint32_t sum) {
+  const uint8_t *p = (const uint8_t *)buf;
+  uint64_t acc = sum;
+
+  while (len >= 16) {
+    acc += *(const uint32_t *)(p + 0);
+    acc += *(const uint32_t *)(p + 4);
+    acc += *(const uint32_t *)(p + 8);
+    acc += *(const uint32_t *)(p + 12);
+    p += 16;
+    len -= 16;
+  }
+  while (len >= 4) {
+    acc += *(const uint32_t *)p;
+    p += 4;
+    len -= 4;
+  }
+  if (len >= 2) {
+    acc += *(const uint16_t *)p;
+    p += 2;
+    len -= 2;
+  }
+  if (len)
+    acc += *p; /* Trailing byte pads with a zero high byte */
+
+  acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+  acc = (acc & 0xFFFFFFFF) + (acc >> 32);
+  return (uint32_t)acc;
+}
+
+/* Fold to 16 bits, swap into network word order and invert */
+static inline uint16_t net_checksum_finish(uint32_t sum) {
+  sum = (sum & 0xFFFF) + (sum >> 16);
+  sum = (sum & 0xFFFF) + (sum >> 16);
+  return (uint16_t)~net_swap16((uint16_t)sum);
+}
+
+static inline uint16_t net_checksum(const void *buf, size_t len) {
+  return net_checksum_finish(net_checksum_partial(buf, len, 0));
+}
+
+/* TCP/UDP pseudo-header sum for host-order addresses; constant per
+ * connection, so compute once and cache. Add the byte-swapped segment
+ * length before finishing. */
+static inline uint32_t net_pseudo_sum(uint32_t src_ip, uint32_t dst_ip,
+                                      uint8_t protocol) {
+  uint32_t sum = 0;
+  sum += net_swap16((src_ip >> 16) & 0xFFFF);
+  sum += net_swap16(src_ip & 0xFFFF);
+  sum += net_swap16((dst_ip >> 16) & 0xFFFF);
+  sum += net_swap16(dst_ip & 0xFFFF);
+  sum += net_swap16(protocol);
+  return sum;
+}
+
 /* ============================================
  * Network Configuration
  * ============================================ */
@@ -40,6 +154,7 @@ int arp_lookup(uint32_t ip, uint8_t *mac);
 void arp_add(uint32_t ip, const uint8_t *mac);
 void arp_request(uint32_t target_ip);
 int arp_resolve(uint32_t ip, uint8_t *mac, int timeout_ms);
+int arp_output(pbuf_t *p, uint32_t dest_ip);
 void arp_handle(const uint8_t *packet, size_t len);
 void arp_show_cache(void);
 
@@ -50,6 +165,7 @@ void arp_show_cache(void);
 void ip_handle(const uint8_t *packet, size_t len);
 int ip_send(uint32_t dest_ip, uint8_t protocol, const uint8_t *data,
             size_t len);
+int ip_send_pbuf(pbuf_t *p, uint32_t dest_ip, uint8_t protocol);
 
 /* ============================================
  * ICMP Protocol
@@ -72,6 +188,21 @@ int udp_recv(int sock, uint8_t *buffer, size_t max_len, uint32_t *from_ip,
              uint16_t *from_port, int timeout_ms);
 void udp_handle(const uint8_t *packet, size_t len, uint32_t src_ip);
 
+/* ============================================
+ * TCP Protocol
+ * ============================================ */
+
+void tcp_init(void);
+int tcp_socket(void);
+void tcp_close(int sock);
+int tcp_bind(int sock, uint16_t port);
+int tcp_listen(int sock);
+int tcp_connect(int sock, uint32_t ip, uint16_t port);
+int tcp_send(int sock, const uint8_t *data, uint16_t len);
+int tcp_recv(int sock, uint8_t *buffer, uint16_t max_len);
+void tcp_handle(const uint8_t *packet, size_t len, uint32_t src_ip);
+void tcp_timer(void);
+
 /* ============================================
  * DNS Client
  * ============================================ */
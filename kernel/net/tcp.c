@@ -41,26 +41,136 @@ typedef struct __attribute__((packed)) {
   uint16_t urgent_ptr;
 } tcp_header_t;
 
+/* Segment sizing and queue depths. The segment size is bounded by
+ * what pbuf_put can actually hold after the headroom, not the
+ * ethernet-MSS 1460 - a larger cap would make pbuf_put return NULL
+ * for full-sized segments. */
+#define TCP_MSS (PBUF_MAX - PBUF_HEADROOM)
+#define TCP_TX_QUEUE 4  /* Unacked segments in flight per socket */
+#define TCP_OOO_QUEUE 2 /* Out-of-order segments held per socket */
+
+/* Receive buffer: starts small, doubles up to the cap while data is
+ * arriving faster than the application drains it */
+#define TCP_RECV_INITIAL 4096
+#define TCP_RECV_MAX 65536
+
+/* Heap headroom below which we stop growing / shrink the advertised
+ * window - sockets must not starve the rest of the kernel */
+#define TCP_MEM_RESERVE (128 * 1024)
+#define TCP_MEM_PRESSURE (64 * 1024)
+
+/* Retransmission: ticks before resend, and give-up count */
+#define TCP_RTO_TICKS 300
+#define TCP_MAX_RETRIES 8
+
+/* Sent segment awaiting acknowledgement */
+typedef struct {
+  uint32_t seq;       /* First sequence number */
+  uint16_t len;       /* Payload bytes */
+  uint8_t flags;      /* SYN/FIN consume a sequence number too */
+  uint8_t retries;
+  uint32_t sent_tick; /* Last (re)transmit time */
+  uint8_t in_use;
+  uint8_t data[TCP_MSS];
+} tcp_txseg_t;
+
+/* Received segment ahead of the expected sequence, held until the
+ * gap before it is filled */
+typedef struct {
+  uint32_t seq;
+  uint16_t len;
+  uint8_t in_use;
+  uint8_t data[TCP_MSS];
+} tcp_ooseg_t;
+
 /* TCP connection */
 typedef struct {
   int state;
   uint16_t local_port;
   uint16_t remote_port;
   uint32_t remote_ip;
-  uint32_t seq_num; /* Our sequence number */
-  uint32_t ack_num; /* Expected sequence from remote */
-  uint32_t send_window;
-  uint32_t recv_window;
-  uint8_t recv_buf[4096];
-  uint16_t recv_len;
-  uint8_t send_buf[4096];
-  uint16_t send_len;
+  uint32_t seq_num;     /* Next sequence number we will send (snd_nxt) */
+  uint32_t snd_una;     /* Oldest unacknowledged sequence number */
+  uint32_t ack_num;     /* Expected sequence from remote */
+  uint32_t csum_pseudo; /* Cached pseudo-header sum (minus length) */
+  uint16_t snd_wnd; /* Peer's advertised receive window */
+  uint8_t *recv_buf; /* Heap-allocated on connect/accept */
+  uint32_t recv_cap;
+  uint32_t recv_len;
+  tcp_txseg_t *txq;
+  tcp_ooseg_t *ooq;
   int in_use;
 } tcp_socket_t;
 
 #define MAX_TCP_SOCKETS 16
 static tcp_socket_t tcp_sockets[MAX_TCP_SOCKETS];
 
+/* Wrapping sequence-number comparisons */
+static inline int seq_lt(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+static inline int seq_le(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) <= 0;
+}
+
+/*
+ * Socket buffers live on the heap and exist only while a connection
+ * does - an idle socket table costs nothing
+ */
+static int tcp_alloc_bufs(tcp_socket_t *s) {
+  s->recv_buf = (uint8_t *)kmalloc(TCP_RECV_INITIAL);
+  s->txq = (tcp_txseg_t *)kmalloc(sizeof(tcp_txseg_t) * TCP_TX_QUEUE);
+  s->ooq = (tcp_ooseg_t *)kmalloc(sizeof(tcp_ooseg_t) * TCP_OOO_QUEUE);
+
+  if (!s->recv_buf || !s->txq || !s->ooq) {
+    if (s->recv_buf)
+      kfree(s->recv_buf);
+    if (s->txq)
+      kfree(s->txq);
+    if (s->ooq)
+      kfree(s->ooq);
+    s->recv_buf = NULL;
+    s->txq = NULL;
+    s->ooq = NULL;
+    return -1;
+  }
+
+  s->recv_cap = TCP_RECV_INITIAL;
+  s->recv_len = 0;
+  memset(s->txq, 0, sizeof(tcp_txseg_t) * TCP_TX_QUEUE);
+  memset(s->ooq, 0, sizeof(tcp_ooseg_t) * TCP_OOO_QUEUE);
+  return 0;
+}
+
+static void tcp_free_bufs(tcp_socket_t *s) {
+  if (s->recv_buf)
+    kfree(s->recv_buf);
+  if (s->txq)
+    kfree(s->txq);
+  if (s->ooq)
+    kfree(s->ooq);
+  s->recv_buf = NULL;
+  s->txq = NULL;
+  s->ooq = NULL;
+  s->recv_cap = 0;
+  s->recv_len = 0;
+}
+
+/*
+ * Advertised receive window: actual buffer availability, clamped
+ * down when the kernel heap is running low
+ */
+static uint16_t tcp_recv_window(const tcp_socket_t *s) {
+  uint32_t avail = s->recv_cap - s->recv_len;
+
+  size_t heap_alloc, heap_free;
+  mm_stats(&heap_alloc, &heap_free);
+  if (heap_free < TCP_MEM_PRESSURE && avail > 2048)
+    avail = 2048;
+
+  return (avail > 0xFFFF) ? 0xFFFF : (uint16_t)avail;
+}
+
 /* Simple pseudo-random for ISN */
 static uint32_t tcp_isn = 0x12345678;
 
@@ -93,38 +203,6 @@ static void *tcp_memmove(void *dest, const void *src, size_t n) {
   return dest;
 }
 
-/*
- * Calculate TCP checksum
- */
-static uint16_t tcp_checksum(uint32_t src_ip, uint32_t dst_ip,
-                             const uint8_t *tcp_data, uint16_t tcp_len) {
-  uint32_t sum = 0;
-
-  /* Pseudo header */
-  sum += (src_ip >> 16) & 0xFFFF;
-  sum += src_ip & 0xFFFF;
-  sum += (dst_ip >> 16) & 0xFFFF;
-  sum += dst_ip & 0xFFFF;
-  sum += 6; /* Protocol: TCP */
-  sum += tcp_len;
-
-  /* TCP header and data */
-  const uint16_t *ptr = (const uint16_t *)tcp_data;
-  for (int i = 0; i < tcp_len / 2; i++) {
-    sum += ntohs(ptr[i]);
-  }
-
-  if (tcp_len & 1) {
-    sum += tcp_data[tcp_len - 1] << 8;
-  }
-
-  while (sum >> 16) {
-    sum = (sum & 0xFFFF) + (sum >> 16);
-  }
-
-  return ~sum;
-}
-
 /*
  * Initialize TCP
  */
@@ -148,9 +226,13 @@ int tcp_socket(void) {
       tcp_sockets[i].remote_port = 0;
       tcp_sockets[i].remote_ip = 0;
       tcp_sockets[i].seq_num = tcp_isn++;
+      tcp_sockets[i].snd_una = tcp_sockets[i].seq_num;
+      tcp_sockets[i].snd_wnd = TCP_MSS;
+      tcp_sockets[i].recv_buf = NULL;
+      tcp_sockets[i].recv_cap = 0;
       tcp_sockets[i].recv_len = 0;
-      tcp_sockets[i].send_len = 0;
-      tcp_sockets[i].recv_window = 4096;
+      tcp_sockets[i].txq = NULL;
+      tcp_sockets[i].ooq = NULL;
       return i;
     }
   }
@@ -174,6 +256,7 @@ void tcp_close(int sock) {
     /* TODO: Wait for close to complete */
   }
 
+  tcp_free_bufs(s);
   s->in_use = 0;
   s->state = TCP_CLOSED;
 }
@@ -201,103 +284,260 @@ int tcp_listen(int sock) {
 }
 
 /*
- * Send TCP segment
+ * Transmit one TCP segment with an explicit sequence number
+ * (retransmissions resend old sequence numbers)
  */
-int tcp_send_segment(int sock, uint8_t flags, const uint8_t *data,
-                     uint16_t len) {
+static int tcp_output(int sock, uint32_t seq, uint8_t flags,
+                      const uint8_t *data, uint16_t len) {
   if (sock < 0 || sock >= MAX_TCP_SOCKETS)
     return -1;
 
   tcp_socket_t *s = &tcp_sockets[sock];
 
-  /* Build packet: Ethernet + IP + TCP + data */
-  uint8_t packet[1500];
-  size_t total_len = 14 + 20 + 20 + len;
-
-  /* Get our info */
-  uint8_t our_mac[6], dest_mac[6];
-  net_get_mac(our_mac);
-  uint32_t our_ip = net_get_ip();
-
-  /* Resolve MAC */
-  if (arp_resolve(s->remote_ip, dest_mac, 1000) != 0) {
-    return -1;
-  }
-
-  /* Ethernet header */
-  memcpy(packet, dest_mac, 6);
-  memcpy(packet + 6, our_mac, 6);
-  packet[12] = 0x08;
-  packet[13] = 0x00; /* IPv4 */
-
-  /* IP header */
-  uint8_t *ip = packet + 14;
-  ip[0] = 0x45; /* IPv4, IHL=5 */
-  ip[1] = 0x00;
-  uint16_t ip_len = 20 + 20 + len;
-  ip[2] = (ip_len >> 8) & 0xFF;
-  ip[3] = ip_len & 0xFF;
-  ip[4] = 0x00;
-  ip[5] = 0x00; /* ID */
-  ip[6] = 0x40;
-  ip[7] = 0x00; /* Don't fragment */
-  ip[8] = 64;   /* TTL */
-  ip[9] = 6;    /* Protocol: TCP */
-  ip[10] = 0;
-  ip[11] = 0; /* Checksum (calculated below) */
-  ip[12] = (our_ip >> 24) & 0xFF;
-  ip[13] = (our_ip >> 16) & 0xFF;
-  ip[14] = (our_ip >> 8) & 0xFF;
-  ip[15] = our_ip & 0xFF;
-  ip[16] = (s->remote_ip >> 24) & 0xFF;
-  ip[17] = (s->remote_ip >> 16) & 0xFF;
-  ip[18] = (s->remote_ip >> 8) & 0xFF;
-  ip[19] = s->remote_ip & 0xFF;
-
-  /* IP checksum */
-  uint32_t sum = 0;
-  for (int i = 0; i < 10; i++) {
-    sum += (ip[i * 2] << 8) | ip[i * 2 + 1];
+  pbuf_t p;
+  pbuf_init(&p);
+  if (data && len > 0) {
+    memcpy(pbuf_put(&p, len), data, len);
   }
-  while (sum >> 16)
-    sum = (sum & 0xFFFF) + (sum >> 16);
-  ip[10] = (~sum >> 8) & 0xFF;
-  ip[11] = ~sum & 0xFF;
 
   /* TCP header */
-  uint8_t *tcp = packet + 34;
+  uint8_t *tcp = pbuf_push(&p, 20);
+  uint16_t window = tcp_recv_window(s);
   tcp[0] = (s->local_port >> 8) & 0xFF;
   tcp[1] = s->local_port & 0xFF;
   tcp[2] = (s->remote_port >> 8) & 0xFF;
   tcp[3] = s->remote_port & 0xFF;
-  tcp[4] = (s->seq_num >> 24) & 0xFF;
-  tcp[5] = (s->seq_num >> 16) & 0xFF;
-  tcp[6] = (s->seq_num >> 8) & 0xFF;
-  tcp[7] = s->seq_num & 0xFF;
+  tcp[4] = (seq >> 24) & 0xFF;
+  tcp[5] = (seq >> 16) & 0xFF;
+  tcp[6] = (seq >> 8) & 0xFF;
+  tcp[7] = seq & 0xFF;
   tcp[8] = (s->ack_num >> 24) & 0xFF;
   tcp[9] = (s->ack_num >> 16) & 0xFF;
   tcp[10] = (s->ack_num >> 8) & 0xFF;
   tcp[11] = s->ack_num & 0xFF;
   tcp[12] = 0x50; /* Data offset: 5 (20 bytes) */
   tcp[13] = flags;
-  tcp[14] = (s->recv_window >> 8) & 0xFF;
-  tcp[15] = s->recv_window & 0xFF;
+  tcp[14] = (window >> 8) & 0xFF;
+  tcp[15] = window & 0xFF;
   tcp[16] = 0;
   tcp[17] = 0; /* Checksum */
   tcp[18] = 0;
   tcp[19] = 0; /* Urgent pointer */
 
-  /* Copy data */
-  if (data && len > 0) {
-    memcpy(tcp + 20, data, len);
-  }
-
-  /* TCP checksum */
-  uint16_t csum = tcp_checksum(our_ip, s->remote_ip, tcp, 20 + len);
+  /* TCP checksum: cached pseudo-header sum plus this segment */
+  uint32_t sum = s->csum_pseudo + net_swap16((uint16_t)(20 + len));
+  uint16_t csum = net_checksum_finish(net_checksum_partial(tcp, 20 + len, sum));
   tcp[16] = (csum >> 8) & 0xFF;
   tcp[17] = csum & 0xFF;
 
-  return net_send(packet, total_len);
+  return ip_send_pbuf(&p, s->remote_ip, 6);
+}
+
+/*
+ * Send TCP segment at the current send sequence number
+ */
+int tcp_send_segment(int sock, uint8_t flags, const uint8_t *data,
+                     uint16_t len) {
+  if (sock < 0 || sock >= MAX_TCP_SOCKETS)
+    return -1;
+
+  return tcp_output(sock, tcp_sockets[sock].seq_num, flags, data, len);
+}
+
+/* Sequence space a queued segment occupies (SYN and FIN count) */
+static uint32_t tcp_seg_space(const tcp_txseg_t *seg) {
+  return seg->len + ((seg->flags & (TCP_SYN | TCP_FIN)) ? 1 : 0);
+}
+
+/*
+ * Queue a segment on the retransmission queue and transmit it.
+ * The segment stays queued until cumulatively acknowledged; tcp_timer
+ * resends it on RTO expiry. Returns -1 if the queue is full.
+ */
+static int tcp_queue_segment(int sock, uint8_t flags, const uint8_t *data,
+                             uint16_t len) {
+  tcp_socket_t *s = &tcp_sockets[sock];
+
+  if (!s->txq)
+    return -1;
+
+  tcp_txseg_t *seg = NULL;
+  for (int i = 0; i < TCP_TX_QUEUE; i++) {
+    if (!s->txq[i].in_use) {
+      seg = &s->txq[i];
+      break;
+    }
+  }
+  if (!seg || len > TCP_MSS)
+    return -1;
+
+  seg->seq = s->seq_num;
+  seg->len = len;
+  seg->flags = flags;
+  seg->retries = 0;
+  seg->sent_tick = timer_get_ticks();
+  if (len > 0)
+    memcpy(seg->data, data, len);
+  seg->in_use = 1;
+
+  s->seq_num += tcp_seg_space(seg);
+
+  /* A failed transmit is fine - the segment is queued and the
+   * retransmission timer will resend it */
+  tcp_output(sock, seg->seq, flags, data, len);
+  return 0;
+}
+
+/*
+ * Cumulative ACK processing: drop fully acknowledged segments from
+ * the retransmission queue and advance snd_una
+ */
+static void tcp_ack_received(tcp_socket_t *s, uint32_t ack, uint16_t window) {
+  if (!s->txq)
+    return;
+  if (seq_lt(s->seq_num, ack) || seq_le(ack, s->snd_una)) {
+    /* Old or impossible ACK; still take the window update */
+    s->snd_wnd = window;
+    return;
+  }
+
+  for (int i = 0; i < TCP_TX_QUEUE; i++) {
+    tcp_txseg_t *seg = &s->txq[i];
+    if (seg->in_use && seq_le(seg->seq + tcp_seg_space(seg), ack)) {
+      seg->in_use = 0;
+    }
+  }
+
+  s->snd_una = ack;
+  s->snd_wnd = window;
+}
+
+/*
+ * In-order receive with out-of-order reassembly. Data at the expected
+ * sequence number goes straight into the receive buffer; data beyond
+ * it is parked in the out-of-order queue and spliced in once the gap
+ * fills. Every path re-ACKs so the sender sees where we are.
+ */
+static void tcp_rx_data(int sock, uint32_t seq, const uint8_t *data,
+                        uint16_t data_len) {
+  tcp_socket_t *s = &tcp_sockets[sock];
+
+  if (!s->recv_buf)
+    return;
+
+  if (seq_le(seq + data_len, s->ack_num)) {
+    /* Entirely old - duplicate of something we already have */
+    tcp_output(sock, s->seq_num, TCP_ACK, NULL, 0);
+    return;
+  }
+
+  if (seq != s->ack_num) {
+    if (seq_lt(s->ack_num, seq)) {
+      /* Future segment - park it for reassembly */
+      for (int i = 0; i < TCP_OOO_QUEUE; i++) {
+        tcp_ooseg_t *oo = &s->ooq[i];
+        if (oo->in_use && oo->seq == seq)
+          break; /* Already held */
+        if (!oo->in_use && data_len <= TCP_MSS) {
+          oo->seq = seq;
+          oo->len = data_len;
+          memcpy(oo->data, data, data_len);
+          oo->in_use = 1;
+          break;
+        }
+      }
+    }
+    /* Duplicate ACK tells the sender what we are still missing */
+    tcp_output(sock, s->seq_num, TCP_ACK, NULL, 0);
+    return;
+  }
+
+  /* In-order: grow the buffer if the connection is outrunning it,
+   * up to the cap and only while the heap has headroom */
+  uint32_t space = s->recv_cap - s->recv_len;
+  if (data_len > space && s->recv_cap < TCP_RECV_MAX) {
+    size_t heap_alloc, heap_free;
+    mm_stats(&heap_alloc, &heap_free);
+    if (heap_free > TCP_MEM_RESERVE) {
+      uint32_t new_cap = s->recv_cap * 2;
+      if (new_cap > TCP_RECV_MAX)
+        new_cap = TCP_RECV_MAX;
+      uint8_t *grown = (uint8_t *)kmalloc(new_cap);
+      if (grown) {
+        memcpy(grown, s->recv_buf, s->recv_len);
+        kfree(s->recv_buf);
+        s->recv_buf = grown;
+        s->recv_cap = new_cap;
+        space = s->recv_cap - s->recv_len;
+      }
+    }
+  }
+  uint16_t copy = (data_len < space) ? data_len : (uint16_t)space;
+  memcpy(s->recv_buf + s->recv_len, data, copy);
+  s->recv_len += copy;
+  s->ack_num += copy;
+
+  /* Splice in any parked segments the gap-fill made contiguous */
+  int progress = 1;
+  while (progress) {
+    progress = 0;
+    for (int i = 0; i < TCP_OOO_QUEUE; i++) {
+      tcp_ooseg_t *oo = &s->ooq[i];
+      if (!oo->in_use)
+        continue;
+      if (seq_le(oo->seq + oo->len, s->ack_num)) {
+        oo->in_use = 0; /* Fully covered by what we have */
+        continue;
+      }
+      if (oo->seq == s->ack_num) {
+        space = s->recv_cap - s->recv_len;
+        copy = (oo->len < space) ? oo->len : space;
+        memcpy(s->recv_buf + s->recv_len, oo->data, copy);
+        s->recv_len += copy;
+        s->ack_num += copy;
+        if (copy == oo->len) {
+          oo->in_use = 0;
+          progress = 1;
+        }
+      }
+    }
+  }
+
+  tcp_output(sock, s->seq_num, TCP_ACK, NULL, 0);
+}
+
+/*
+ * Retransmission timer - called from net_poll. Resends the oldest
+ * unacknowledged segments once their RTO expires and tears down
+ * connections that stop responding.
+ */
+void tcp_timer(void) {
+  uint32_t now = timer_get_ticks();
+
+  for (int i = 0; i < MAX_TCP_SOCKETS; i++) {
+    tcp_socket_t *s = &tcp_sockets[i];
+    if (!s->in_use || s->state == TCP_CLOSED || s->state == TCP_LISTEN ||
+        !s->txq)
+      continue;
+
+    for (int j = 0; j < TCP_TX_QUEUE; j++) {
+      tcp_txseg_t *seg = &s->txq[j];
+      if (!seg->in_use || (now - seg->sent_tick) < TCP_RTO_TICKS)
+        continue;
+
+      if (seg->retries >= TCP_MAX_RETRIES) {
+        /* Peer is gone - drop the connection */
+        s->state = TCP_CLOSED;
+        tcp_free_bufs(s);
+        break;
+      }
+
+      seg->retries++;
+      seg->sent_tick = now;
+      tcp_output(i, seg->seq, seg->flags, seg->len ? seg->data : NULL,
+                 seg->len);
+    }
+  }
 }
 
 /*
@@ -311,16 +551,21 @@ int tcp_connect(int sock, uint32_t ip, uint16_t port) {
 
   s->remote_ip = ip;
   s->remote_port = port;
+  s->csum_pseudo = net_pseudo_sum(net_get_ip(), ip, 6);
+
+  /* Connection buffers come off the heap for the socket's lifetime */
+  if (tcp_alloc_bufs(s) != 0)
+    return -1;
 
   /* Assign ephemeral port if not bound */
   if (s->local_port == 0) {
     s->local_port = 49152 + (tcp_isn % 16384);
   }
 
-  /* Send SYN */
+  /* Send SYN (queued so it is retransmitted if lost) */
   s->state = TCP_SYN_SENT;
-  tcp_send_segment(sock, TCP_SYN, NULL, 0);
-  s->seq_num++;
+  s->snd_una = s->seq_num;
+  tcp_queue_segment(sock, TCP_SYN, NULL, 0);
 
   /* Wait for SYN-ACK */
   uint32_t timeout = timer_get_ticks() + 5000;
@@ -342,8 +587,6 @@ void tcp_handle(const uint8_t *packet, size_t len, uint32_t src_ip) {
   if (len < 20)
     return;
 
-  tcp_header_t *tcp = (tcp_header_t *)packet;
-
   uint16_t src_port = (packet[0] << 8) | packet[1];
   uint16_t dst_port = (packet[2] << 8) | packet[3];
   uint32_t seq =
@@ -352,6 +595,7 @@ void tcp_handle(const uint8_t *packet, size_t len, uint32_t src_ip) {
       (packet[8] << 24) | (packet[9] << 16) | (packet[10] << 8) | packet[11];
   uint8_t flags = packet[13];
   uint8_t data_offset = (packet[12] >> 4) * 4;
+  uint16_t window = (packet[14] << 8) | packet[15];
 
   /* Find matching socket */
   int sock = -1;
@@ -381,17 +625,21 @@ void tcp_handle(const uint8_t *packet, size_t len, uint32_t src_ip) {
   switch (s->state) {
   case TCP_LISTEN:
     if (flags & TCP_SYN) {
+      if (tcp_alloc_bufs(s) != 0)
+        break; /* No memory - let the peer retry */
       s->remote_ip = src_ip;
       s->remote_port = src_port;
+      s->csum_pseudo = net_pseudo_sum(net_get_ip(), src_ip, 6);
       s->ack_num = seq + 1;
+      s->snd_una = s->seq_num;
       s->state = TCP_SYN_RCVD;
-      tcp_send_segment(sock, TCP_SYN | TCP_ACK, NULL, 0);
-      s->seq_num++;
+      tcp_queue_segment(sock, TCP_SYN | TCP_ACK, NULL, 0);
     }
     break;
 
   case TCP_SYN_SENT:
     if ((flags & (TCP_SYN | TCP_ACK)) == (TCP_SYN | TCP_ACK)) {
+      tcp_ack_received(s, ack, window);
       s->ack_num = seq + 1;
       s->state = TCP_ESTABLISHED;
       tcp_send_segment(sock, TCP_ACK, NULL, 0);
@@ -400,34 +648,36 @@ void tcp_handle(const uint8_t *packet, size_t len, uint32_t src_ip) {
 
   case TCP_SYN_RCVD:
     if (flags & TCP_ACK) {
+      tcp_ack_received(s, ack, window);
       s->state = TCP_ESTABLISHED;
     }
     break;
 
-  case TCP_ESTABLISHED:
+  case TCP_ESTABLISHED: {
+    if (flags & TCP_ACK) {
+      tcp_ack_received(s, ack, window);
+    }
+
+    uint16_t data_len = len - data_offset;
+    if (data_len > 0) {
+      tcp_rx_data(sock, seq, packet + data_offset, data_len);
+    }
+
     if (flags & TCP_FIN) {
-      s->ack_num = seq + 1;
-      s->state = TCP_CLOSE_WAIT;
-      tcp_send_segment(sock, TCP_ACK, NULL, 0);
-      /* Application should close */
-    } else if (flags & TCP_ACK) {
-      /* Handle data */
-      uint16_t data_len = len - data_offset;
-      if (data_len > 0) {
-        const uint8_t *data = packet + data_offset;
-        uint16_t copy = (data_len < sizeof(s->recv_buf) - s->recv_len)
-                            ? data_len
-                            : sizeof(s->recv_buf) - s->recv_len;
-        memcpy(s->recv_buf + s->recv_len, data, copy);
-        s->recv_len += copy;
-        s->ack_num += data_len;
+      /* Only accept the FIN once everything before it arrived */
+      if (s->ack_num == seq + data_len) {
+        s->ack_num++;
+        s->state = TCP_CLOSE_WAIT;
         tcp_send_segment(sock, TCP_ACK, NULL, 0);
+        /* Application should close */
       }
     }
     break;
+  }
 
   case TCP_FIN_WAIT1:
     if (flags & TCP_ACK) {
+      tcp_ack_received(s, ack, window);
       s->state = TCP_FIN_WAIT2;
     }
     if (flags & TCP_FIN) {
@@ -452,6 +702,7 @@ void tcp_handle(const uint8_t *packet, size_t len, uint32_t src_ip) {
   case TCP_LAST_ACK:
     if (flags & TCP_ACK) {
       s->state = TCP_CLOSED;
+      tcp_free_bufs(s);
       s->in_use = 0;
     }
     break;
@@ -470,11 +721,29 @@ int tcp_send(int sock, const uint8_t *data, uint16_t len) {
   if (s->state != TCP_ESTABLISHED)
     return -1;
 
-  int ret = tcp_send_segment(sock, TCP_ACK | TCP_PSH, data, len);
-  if (ret == 0) {
-    s->seq_num += len;
+  /* Sliding window: keep at most snd_wnd bytes in flight, chopping
+   * the data into MSS-sized queued segments. When the window or the
+   * retransmission queue is full, poll for ACKs to open it up. */
+  uint16_t sent = 0;
+  uint32_t deadline = timer_get_ticks() + 5000;
+
+  while (sent < len) {
+    uint16_t chunk = len - sent;
+    if (chunk > TCP_MSS)
+      chunk = TCP_MSS;
+
+    uint32_t in_flight = s->seq_num - s->snd_una;
+    if (in_flight + chunk > s->snd_wnd ||
+        tcp_queue_segment(sock, TCP_ACK | TCP_PSH, data + sent, chunk) != 0) {
+      if (timer_get_ticks() > deadline || s->state != TCP_ESTABLISHED)
+        break;
+      net_poll();
+      continue;
+    }
+    sent += chunk;
   }
-  return ret == 0 ? len : -1;
+
+  return sent > 0 ? sent : -1;
 }
 
 /*
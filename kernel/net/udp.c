@@ -66,28 +66,29 @@ int udp_send(int sock, uint32_t dest_ip, uint16_t dest_port,
     return -1;
   }
 
-  if (len > 1472)
-    return -1; /* Too large */
+  if (len > PBUF_MAX - PBUF_HEADROOM)
+    return -1; /* Larger than the pbuf payload capacity */
 
-  uint8_t udp_packet[1480];
   uint16_t src_port = udp_sockets[sock].local_port;
 
-  /* UDP header */
-  udp_packet[0] = (src_port >> 8) & 0xFF;
-  udp_packet[1] = src_port & 0xFF;
-  udp_packet[2] = (dest_port >> 8) & 0xFF;
-  udp_packet[3] = dest_port & 0xFF;
+  /* Payload goes into the pbuf once; the UDP, IP and ethernet
+   * headers are prepended in place */
+  pbuf_t p;
+  pbuf_init(&p);
+  memcpy(pbuf_put(&p, len), data, len);
 
   uint16_t udp_len = 8 + len;
-  udp_packet[4] = (udp_len >> 8) & 0xFF;
-  udp_packet[5] = udp_len & 0xFF;
-  udp_packet[6] = 0; /* Checksum (optional for IPv4) */
-  udp_packet[7] = 0;
-
-  /* Copy data */
-  memcpy(udp_packet + 8, data, len);
-
-  return ip_send(dest_ip, 17, udp_packet, udp_len);
+  uint8_t *udp = pbuf_push(&p, 8);
+  udp[0] = (src_port >> 8) & 0xFF;
+  udp[1] = src_port & 0xFF;
+  udp[2] = (dest_port >> 8) & 0xFF;
+  udp[3] = dest_port & 0xFF;
+  udp[4] = (udp_len >> 8) & 0xFF;
+  udp[5] = udp_len & 0xFF;
+  udp[6] = 0; /* Checksum (optional for IPv4) */
+  udp[7] = 0;
+
+  return ip_send_pbuf(&p, dest_ip, 17);
 }
 
 /*
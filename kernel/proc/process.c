@@ -17,13 +17,15 @@ static uint32_t next_pid = 1;
 process_t *current_process = NULL;
 static process_t *idle_process = NULL;
 
-/* Ready queue (simple linked list) */
-static process_t *ready_queue_head = NULL;
-static process_t *ready_queue_tail = NULL;
+/* Multi-level ready queues: one FIFO per priority, plus a bitmap of
+ * non-empty levels so pick-next is a single find-first-set. */
+static process_t *ready_head[SCHED_LEVELS];
+static process_t *ready_tail[SCHED_LEVELS];
+static uint32_t ready_bitmap = 0;
 
-/* Kernel stacks for processes */
-static uint8_t proc_stacks[MAX_PROCESSES][PROC_STACK_SIZE]
-    __attribute__((aligned(16)));
+/* Idle/kernel process keeps a static stack; every other process gets
+ * a demand-paged slot in the PROC_VSTACK region (see process.h). */
+static uint8_t idle_stack[PROC_STACK_SIZE] __attribute__((aligned(16)));
 
 /*
  * Initialize process subsystem
@@ -41,7 +43,7 @@ void proc_init(void) {
   idle_process->ppid = 0;
   idle_process->state = PROC_RUNNING;
   idle_process->priority = 0;
-  idle_process->stack_bottom = (uint32_t)&proc_stacks[0][PROC_STACK_SIZE];
+  idle_process->stack_bottom = (uint32_t)&idle_stack[PROC_STACK_SIZE];
   idle_process->esp = idle_process->stack_bottom;
   strcpy(idle_process->name, "kernel");
   idle_process->next = NULL;
@@ -80,13 +82,14 @@ process_t *proc_create(const char *name, void (*entry)(void)) {
   proc->priority = 1;
   proc->time_slice = 10; /* 10 timer ticks */
   proc->total_time = 0;
-  proc->page_dir = 0; /* Use kernel page directory for now */
+  proc->page_dir = paging_new_directory();
 
   strncpy(proc->name, name, 31);
   proc->name[31] = '\0';
 
-  /* Set up stack */
-  proc->stack_bottom = (uint32_t)&proc_stacks[index][PROC_STACK_SIZE];
+  /* Set up stack: the slot is demand-paged, so writing the initial
+   * frame below faults the top page in through the page-fault handler */
+  proc->stack_bottom = PROC_VSTACK_BASE + (index + 1) * PROC_VSTACK_SLOT;
   uint32_t *stack = (uint32_t *)proc->stack_bottom;
 
   /* Push initial context onto stack */
@@ -158,45 +161,44 @@ uint32_t proc_get_pid(void) {
 }
 
 /*
- * Add process to ready queue
+ * Add process to the ready queue for its priority - O(1)
  */
 void scheduler_add(process_t *proc) {
-  proc->next = NULL;
+  int level = proc->priority % SCHED_LEVELS;
 
-  if (!ready_queue_head) {
-    ready_queue_head = proc;
-    ready_queue_tail = proc;
-  } else {
-    ready_queue_tail->next = proc;
-    ready_queue_tail = proc;
-  }
+  proc->ready_since = timer_get_ticks();
+  proc->next = NULL;
+  proc->prev = ready_tail[level];
+  if (ready_tail[level])
+    ready_tail[level]->next = proc;
+  else
+    ready_head[level] = proc;
+  ready_tail[level] = proc;
+  ready_bitmap |= (1u << level);
 }
 
 /*
- * Remove process from ready queue
+ * Unlink process from its ready queue - O(1)
  */
 void scheduler_remove(process_t *proc) {
-  process_t *prev = NULL;
-  process_t *curr = ready_queue_head;
-
-  while (curr) {
-    if (curr == proc) {
-      if (prev) {
-        prev->next = curr->next;
-      } else {
-        ready_queue_head = curr->next;
-      }
+  int level = proc->priority % SCHED_LEVELS;
 
-      if (curr == ready_queue_tail) {
-        ready_queue_tail = prev;
-      }
+  if (proc->prev)
+    proc->prev->next = proc->next;
+  else if (ready_head[level] == proc)
+    ready_head[level] = proc->next;
+  else
+    return; /* not queued */
 
-      curr->next = NULL;
-      return;
-    }
-    prev = curr;
-    curr = curr->next;
-  }
+  if (proc->next)
+    proc->next->prev = proc->prev;
+  else if (ready_tail[level] == proc)
+    ready_tail[level] = proc->prev;
+
+  proc->next = NULL;
+  proc->prev = NULL;
+  if (!ready_head[level])
+    ready_bitmap &= ~(1u << level);
 }
 
 /*
@@ -205,15 +207,19 @@ void scheduler_remove(process_t *proc) {
 void schedule(void) {
   process_t *next = NULL;
 
-  /* Find next ready process */
-  if (ready_queue_head) {
-    next = ready_queue_head;
-    ready_queue_head = next->next;
-
-    if (!ready_queue_head) {
-      ready_queue_tail = NULL;
+  /* Highest-priority non-empty level via find-first-set */
+  if (ready_bitmap) {
+    int level = __builtin_ctz(ready_bitmap);
+    next = ready_head[level];
+    ready_head[level] = next->next;
+    if (ready_head[level])
+      ready_head[level]->prev = NULL;
+    else {
+      ready_tail[level] = NULL;
+      ready_bitmap &= ~(1u << level);
     }
     next->next = NULL;
+    next->prev = NULL;
   }
 
   /* If no ready process, run idle */
@@ -232,22 +238,124 @@ void schedule(void) {
     scheduler_add(current_process);
   }
 
+  /* Charge the outgoing process its exact cycles and credit the
+   * incoming one's dispatch and run-queue wait */
+  static uint64_t last_dispatch_tsc = 0;
+  uint64_t now_tsc = rdtsc();
+  if (current_process && last_dispatch_tsc)
+    current_process->cycles += now_tsc - last_dispatch_tsc;
+  last_dispatch_tsc = now_tsc;
+  next->ctx_switches++;
+  if (next != idle_process)
+    next->wait_ticks += timer_get_ticks() - next->ready_since;
+
+  KTRACE(KTRACE_SCHED, KT_EV_SWITCH, next->pid);
+
   /* Switch to new process */
   process_t *old = current_process;
   current_process = next;
   current_process->state = PROC_RUNNING;
 
+  /* Switch address space if the target has its own directory */
+  if (next->page_dir) {
+    asm volatile("mov %0, %%cr3" : : "r"(next->page_dir));
+  }
+
   /* Perform context switch */
   if (old) {
     switch_context(&old->esp, next->esp);
   }
 }
 
+/* Sleeping processes, sorted by wake_tick (chained via next) */
+static process_t *sleep_head = NULL;
+
+/*
+ * Whether the caller is a process that may leave the CPU
+ */
+int proc_can_block(void) {
+  return current_process != NULL && current_process != idle_process;
+}
+
+/*
+ * Sleep for at least ms milliseconds. The process leaves the ready
+ * queue entirely; the timer IRQ wakes it by deadline. Falls back to a
+ * hlt spin when no scheduler is running (early boot, idle).
+ */
+void proc_sleep(uint32_t ms) {
+  uint32_t wake = timer_get_ticks() + ms / 10 + 1; /* 100Hz ticks */
+
+  if (!proc_can_block()) {
+    while (timer_get_ticks() < wake) {
+      asm volatile("hlt");
+    }
+    return;
+  }
+
+  current_process->wake_tick = wake;
+  current_process->state = PROC_BLOCKED;
+
+  /* Sorted insert so the timer only ever looks at the head */
+  process_t **pp = &sleep_head;
+  while (*pp && (*pp)->wake_tick <= wake)
+    pp = &(*pp)->next;
+  current_process->next = *pp;
+  *pp = current_process;
+
+  schedule();
+}
+
+/*
+ * Block the current process on a wait queue
+ */
+void wait_on(wait_queue_t *wq) {
+  if (!proc_can_block())
+    return;
+  current_process->state = PROC_BLOCKED;
+  current_process->next = wq->head;
+  wq->head = current_process;
+  schedule();
+}
+
 /*
- * Timer interrupt handler - preemptive scheduling
+ * Make every process on the queue runnable again
  */
-static void timer_handler(interrupt_frame_t *frame) {
-  (void)frame;
+void wake_up(wait_queue_t *wq) {
+  while (wq->head) {
+    process_t *p = wq->head;
+    wq->head = p->next;
+    p->next = NULL;
+    p->state = PROC_READY;
+    scheduler_add(p);
+  }
+}
+
+/*
+ * Keyboard wait hook: sleep a tick, then let the caller poll again.
+ * Keeps the CPU free between key polls without requiring IRQ1.
+ */
+static void kb_wait(void) { proc_sleep(10); }
+
+/*
+ * Timer interrupt handler - preemptive scheduling and sleep wakeups
+ */
+static void sched_timer_handler(interrupt_frame_t *frame) {
+  /* Drive the tick counter (the PIT driver's handler is not hooked
+   * separately once the scheduler owns IRQ0) */
+  timer_handler();
+
+  /* Feed the sampling profiler the interrupted EIP */
+  profile_sample(frame->eip);
+
+  /* Wake sleepers whose deadline has passed */
+  uint32_t now = timer_get_ticks();
+  while (sleep_head && sleep_head->wake_tick <= now) {
+    process_t *p = sleep_head;
+    sleep_head = p->next;
+    p->next = NULL;
+    p->state = PROC_READY;
+    scheduler_add(p);
+  }
 
   /* Decrement time slice */
   if (current_process && current_process->time_slice > 0) {
@@ -262,12 +370,72 @@ static void timer_handler(interrupt_frame_t *frame) {
   }
 }
 
+/*
+ * top - live per-process CPU view, refreshed in place until a key
+ * is pressed. CPU% is computed from TSC cycle deltas between
+ * refreshes (scaled to 32 bits to avoid 64-bit division).
+ */
+void cmd_top(const char *args) {
+  (void)args;
+  static uint64_t prev_cycles[MAX_PROCESSES];
+  static uint64_t prev_irq;
+
+  for (;;) {
+    uint32_t deltas[MAX_PROCESSES];
+    uint32_t total = 0;
+
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+      if (proc_table[i].state == PROC_UNUSED) {
+        deltas[i] = 0;
+        continue;
+      }
+      deltas[i] = (uint32_t)((proc_table[i].cycles - prev_cycles[i]) >> 10);
+      prev_cycles[i] = proc_table[i].cycles;
+      total += deltas[i];
+    }
+    uint32_t irq_delta = (uint32_t)((irq_get_cycles() - prev_irq) >> 10);
+    prev_irq = irq_get_cycles();
+    total += irq_delta;
+    if (total == 0)
+      total = 1;
+
+    vga_clear();
+    kprintf("top - up %d s, %d processes\n\n", timer_get_uptime(),
+            MAX_PROCESSES);
+    kprintf("  PID  STATE    CPU%%  CSW     WAIT   NAME\n");
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+      process_t *p = &proc_table[i];
+      if (p->state == PROC_UNUSED && p->pid == 0 && i != 0)
+        continue;
+      static const char *states[] = {"unused", "new",  "ready",
+                                     "run",    "block", "zombie"};
+      kprintf("  %d    %s    %d     %d    %d    %s\n", p->pid,
+              states[p->state], deltas[i] * 100 / total, p->ctx_switches,
+              p->wait_ticks, p->name);
+    }
+    kprintf("  irq            %d%%\n", irq_delta * 100 / total);
+    kprintf("\n(q to quit)\n");
+
+    /* Refresh every second; bail out on any key */
+    for (int t = 0; t < 100; t++) {
+      char c = keyboard_getchar_nonblocking();
+      if (c == 'q' || c == 'Q')
+        return;
+      timer_delay_ms(10);
+    }
+  }
+}
+
 /*
  * Initialize scheduler
  */
 void scheduler_init(void) {
   /* Register timer interrupt handler */
-  isr_register_handler(IRQ0, timer_handler);
+  isr_register_handler(IRQ0, sched_timer_handler);
+
+  /* Route busy-wait loops in the drivers to blocking sleeps */
+  timer_set_block_hook(proc_sleep);
+  keyboard_set_wait_hook(kb_wait);
 
   kprintf("  [OK] Scheduler (10ms quantum)\n");
 }
@@ -23,6 +23,12 @@
 /* Stack size per process */
 #define PROC_STACK_SIZE 4096
 
+/* Demand-paged stack region: each process gets a virtual slot whose
+ * pages are faulted in on first touch. The lowest page of every slot
+ * stays unmapped as an overflow guard. */
+#define PROC_VSTACK_BASE 0x00C00000
+#define PROC_VSTACK_SLOT 0x4000
+
 /* Task Control Block */
 typedef struct process {
   uint32_t pid;  /* Process ID */
@@ -44,17 +50,39 @@ typedef struct process {
   /* Scheduling */
   uint32_t time_slice; /* Remaining time slice */
   uint32_t total_time; /* Total CPU time used */
+  uint32_t wake_tick;  /* Deadline while sleeping */
+
+  /* Cycle accounting (read at every context switch) */
+  uint64_t cycles;       /* TSC cycles consumed */
+  uint32_t ctx_switches; /* Times dispatched */
+  uint32_t ready_since;  /* Tick when last made runnable */
+  uint32_t wait_ticks;   /* Ticks spent runnable but not running */
 
   /* Name */
   char name[32];
 
-  /* Linked list for scheduler */
+  /* Ready-queue links (doubly linked for O(1) removal) */
   struct process *next;
+  struct process *prev;
 } process_t;
 
+/* Ready-queue priority levels (0 = highest) */
+#define SCHED_LEVELS 8
+
 /* Current running process */
 extern process_t *current_process;
 
+/* Wait queue: blocked processes chained via their next links */
+typedef struct {
+  process_t *head;
+} wait_queue_t;
+
+/* Blocking primitives */
+int proc_can_block(void);
+void proc_sleep(uint32_t ms);
+void wait_on(wait_queue_t *wq);
+void wake_up(wait_queue_t *wq);
+
 /* Process functions */
 void proc_init(void);
 process_t *proc_create(const char *name, void (*entry)(void));
@@ -64,6 +92,11 @@ void proc_exit(int status);
 process_t *proc_get_current(void);
 uint32_t proc_get_pid(void);
 
+/* Deferred work queue (proc/workqueue.c) */
+typedef void (*work_fn_t)(void *arg);
+void workqueue_init(void);
+int work_enqueue(work_fn_t fn, void *arg);
+
 /* Scheduler functions */
 void scheduler_init(void);
 void scheduler_add(process_t *proc);
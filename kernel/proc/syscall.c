@@ -21,6 +21,7 @@
 #define SYS_YIELD 8
 #define SYS_SLEEP 9
 #define SYS_PS 10
+#define SYS_TIMEPAGE 11 /* Address of the vsyscall timekeeping page */
 
 /* Maximum syscalls */
 #define MAX_SYSCALLS 32
@@ -82,6 +83,16 @@ static int sys_read(uint32_t fd, uint32_t buf, uint32_t count) {
   return -1;
 }
 
+static int sys_timepage(uint32_t unused1, uint32_t unused2,
+                        uint32_t unused3) {
+  (void)unused1;
+  (void)unused2;
+  (void)unused3;
+  /* Identity-mapped; programs read ticks and TSC calibration from
+   * the page directly, no kernel entry needed afterwards */
+  return (int)(uint32_t)vsyscall_page_addr();
+}
+
 static int sys_ps(uint32_t unused1, uint32_t unused2, uint32_t unused3) {
   (void)unused1;
   (void)unused2;
@@ -100,6 +111,8 @@ static void syscall_handler(interrupt_frame_t *frame) {
   uint32_t arg2 = frame->ecx;
   uint32_t arg3 = frame->edx;
 
+  KTRACE(KTRACE_SYSCALL, KT_EV_SYSCALL, syscall_num);
+
   if (syscall_num >= MAX_SYSCALLS || !syscall_table[syscall_num]) {
     frame->eax = -1; /* Invalid syscall */
     return;
@@ -109,6 +122,51 @@ static void syscall_handler(interrupt_frame_t *frame) {
   frame->eax = syscall_table[syscall_num](arg1, arg2, arg3);
 }
 
+/*
+ * Fast syscall path (SYSENTER). The assembly stub pushes the number
+ * and args and SYSEXITs back; this is the whole kernel side, so a
+ * getpid costs a dispatch through the same table minus the INT/IRET
+ * and frame save of the interrupt path.
+ */
+int sysenter_dispatch(uint32_t num, uint32_t arg1, uint32_t arg2,
+                      uint32_t arg3) {
+  KTRACE(KTRACE_SYSCALL, KT_EV_SYSCALL, num);
+
+  if (num >= MAX_SYSCALLS || !syscall_table[num])
+    return -1;
+  return syscall_table[num](arg1, arg2, arg3);
+}
+
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+extern void sysenter_entry(void); /* isr.asm */
+
+static uint8_t sysenter_stack[4096] __attribute__((aligned(16)));
+
+static void wrmsr(uint32_t msr, uint32_t lo, uint32_t hi) {
+  asm volatile("wrmsr" : : "c"(msr), "a"(lo), "d"(hi));
+}
+
+/*
+ * Program the SYSENTER MSRs when the CPU supports them. Called from
+ * syscall_init; INT 0x80 stays available either way.
+ */
+static void syscall_fast_init(void) {
+  if (!cpu_has_sep()) {
+    kprintf("  [--] SYSENTER not supported, INT 0x80 only\n");
+    return;
+  }
+
+  wrmsr(MSR_SYSENTER_CS, 0x08, 0); /* Kernel code segment */
+  wrmsr(MSR_SYSENTER_ESP,
+        (uint32_t)(sysenter_stack + sizeof(sysenter_stack)), 0);
+  wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry, 0);
+
+  kprintf("  [OK] Fast syscalls (SYSENTER)\n");
+}
+
 /*
  * Initialize syscall subsystem
  */
@@ -125,9 +183,12 @@ void syscall_init(void) {
   syscall_table[SYS_GETPID] = sys_getpid;
   syscall_table[SYS_YIELD] = sys_yield;
   syscall_table[SYS_PS] = sys_ps;
+  syscall_table[SYS_TIMEPAGE] = sys_timepage;
 
   /* Register INT 0x80 handler */
   isr_register_handler(0x80, syscall_handler);
 
   kprintf("  [OK] Syscalls (INT 0x80)\n");
+
+  syscall_fast_init();
 }
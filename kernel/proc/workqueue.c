@@ -0,0 +1,113 @@
+/*
+ * NanoSec OS - Deferred Work Queue (bottom halves)
+ * ==================================================
+ * IRQ handlers enqueue small work items into a fixed ring; a kernel
+ * worker process drains them with interrupts enabled. This keeps
+ * interrupt latency decoupled from protocol processing: an ISR only
+ * queues, it never runs the network stack itself.
+ */
+
+#include "process.h"
+#include "../kernel.h"
+
+#define WORK_RING_SIZE 64
+
+typedef struct {
+  work_fn_t fn;
+  void *arg;
+} work_item_t;
+
+static work_item_t work_ring[WORK_RING_SIZE];
+static volatile uint32_t work_head = 0; /* next item to run */
+static volatile uint32_t work_tail = 0; /* next free slot */
+
+static process_t *worker_proc = NULL;
+static volatile int worker_waiting = 0;
+
+/* Save EFLAGS and disable interrupts; ring indices are shared with
+ * IRQ context */
+static uint32_t work_lock(void) {
+  uint32_t flags;
+  asm volatile("pushf; pop %0; cli" : "=r"(flags));
+  return flags;
+}
+
+static void work_unlock(uint32_t flags) {
+  if (flags & 0x200)
+    asm volatile("sti");
+}
+
+/*
+ * Queue a work item. Safe from interrupt handlers. Returns -1 when
+ * the ring is full (the item is dropped; callers should treat this
+ * like a dropped packet).
+ */
+int work_enqueue(work_fn_t fn, void *arg) {
+  uint32_t flags = work_lock();
+  uint32_t next = (work_tail + 1) % WORK_RING_SIZE;
+
+  if (next == work_head) {
+    work_unlock(flags);
+    return -1;
+  }
+  work_ring[work_tail].fn = fn;
+  work_ring[work_tail].arg = arg;
+  work_tail = next;
+
+  /* Kick the worker if it went to sleep on an empty ring */
+  if (worker_waiting && worker_proc && worker_proc->state == PROC_BLOCKED) {
+    worker_waiting = 0;
+    worker_proc->state = PROC_READY;
+    scheduler_add(worker_proc);
+  }
+  work_unlock(flags);
+  return 0;
+}
+
+static int work_dequeue(work_item_t *item) {
+  uint32_t flags = work_lock();
+  if (work_head == work_tail) {
+    work_unlock(flags);
+    return 0;
+  }
+  *item = work_ring[work_head];
+  work_head = (work_head + 1) % WORK_RING_SIZE;
+  work_unlock(flags);
+  return 1;
+}
+
+/*
+ * Worker process: drain the ring, then block until work_enqueue
+ * wakes us. The waiting flag is set before blocking with interrupts
+ * briefly disabled, so an enqueue between the empty check and the
+ * context switch still makes the worker runnable.
+ */
+static void worker_entry(void) {
+  work_item_t item;
+
+  for (;;) {
+    while (work_dequeue(&item)) {
+      item.fn(item.arg);
+    }
+
+    asm volatile("cli");
+    if (work_head == work_tail) {
+      worker_waiting = 1;
+      worker_proc->state = PROC_BLOCKED;
+      asm volatile("sti");
+      schedule();
+    } else {
+      asm volatile("sti");
+    }
+  }
+}
+
+/*
+ * Create the kernel worker process
+ */
+void workqueue_init(void) {
+  worker_proc = proc_create("kworker", worker_entry);
+  if (worker_proc) {
+    kprintf("  [OK] Work Queue (kworker pid %d)\n", worker_proc->pid);
+  }
+}
@@ -5,10 +5,21 @@
  */
 
 #include "../kernel.h"
+#include "../proc/process.h"
 
-/* Audit log */
+/*
+ * Audit log: a staging ring on the dispatch path, flushed to
+ * /var/log/audit in batches off the latency path.  audit_log_cmd
+ * only stamps and copies into the ring; the write-behind lands in
+ * the deferred-work worker (or inline at high water if the worker
+ * has not drained it), uses fs_append so a batch costs one extent
+ * append instead of a whole-file rewrite, and `audit sync` plus the
+ * panic path flush whatever is still staged.
+ */
 #define AUDIT_LOG_SIZE 128
 #define AUDIT_MSG_LEN 64
+#define AUDIT_FLUSH_BATCH 16 /* Queue a flush after this many */
+#define AUDIT_HIGH_WATER 96  /* Flush inline before overwrite */
 
 typedef struct {
   uint32_t timestamp;
@@ -17,8 +28,10 @@ typedef struct {
 } audit_entry_t;
 
 static audit_entry_t audit_log[AUDIT_LOG_SIZE];
-static int audit_head = 0;
-static int audit_count = 0;
+static uint32_t audit_seq = 0;    /* Records ever staged (free-running) */
+static uint32_t flushed_seq = 0;  /* Records written to /var/log/audit */
+static volatile int flush_pending = 0;
+static int audit_fd = -1;
 
 /* Sudo state */
 static int sudo_active = 0;
@@ -62,30 +75,101 @@ uint32_t password_hash(const char *password) {
  */
 void audit_init(void) {
   memset(audit_log, 0, sizeof(audit_log));
-  audit_head = 0;
-  audit_count = 0;
+  audit_seq = 0;
+  flushed_seq = 0;
+  flush_pending = 0;
+  audit_fd = -1;
+}
+
+/* One record as a text line: "ticks uid command\n" */
+static int audit_format(char *dst, const audit_entry_t *e) {
+  int n = 0;
+  n += fmt_uint(dst + n, 12, e->timestamp, 10, 0, ' ');
+  dst[n++] = ' ';
+  n += fmt_uint(dst + n, 6, e->uid, 10, 0, ' ');
+  dst[n++] = ' ';
+  for (const char *p = e->command; *p; p++)
+    dst[n++] = *p;
+  dst[n++] = '\n';
+  return n;
 }
 
 /*
- * Log command to audit trail
+ * Write everything staged since the last flush to /var/log/audit,
+ * batching records into one fs_append per buffer-full.
+ */
+void audit_sync(void) {
+  flush_pending = 0;
+
+  if (flushed_seq == audit_seq)
+    return;
+
+  if (audit_fd < 0) {
+    audit_fd = fs_open("/var/log/audit", FS_O_CREATE);
+    if (audit_fd < 0)
+      return; /* Filesystem not up yet; ring keeps staging */
+  }
+
+  /* Anything already overwritten in the ring is gone */
+  if (audit_seq - flushed_seq > AUDIT_LOG_SIZE)
+    flushed_seq = audit_seq - AUDIT_LOG_SIZE;
+
+  char buf[512];
+  int n = 0;
+  while (flushed_seq < audit_seq) {
+    if (n > (int)sizeof(buf) - (AUDIT_MSG_LEN + 24)) {
+      fs_append(audit_fd, buf, n);
+      n = 0;
+    }
+    n += audit_format(buf + n, &audit_log[flushed_seq % AUDIT_LOG_SIZE]);
+    flushed_seq++;
+  }
+  if (n > 0)
+    fs_append(audit_fd, buf, n);
+}
+
+static void audit_flush_work(void *arg) {
+  (void)arg;
+  audit_sync();
+}
+
+/*
+ * Log command to audit trail - ring store only, no I/O
  */
 void audit_log_cmd(const char *command) {
-  audit_entry_t *entry = &audit_log[audit_head];
+  audit_entry_t *entry = &audit_log[audit_seq % AUDIT_LOG_SIZE];
 
   entry->timestamp = timer_get_ticks();
   entry->uid = user_get_uid();
   strncpy(entry->command, command, AUDIT_MSG_LEN - 1);
   entry->command[AUDIT_MSG_LEN - 1] = '\0';
+  audit_seq++;
+
+  uint32_t staged = audit_seq - flushed_seq;
+  if (staged >= AUDIT_FLUSH_BATCH && !flush_pending) {
+    flush_pending = 1;
+    work_enqueue(audit_flush_work, NULL);
+  }
 
-  audit_head = (audit_head + 1) % AUDIT_LOG_SIZE;
-  if (audit_count < AUDIT_LOG_SIZE)
-    audit_count++;
+  /* The worker has not drained us - flush inline rather than start
+   * overwriting unflushed records */
+  if (staged >= AUDIT_HIGH_WATER)
+    audit_sync();
 }
 
 /*
  * Show audit log
+ * Usage: audit [n]     - last n staged records (default 20)
+ *        audit sync    - flush staging ring to /var/log/audit
  */
 void cmd_audit(const char *args) {
+  if (strcmp(args, "sync") == 0) {
+    audit_sync();
+    kprintf("audit: synced to /var/log/audit (%d records total)\n",
+            flushed_seq);
+    return;
+  }
+
   int count = 20; /* Default */
 
   if (args[0]) {
@@ -102,25 +186,23 @@ void cmd_audit(const char *args) {
     return;
   }
 
+  if (count > (int)audit_seq)
+    count = (int)audit_seq;
+  if (count > AUDIT_LOG_SIZE)
+    count = AUDIT_LOG_SIZE;
+
   kprintf("\n=== Audit Log ===\n");
   kprintf("Time       UID  Command\n");
   kprintf("---------- ---- --------\n");
 
-  int start = audit_head - count;
-  if (start < 0)
-    start = 0;
-  if (count > audit_count)
-    count = audit_count;
-
-  for (int i = 0; i < count; i++) {
-    int idx = (audit_head - count + i + AUDIT_LOG_SIZE) % AUDIT_LOG_SIZE;
-    audit_entry_t *e = &audit_log[idx];
+  for (uint32_t seq = audit_seq - count; seq < audit_seq; seq++) {
+    audit_entry_t *e = &audit_log[seq % AUDIT_LOG_SIZE];
 
     if (e->command[0]) {
       kprintf("%10d %4d %s\n", e->timestamp, e->uid, e->command);
     }
   }
-  kprintf("\n");
+  kprintf("(%d staged, %d on disk)\n\n", audit_seq - flushed_seq, flushed_seq);
 }
 
 /* ============ Sudo ============ */
@@ -1,54 +1,130 @@
-/*
- * NanoSec OS - Kernel Firewall
- */
-
-#include "../kernel.h"
-
-#define MAX_BLOCKED_IPS 64
-
-static uint32_t blocked_ips[MAX_BLOCKED_IPS];
-static int num_blocked = 0;
-static int firewall_enabled = 1;
-
-static struct {
-  uint32_t packets_allowed;
-  uint32_t packets_denied;
-} fw_stats;
-
-int firewall_init(void) {
-  num_blocked = 0;
-  fw_stats.packets_allowed = 0;
-  fw_stats.packets_denied = 0;
-  firewall_enabled = 1;
-  return 0;
-}
-
-void firewall_block_ip(uint32_t ip) {
-  if (num_blocked < MAX_BLOCKED_IPS) {
-    blocked_ips[num_blocked++] = ip;
-  }
-}
-
-int firewall_check_packet(void *packet, size_t len) {
-  (void)packet;
-  (void)len;
-
-  if (!firewall_enabled) {
-    fw_stats.packets_allowed++;
-    return 1;
-  }
-
-  /* Simplified: just count */
-  fw_stats.packets_allowed++;
-  return 1;
-}
-
-void firewall_status(void) {
-  kprintf("\n=== Firewall Status ===\n");
-  kprintf("Status: %s\n", firewall_enabled ? "ENABLED" : "DISABLED");
-  kprintf("Blocked IPs: %d\n", num_blocked);
-  kprintf("Packets allowed: %d\n", (int)fw_stats.packets_allowed);
-  kprintf("Packets denied: %d\n", (int)fw_stats.packets_denied);
-}
-
-void firewall_enable(int enable) { firewall_enabled = enable; }
+/*
+ * NanoSec OS - Kernel Firewall
+ */
+
+#include "../kernel.h"
+
+/*
+ * Blocklist: open-addressing hash table, sized for imported threat
+ * feeds rather than a handful of hand-entered addresses. A /16
+ * presence bitmap sits in front of it so the common case - a source
+ * prefix with no blocked entries at all - is a single bit test.
+ */
+#define FW_HASH_SIZE 4096 /* Power of two */
+#define FW_MAX_LOAD (FW_HASH_SIZE * 3 / 4)
+
+typedef struct {
+  uint32_t ip; /* 0 = empty slot (0.0.0.0 cannot be blocked) */
+  uint32_t hits;
+} fw_entry_t;
+
+static fw_entry_t fw_blocked[FW_HASH_SIZE];
+static uint32_t fw_prefix_map[65536 / 32]; /* One bit per /16 */
+static int num_blocked = 0;
+static int firewall_enabled = 1;
+
+static struct {
+  uint32_t packets_allowed;
+  uint32_t packets_denied;
+} fw_stats;
+
+static inline uint32_t fw_hash(uint32_t ip) {
+  return (ip * 2654435761u) >> 20; /* Top 12 bits -> 4096 slots */
+}
+
+static inline int fw_prefix_test(uint32_t ip) {
+  uint32_t prefix = ip >> 16;
+  return (fw_prefix_map[prefix >> 5] >> (prefix & 31)) & 1;
+}
+
+int firewall_init(void) {
+  memset(fw_blocked, 0, sizeof(fw_blocked));
+  memset(fw_prefix_map, 0, sizeof(fw_prefix_map));
+  num_blocked = 0;
+  fw_stats.packets_allowed = 0;
+  fw_stats.packets_denied = 0;
+  firewall_enabled = 1;
+  return 0;
+}
+
+void firewall_block_ip(uint32_t ip) {
+  if (ip == 0 || num_blocked >= FW_MAX_LOAD)
+    return;
+
+  uint32_t slot = fw_hash(ip);
+  while (fw_blocked[slot].ip != 0) {
+    if (fw_blocked[slot].ip == ip)
+      return; /* Already blocked */
+    slot = (slot + 1) & (FW_HASH_SIZE - 1);
+  }
+
+  fw_blocked[slot].ip = ip;
+  fw_blocked[slot].hits = 0;
+  num_blocked++;
+
+  uint32_t prefix = ip >> 16;
+  fw_prefix_map[prefix >> 5] |= 1u << (prefix & 31);
+}
+
+/*
+ * Fast-path membership test. Returns 1 if traffic from this source
+ * is allowed. Called per received IP packet.
+ */
+int firewall_check_ip(uint32_t src_ip) {
+  if (!firewall_enabled) {
+    fw_stats.packets_allowed++;
+    return 1;
+  }
+
+  /* First stage: nothing blocked in this /16 */
+  if (!fw_prefix_test(src_ip)) {
+    fw_stats.packets_allowed++;
+    return 1;
+  }
+
+  uint32_t slot = fw_hash(src_ip);
+  while (fw_blocked[slot].ip != 0) {
+    if (fw_blocked[slot].ip == src_ip) {
+      fw_blocked[slot].hits++;
+      fw_stats.packets_denied++;
+      return 0;
+    }
+    slot = (slot + 1) & (FW_HASH_SIZE - 1);
+  }
+
+  fw_stats.packets_allowed++;
+  return 1;
+}
+
+int firewall_check_packet(void *packet, size_t len) {
+  if (len < 20)
+    return 0;
+
+  /* IPv4 source address at offset 12 */
+  const uint8_t *p = (const uint8_t *)packet;
+  uint32_t src_ip = ((uint32_t)p[12] << 24) | ((uint32_t)p[13] << 16) |
+                    ((uint32_t)p[14] << 8) | p[15];
+
+  return firewall_check_ip(src_ip);
+}
+
+void firewall_status(void) {
+  kprintf("\n=== Firewall Status ===\n");
+  kprintf("Status: %s\n", firewall_enabled ? "ENABLED" : "DISABLED");
+  kprintf("Blocked IPs: %d\n", num_blocked);
+  kprintf("Packets allowed: %d\n", (int)fw_stats.packets_allowed);
+  kprintf("Packets denied: %d\n", (int)fw_stats.packets_denied);
+
+  /* Rules that have actually fired */
+  int shown = 0;
+  for (int i = 0; i < FW_HASH_SIZE && shown < 10; i++) {
+    if (fw_blocked[i].ip == 0 || fw_blocked[i].hits == 0)
+      continue;
+    uint32_t ip = fw_blocked[i].ip;
+    kprintf("  %d.%d.%d.%d: %d hits\n", (ip >> 24) & 0xFF, (ip >> 16) & 0xFF,
+            (ip >> 8) & 0xFF, ip & 0xFF, (int)fw_blocked[i].hits);
+    shown++;
+  }
+}
+
+void firewall_enable(int enable) { firewall_enabled = enable; }
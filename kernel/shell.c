@@ -50,6 +50,12 @@ static cmd_t commands[] = {
     /* System Info */
     {"sysinfo", "System info", cmd_sysinfo},
     {"ps", "Process list", cmd_ps},
+    {"top", "Live CPU usage", cmd_top},
+    {"profile", "CPU profiler", cmd_profile},
+    {"bench", "Microbenchmarks", cmd_bench},
+    {"ktrace", "Kernel tracepoints", cmd_ktrace},
+    {"bootchart", "Boot stage timings", cmd_bootchart},
+    {"irqstat", "Interrupt statistics", cmd_irqstat},
     {"uptime", "Show uptime", cmd_uptime},
     {"date", "Date/time", cmd_date_rtc},
     {"time", "Show time", cmd_time},
@@ -108,7 +114,9 @@ static cmd_t commands[] = {
     {"secmon", "Security mon", cmd_secmon},
     {"logs", "Security logs", cmd_logs},
     {"audit", "Audit log", cmd_audit},
+    {"bcache", "Block cache stats", cmd_bcache},
     {"memory", "Memory usage", cmd_memory},
+    {"memtop", "Heap usage by caller", cmd_memtop},
     {"dmesg", "Kernel messages", cmd_dmesg},
 
     /* Network */
@@ -121,6 +129,66 @@ static cmd_t commands[] = {
 
     {NULL, NULL, NULL}};
 
+/*
+ * Command registry: an open-addressing hash over the table above,
+ * built lazily on first dispatch. Every entry point that resolves a
+ * command name (shell, pipelines, nash scripts) funnels through
+ * cmd_lookup, so dispatch is one hash plus a probe or two instead of
+ * a linear scan of the whole table.
+ */
+#define CMD_HASH_SIZE 256 /* Power of two, > 2x the command count */
+
+static int16_t cmd_hash[CMD_HASH_SIZE];
+static int cmd_hash_ready = 0;
+static int cmd_count = 0;
+
+static uint32_t cmd_name_hash(const char *name) {
+  uint32_t hash = 5381;
+  while (*name) {
+    hash = ((hash << 5) + hash) + (uint8_t)*name++; /* djb2 */
+  }
+  return hash & (CMD_HASH_SIZE - 1);
+}
+
+static void cmd_hash_build(void) {
+  for (int i = 0; i < CMD_HASH_SIZE; i++)
+    cmd_hash[i] = -1;
+  for (int i = 0; commands[i].name; i++) {
+    uint32_t slot = cmd_name_hash(commands[i].name);
+    while (cmd_hash[slot] >= 0)
+      slot = (slot + 1) & (CMD_HASH_SIZE - 1);
+    cmd_hash[slot] = (int16_t)i;
+    cmd_count = i + 1;
+  }
+  cmd_hash_ready = 1;
+}
+
+/* Registry accessors for tab completion (complete.c) */
+int shell_cmd_count(void) {
+  if (!cmd_hash_ready)
+    cmd_hash_build();
+  return cmd_count;
+}
+
+const char *shell_cmd_name(int idx) {
+  if (idx < 0 || idx >= cmd_count)
+    return NULL;
+  return commands[idx].name;
+}
+
+static const cmd_t *cmd_lookup(const char *name) {
+  if (!cmd_hash_ready)
+    cmd_hash_build();
+  uint32_t slot = cmd_name_hash(name);
+  while (cmd_hash[slot] >= 0) {
+    const cmd_t *c = &commands[cmd_hash[slot]];
+    if (strcmp(name, c->name) == 0)
+      return c;
+    slot = (slot + 1) & (CMD_HASH_SIZE - 1);
+  }
+  return NULL;
+}
+
 static void parse_cmd(const char *in, char *cmd, char *args) {
   while (*in == ' ')
     in++;
@@ -157,11 +225,10 @@ void shell_execute_simple(const char *input) {
   if (cmd[0] == '\0')
     return;
 
-  for (int i = 0; commands[i].name; i++) {
-    if (strcmp(cmd, commands[i].name) == 0) {
-      commands[i].handler(args);
-      return;
-    }
+  const cmd_t *c = cmd_lookup(cmd);
+  if (c) {
+    c->handler(args);
+    return;
   }
 
   kprintf_color("Unknown: ", VGA_COLOR_RED);
@@ -185,8 +252,23 @@ void shell_execute(const char *input) {
 
 /* === Command Implementations === */
 
+/* One padded help column: name and description */
+static void help_entry(const cmd_t *c) {
+  kprintf("  %s", c->name);
+  for (int pad = (int)strlen(c->name); pad < 10; pad++)
+    kprintf(" ");
+  kprintf("%s", c->desc);
+  for (int pad = (int)strlen(c->desc); pad < 22; pad++)
+    kprintf(" ");
+}
+
+/* Generated straight from the command registry, so new commands show
+ * up here without a second list to maintain */
 static void cmd_help(const char *a) {
   (void)a;
+  if (!cmd_hash_ready)
+    cmd_hash_build();
+
   kprintf("\n");
   kprintf_color("═══════════════════════════════════════════\n",
                 VGA_COLOR_CYAN);
@@ -195,31 +277,13 @@ static void cmd_help(const char *a) {
   kprintf_color("═══════════════════════════════════════════\n\n",
                 VGA_COLOR_CYAN);
 
-  kprintf_color("General:\n", VGA_COLOR_YELLOW);
-  kprintf("  help status clear version halt reboot\n\n");
-
-  kprintf_color("User:\n", VGA_COLOR_YELLOW);
-  kprintf("  login logout whoami id su sudo lock\n");
-  kprintf("  adduser deluser passwd users\n\n");
-
-  kprintf_color("System:\n", VGA_COLOR_YELLOW);
-  kprintf("  sysinfo ps uptime date time cal uname\n\n");
-
-  kprintf_color("Files:\n", VGA_COLOR_YELLOW);
-  kprintf("  ls cat touch rm cp mv pwd nedit\n");
-  kprintf("  head tail wc grep chmod chown\n\n");
-
-  kprintf_color("Environment:\n", VGA_COLOR_YELLOW);
-  kprintf("  export env unset history alias\n\n");
-
-  kprintf_color("Sound:\n", VGA_COLOR_YELLOW);
-  kprintf("  beep play\n\n");
-
-  kprintf_color("Security:\n", VGA_COLOR_YELLOW);
-  kprintf("  firewall secmon logs audit memory\n\n");
-
-  kprintf_color("Network:\n", VGA_COLOR_YELLOW);
-  kprintf("  nifconfig nroute nnetstat nping narp\n\n");
+  for (int i = 0; i < cmd_count; i += 2) {
+    help_entry(&commands[i]);
+    if (i + 1 < cmd_count)
+      help_entry(&commands[i + 1]);
+    kprintf("\n");
+  }
+  kprintf("\n%d commands. Shift-PgUp/PgDn scrolls.\n\n", cmd_count);
 }
 
 static void cmd_status(const char *a) {
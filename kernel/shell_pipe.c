@@ -6,12 +6,70 @@
 
 #include "kernel.h"
 
-/* Output buffer for piping */
-#define PIPE_BUF_SIZE 4096
-static char pipe_buffer[PIPE_BUF_SIZE];
-static int pipe_buffer_len = 0;
+/*
+ * All transient buffers (command copies, captured stage output,
+ * redirect staging) come from a shared arena that is reset in one
+ * step when the outermost invocation finishes, so a whole pipeline
+ * costs the heap a single allocation.
+ */
+#define SHELL_ARENA_SIZE 65536
+
+static arena_t shell_arena;
+static int shell_arena_depth = 0;
+
+/*
+ * Captured output for piping. Each capture gets its own buffer from
+ * the arena, grown by doubling as output arrives, and is handed to
+ * the downstream stage by pointer - the arena keeps every stage's
+ * buffer alive until the whole pipeline finishes, so nothing is
+ * copied between stages. The static buffer is a fixed-size fallback
+ * for when the arena is unavailable.
+ */
+#define PIPE_CHUNK 1024
+#define PIPE_FALLBACK_SIZE 4096
+
+static char pipe_fallback[PIPE_FALLBACK_SIZE];
+
+typedef struct {
+  char *data;
+  int len;
+  int cap;      /* Allocated size; len + terminator stay below it */
+  int in_arena; /* Growable only when carved from the arena */
+} pipe_buf_t;
+
+static pipe_buf_t pipe_cur = {pipe_fallback, 0, PIPE_FALLBACK_SIZE, 0};
 static int pipe_mode = 0; /* 0=normal, 1=capturing output */
 
+/*
+ * Grow the current capture to hold at least need bytes. When the
+ * buffer is still the last arena allocation it is extended in place;
+ * otherwise a doubled block is allocated and the bytes move once.
+ */
+static int pipe_grow(int need) {
+  if (!pipe_cur.in_arena)
+    return -1;
+
+  int newcap = pipe_cur.cap * 2;
+  while (newcap < need)
+    newcap *= 2;
+
+  if ((uint8_t *)pipe_cur.data + pipe_cur.cap ==
+      shell_arena.base + shell_arena.used) {
+    if (arena_alloc(&shell_arena, newcap - pipe_cur.cap)) {
+      pipe_cur.cap = newcap;
+      return 0;
+    }
+  }
+
+  char *nb = (char *)arena_alloc(&shell_arena, newcap);
+  if (!nb)
+    return -1;
+  memcpy(nb, pipe_cur.data, pipe_cur.len + 1);
+  pipe_cur.data = nb;
+  pipe_cur.cap = newcap;
+  return 0;
+}
+
 /* Redirect mode */
 static int redirect_mode = 0; /* 0=none, 1=write, 2=append */
 static char redirect_file[64];
@@ -41,43 +99,44 @@ static int pipe_atoi(const char *s) {
 }
 
 /*
- * Simple strstr implementation
- */
-static char *pipe_strstr(const char *haystack, const char *needle) {
-  if (!*needle)
-    return (char *)haystack;
-  for (; *haystack; haystack++) {
-    const char *h = haystack;
-    const char *n = needle;
-    while (*h && *n && *h == *n) {
-      h++;
-      n++;
-    }
-    if (!*n)
-      return (char *)haystack;
-  }
-  return NULL;
-}
-
-/*
- * Capture output to pipe buffer instead of screen
+ * Capture output to a fresh per-stage buffer instead of the screen
  */
 void pipe_capture_start(void) {
   pipe_mode = 1;
-  pipe_buffer_len = 0;
-  pipe_buffer[0] = '\0';
+  pipe_cur.len = 0;
+  pipe_cur.data = (char *)arena_alloc(&shell_arena, PIPE_CHUNK);
+  if (pipe_cur.data) {
+    pipe_cur.cap = PIPE_CHUNK;
+    pipe_cur.in_arena = 1;
+  } else {
+    pipe_cur.data = pipe_fallback;
+    pipe_cur.cap = PIPE_FALLBACK_SIZE;
+    pipe_cur.in_arena = 0;
+  }
+  pipe_cur.data[0] = '\0';
 }
 
 void pipe_capture_end(void) { pipe_mode = 0; }
 
-void pipe_write_char(char c) {
-  if (pipe_buffer_len < PIPE_BUF_SIZE - 1) {
-    pipe_buffer[pipe_buffer_len++] = c;
-    pipe_buffer[pipe_buffer_len] = '\0';
+/* Bulk append - the vga_write path lands here, one call per message */
+void pipe_capture_write(const char *buf, size_t len) {
+  if (pipe_cur.len + (int)len + 1 > pipe_cur.cap) {
+    if (pipe_grow(pipe_cur.len + (int)len + 1) < 0) {
+      /* Fallback buffer cannot grow - truncate like the old one did */
+      int room = pipe_cur.cap - pipe_cur.len - 1;
+      if (room <= 0)
+        return;
+      len = (size_t)room;
+    }
   }
+  memcpy(pipe_cur.data + pipe_cur.len, buf, len);
+  pipe_cur.len += (int)len;
+  pipe_cur.data[pipe_cur.len] = '\0';
 }
 
-const char *pipe_get_buffer(void) { return pipe_buffer; }
+void pipe_write_char(char c) { pipe_capture_write(&c, 1); }
+
+const char *pipe_get_buffer(void) { return pipe_cur.data; }
 
 int pipe_is_active(void) { return pipe_mode; }
 
@@ -249,8 +308,10 @@ static int execute_with_pipe_input(const char *cmd, const char *input) {
   }
 
   if (strcmp(command, "grep") == 0) {
-    /* Simple grep on piped input */
-    const char *pattern = args;
+    /* Grep on piped input: compile the pattern once, Horspool-search
+     * each line in place */
+    strsearch_t search;
+    strsearch_compile(&search, args);
     const char *line_start = input;
 
     while (*line_start) {
@@ -258,16 +319,13 @@ static int execute_with_pipe_input(const char *cmd, const char *input) {
       while (*line_end && *line_end != '\n')
         line_end++;
 
-      /* Check if pattern in line */
-      char line[256];
       int len = line_end - line_start;
-      if (len > 255)
-        len = 255;
-      memcpy(line, line_start, len);
-      line[len] = '\0';
-
-      /* Simple substring search */
-      if (pattern[0] && pipe_strstr(line, pattern)) {
+      if (args[0] && strsearch_find(&search, line_start, len)) {
+        char line[256];
+        if (len > 255)
+          len = 255;
+        memcpy(line, line_start, len);
+        line[len] = '\0';
         kprintf("%s\n", line);
       }
 
@@ -389,7 +447,21 @@ static int execute_with_pipe_input(const char *cmd, const char *input) {
  * Main shell execute with full operator support
  */
 void shell_execute_advanced(const char *input) {
-  char cmdline[512];
+  if (!shell_arena.base && arena_create(&shell_arena, SHELL_ARENA_SIZE) < 0) {
+    shell_execute_simple(input);
+    return;
+  }
+  shell_arena_depth++;
+
+  char *cmdline = (char *)arena_alloc(&shell_arena, 512);
+  char *left = (char *)arena_alloc(&shell_arena, 256);
+  char *right = (char *)arena_alloc(&shell_arena, 256);
+  if (!cmdline || !left || !right) {
+    /* Arena exhausted (deep chain) - run without operator support */
+    shell_execute_simple(input);
+    goto out;
+  }
+
   strncpy(cmdline, input, 511);
   cmdline[511] = '\0';
 
@@ -399,11 +471,10 @@ void shell_execute_advanced(const char *input) {
   if (op == 0) {
     /* Simple command */
     shell_execute_simple(cmdline);
-    return;
+    goto out;
   }
 
   /* Split at operator */
-  char left[256], right[256];
   memcpy(left, cmdline, pos);
   left[pos] = '\0';
 
@@ -425,31 +496,30 @@ void shell_execute_advanced(const char *input) {
     pipe_capture_start();
     shell_execute_simple(left);
     pipe_capture_end();
-    fs_write(right, pipe_get_buffer(), pipe_buffer_len);
+    fs_write(right, pipe_get_buffer(), pipe_cur.len);
     break;
 
   case 3: /* Append: cmd >> file */
   {
-    char existing[4096] = "";
-    int existing_len = fs_read(right, existing, 4095);
-    if (existing_len < 0)
-      existing_len = 0;
-
     pipe_capture_start();
     shell_execute_simple(left);
     pipe_capture_end();
 
-    /* Append new content */
-    if (existing_len + pipe_buffer_len < 4095) {
-      memcpy(existing + existing_len, pipe_buffer, pipe_buffer_len);
-      existing_len += pipe_buffer_len;
+    /* Append only the new bytes; no full-file copy */
+    int fd = fs_open(right, FS_O_CREATE);
+    if (fd < 0) {
+      kprintf("Cannot write: %s\n", right);
+      break;
     }
-    fs_write(right, existing, existing_len);
+    fs_append(fd, pipe_get_buffer(), pipe_cur.len);
+    fs_close(fd);
   } break;
 
   case 4: /* Input: cmd < file */
   {
-    char file_content[4096];
+    char *file_content = (char *)arena_alloc(&shell_arena, 4096);
+    if (!file_content)
+      break;
     int len = fs_read(right, file_content, 4095);
     if (len >= 0) {
       file_content[len] = '\0';
@@ -475,4 +545,8 @@ void shell_execute_advanced(const char *input) {
     shell_execute_advanced(right);
     break;
   }
+
+out:
+  if (--shell_arena_depth == 0)
+    arena_reset(&shell_arena);
 }
@@ -0,0 +1,56 @@
+/*
+ * NanoSec OS - String Search Engine
+ * ===================================
+ * Boyer-Moore-Horspool substring search shared by grep, find, sed
+ * and the pipe filter. The pattern is compiled once into a 256-entry
+ * skip table; the search then advances by up to the pattern length
+ * per comparison instead of one byte at a time.
+ */
+
+#include "kernel.h"
+
+/*
+ * Compile a pattern: skip[c] is how far the search window can slide
+ * when the last byte of the window is c
+ */
+void strsearch_compile(strsearch_t *s, const char *pattern) {
+  s->pattern = pattern;
+  s->len = strlen(pattern);
+
+  for (int i = 0; i < 256; i++) {
+    s->skip[i] = s->len;
+  }
+  for (int i = 0; i < s->len - 1; i++) {
+    s->skip[(uint8_t)s->pattern[i]] = s->len - 1 - i;
+  }
+}
+
+/*
+ * Find the first occurrence of the compiled pattern in text[0..n).
+ * Returns a pointer to the match, or NULL.
+ */
+const char *strsearch_find(const strsearch_t *s, const char *text, int n) {
+  int m = s->len;
+  if (m == 0)
+    return text;
+
+  int i = 0;
+  while (i <= n - m) {
+    uint8_t last = (uint8_t)text[i + m - 1];
+    if (last == (uint8_t)s->pattern[m - 1] &&
+        memcmp(text + i, s->pattern, m) == 0) {
+      return text + i;
+    }
+    i += s->skip[last];
+  }
+  return NULL;
+}
+
+/*
+ * One-shot convenience for NUL-terminated strings
+ */
+const char *strsearch_strstr(const char *haystack, const char *needle) {
+  strsearch_t s;
+  strsearch_compile(&s, needle);
+  return strsearch_find(&s, haystack, strlen(haystack));
+}
@@ -25,6 +25,7 @@ typedef struct {
   int has_mmx;
   int has_sse;
   int has_sse2;
+  int has_sep;
 } cpu_info_t;
 
 static cpu_info_t cpu_info;
@@ -52,6 +53,10 @@ void cpu_detect(void) {
   cpu_info.has_mmx = (edx >> 23) & 1;
   cpu_info.has_sse = (edx >> 25) & 1;
   cpu_info.has_sse2 = (edx >> 26) & 1;
+  cpu_info.has_sep = (edx >> 11) & 1;
+
+  /* Let the memory copy routines pick their SSE2 fast path. */
+  mm_set_sse2(cpu_info.has_sse2);
 
   /* Get brand string if available */
   cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
@@ -79,6 +84,11 @@ void cpu_detect(void) {
   }
 }
 
+/*
+ * SYSENTER/SYSEXIT support (for the fast syscall path)
+ */
+int cpu_has_sep(void) { return cpu_info.has_sep; }
+
 /*
  * Print system information
  */
@@ -113,6 +123,8 @@ void cmd_sysinfo(const char *args) {
     kprintf("SSE ");
   if (cpu_info.has_sse2)
     kprintf("SSE2 ");
+  if (cpu_info.has_sep)
+    kprintf("SEP ");
   kprintf("\n\n");
 
   /* Memory Info */
@@ -0,0 +1,83 @@
+/*
+ * NanoSec OS - Shared Variable Table
+ * ====================================
+ * Open-addressing hash table for name=value pairs, backing both the
+ * shell environment (env.c) and Nash script variables. Lookup is one
+ * hash plus a probe or two instead of a strcmp against every entry.
+ * Callers own the slot storage; deleted entries leave tombstones so
+ * probe chains stay intact. The generation counter bumps on every
+ * mutation, letting callers cache derived data until a variable
+ * actually changes.
+ */
+
+#include "kernel.h"
+
+static uint32_t vartab_name_hash(const char *name) {
+  uint32_t hash = 5381;
+  while (*name) {
+    hash = ((hash << 5) + hash) + (uint8_t)*name++; /* djb2 */
+  }
+  return hash;
+}
+
+void vartab_init(vartab_t *t, vartab_entry_t *slots, int cap) {
+  t->slots = slots;
+  t->cap = cap;
+  t->count = 0;
+  t->gen++;
+  memset(slots, 0, (size_t)cap * sizeof(vartab_entry_t));
+}
+
+/* Find the entry for name, or NULL. Probes stop at the first truly
+ * empty slot; tombstones are walked through. */
+static vartab_entry_t *vartab_find(vartab_t *t, const char *name) {
+  uint32_t slot = vartab_name_hash(name) & (uint32_t)(t->cap - 1);
+  for (int probes = 0; probes < t->cap; probes++) {
+    vartab_entry_t *e = &t->slots[slot];
+    if (e->state == VARTAB_EMPTY)
+      return NULL;
+    if (e->state == VARTAB_USED && strcmp(e->name, name) == 0)
+      return e;
+    slot = (slot + 1) & (uint32_t)(t->cap - 1);
+  }
+  return NULL;
+}
+
+int vartab_set(vartab_t *t, const char *name, const char *value) {
+  vartab_entry_t *e = vartab_find(t, name);
+
+  if (!e) {
+    /* Keep load below half capacity so probes stay short */
+    if (t->count >= t->cap / 2)
+      return -1;
+
+    uint32_t slot = vartab_name_hash(name) & (uint32_t)(t->cap - 1);
+    while (t->slots[slot].state == VARTAB_USED)
+      slot = (slot + 1) & (uint32_t)(t->cap - 1);
+    e = &t->slots[slot];
+    strncpy(e->name, name, VARTAB_NAME - 1);
+    e->name[VARTAB_NAME - 1] = '\0';
+    e->state = VARTAB_USED;
+    t->count++;
+  }
+
+  strncpy(e->value, value, VARTAB_VALUE - 1);
+  e->value[VARTAB_VALUE - 1] = '\0';
+  t->gen++;
+  return 0;
+}
+
+const char *vartab_get(vartab_t *t, const char *name) {
+  vartab_entry_t *e = vartab_find(t, name);
+  return e ? e->value : NULL;
+}
+
+int vartab_unset(vartab_t *t, const char *name) {
+  vartab_entry_t *e = vartab_find(t, name);
+  if (!e)
+    return -1;
+  e->state = VARTAB_TOMB;
+  t->count--;
+  t->gen++;
+  return 0;
+}